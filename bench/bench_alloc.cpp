@@ -0,0 +1,124 @@
+// Measures heap allocations and time per game reset and per move played.
+//
+// Usage: bench_alloc [config.json] [games]
+//
+// Global operator new is replaced so that every heap allocation in the
+// process is counted. After the warm-up game has sized the arena, resetting
+// a game through GameManager::initializeGame should make zero allocations,
+// and so should playing moves through GameManager::processMove.
+#include "../include/ConfigReader.hpp"
+#include "../include/GameManager.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <random>
+#include <string>
+
+namespace {
+    std::size_t g_allocations = 0;
+}
+
+void* operator new(std::size_t size) {
+    g_allocations++;
+    if (void* p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment) {
+    g_allocations++;
+    std::size_t align = static_cast<std::size_t>(alignment);
+    if (void* p = std::aligned_alloc(align, (size + align - 1) / align * align)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+
+int main(int argc, char* argv[]) {
+    std::string configPath = argc > 1 ? argv[1] : "data/chess_pieces.json";
+    int games = argc > 2 ? std::stoi(argv[2]) : 100000;
+
+    ConfigReader configReader;
+    if (!configReader.loadFromFile(configPath)) {
+        std::cerr << "Failed to load configuration. Exiting." << std::endl;
+        return 1;
+    }
+
+    GameManager gameManager(configReader.getConfig());
+
+    // Warm-up: the first game sizes the arena
+    std::size_t before = g_allocations;
+    gameManager.initializeGame();
+    std::size_t warmup = g_allocations - before;
+    gameManager.initializeGame();
+
+    before = g_allocations;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < games; ++i) {
+        gameManager.initializeGame();
+    }
+    auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::size_t steady = g_allocations - before;
+
+    GameArena::Stats stats = gameManager.getArenaStats();
+    std::cout << "Warm-up game allocations:  " << warmup << std::endl;
+    std::cout << "Steady-state allocations:  " << steady << " over " << games << " games ("
+              << static_cast<double>(steady) / games << " per game)" << std::endl;
+    std::cout << "Arena buffer:              " << stats.bufferSize << " bytes, "
+              << stats.upstreamAllocations << " overflow allocations, "
+              << stats.releases << " releases" << std::endl;
+    std::cout << "Reset time:                " << elapsed * 1e9 / games << " ns per game" << std::endl;
+
+    // Random legal games; only processMove itself is counted and timed
+    if (gameManager.getRules() == nullptr) {
+        return steady == 0 ? 0 : 1;
+    }
+    const RuleSet& rules = *gameManager.getRules();
+    MoveGenerator generator(rules);
+    auto attacks = std::make_unique<AttackMap>(rules);
+    auto moves = std::make_unique<MoveList>();
+    std::mt19937 rng(7);
+    int moveGames = std::max(1, games / 100);
+    std::size_t moveAllocations = 0;
+    std::size_t played = 0;
+    double moveSeconds = 0;
+    for (int i = 0; i <= moveGames; ++i) {
+        gameManager.initializeGame();
+        while (!gameManager.isGameOver()) {
+            GameState state = gameManager.getState();
+            attacks->build(state);
+            generator.generateLegal(state, *attacks, *moves);
+            Move move = generator.toMove(moves->moves[rng() % moves->count]);
+
+            before = g_allocations;
+            auto moveStart = std::chrono::steady_clock::now();
+            bool ok = gameManager.processMove(move);
+            auto moveTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - moveStart).count();
+            if (!ok) {
+                std::cerr << "Legal move rejected" << std::endl;
+                return 1;
+            }
+            // The first game is the warm-up for the history and cooldown log
+            if (i > 0) {
+                moveAllocations += g_allocations - before;
+                moveSeconds += moveTime;
+                played++;
+            }
+        }
+    }
+    std::cout << "Move allocations:          " << moveAllocations << " over " << played << " moves in "
+              << moveGames << " games" << std::endl;
+    std::cout << "Move time:                 " << moveSeconds * 1e9 / static_cast<double>(played)
+              << " ns per processMove" << std::endl;
+
+    return steady == 0 && moveAllocations == 0 ? 0 : 1;
+}
@@ -0,0 +1,161 @@
+// Boards drawn per second by the old per-square stream output and by
+// BoardRenderer, with heap allocations and stream flushes per board.
+//
+// Usage: bench_board_render [config.json] [boards]
+//
+// Output goes to a stream buffer that drops the text (counting flushes) and
+// to /dev/null through a file stream, where every flush is a write call as
+// it would be for a terminal or a socket. Global operator new is replaced to
+// count allocations.
+#include "../include/BoardRenderer.hpp"
+#include "../include/ConfigReader.hpp"
+#include "../include/GameManager.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <new>
+#include <ostream>
+#include <sstream>
+#include <streambuf>
+#include <string>
+
+namespace {
+    std::size_t g_allocations = 0;
+
+    // Drops everything written to it, counting flushes
+    class NullBuffer : public std::streambuf {
+    public:
+        std::size_t flushes = 0;
+
+    protected:
+        int overflow(int c) override { return c; }
+        std::streamsize xsputn(const char*, std::streamsize count) override { return count; }
+        int sync() override {
+            flushes++;
+            return 0;
+        }
+    };
+
+    // ChessBoard::displayBoard before BoardRenderer: std::endl after every
+    // line and a std::string per piece (what getSymbol used to return)
+    void legacyDisplay(const ChessBoard& board, std::ostream& os) {
+        int size = board.getSize();
+        os << std::endl;
+        os << "  ";
+        for (int i = 0; i < size; ++i) {
+            os << " " << static_cast<char>('A' + i) << "  ";
+        }
+        os << std::endl;
+        os << "  +-";
+        for (int i = 0; i < size; ++i) {
+            os << "----+";
+        }
+        os << std::endl;
+        for (int y = size - 1; y >= 0; --y) {
+            os << y + 1 << " | ";
+            for (int x = 0; x < size; ++x) {
+                const ChessPiece* piece = board.getPieceAt({x, y});
+                if (piece) {
+                    os << std::string(piece->getSymbol()) << " | ";
+                } else {
+                    os << ((x + y) % 2 == 0 ? "·" : " ") << " | ";
+                }
+            }
+            os << y + 1 << std::endl;
+            os << "  +-";
+            for (int i = 0; i < size; ++i) {
+                os << "----+";
+            }
+            os << std::endl;
+        }
+        os << "  ";
+        for (int i = 0; i < size; ++i) {
+            os << " " << static_cast<char>('A' + i) << "  ";
+        }
+        os << std::endl << std::endl;
+    }
+
+    void measure(const char* name, int boards, const std::function<void()>& drawOne, const NullBuffer* buffer) {
+        drawOne();
+        std::size_t flushesBefore = buffer ? buffer->flushes : 0;
+        std::size_t before = g_allocations;
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < boards; ++i) {
+            drawOne();
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        double allocations = static_cast<double>(g_allocations - before) / boards;
+        std::printf("%-34s %10.0f boards/s %8.1f ns/board %6.1f allocations/board", name, boards / seconds,
+                    seconds * 1e9 / boards, allocations);
+        if (buffer) {
+            std::printf(" %5.1f flushes/board", static_cast<double>(buffer->flushes - flushesBefore) / boards);
+        }
+        std::printf("\n");
+    }
+}
+
+void* operator new(std::size_t size) {
+    g_allocations++;
+    if (void* p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+int main(int argc, char* argv[]) {
+    std::string configPath = argc > 1 ? argv[1] : "data/chess_pieces.json";
+    int boards = argc > 2 ? std::stoi(argv[2]) : 200000;
+
+    ConfigReader configReader;
+    if (!configReader.loadFromFile(configPath)) {
+        std::cerr << "Failed to load configuration. Exiting." << std::endl;
+        return 1;
+    }
+    GameManager gameManager(configReader.getConfig());
+    gameManager.initializeGame();
+    const ChessBoard& board = gameManager.getBoard();
+
+    // The renderer must draw exactly what displayBoard used to
+    std::ostringstream legacyText;
+    std::ostringstream rendererText;
+    legacyDisplay(board, legacyText);
+    board.displayBoard(rendererText);
+    bool identical = legacyText.str() == rendererText.str();
+    std::printf("%d boards of %dx%d, displayBoard output %s the old one (%zu bytes)\n", boards, board.getSize(),
+                board.getSize(), identical ? "matches" : "DIFFERS FROM", legacyText.str().size());
+
+    NullBuffer nullBuffer;
+    std::ostream null(&nullBuffer);
+    std::ofstream devNull("/dev/null");
+    BoardRenderer renderer;
+    std::size_t bytes = 0;
+
+    measure("old displayBoard, null stream", boards, [&] { legacyDisplay(board, null); }, &nullBuffer);
+    measure("old displayBoard, /dev/null", boards, [&] { legacyDisplay(board, devNull); }, nullptr);
+    measure("displayBoard, null stream", boards, [&] { board.displayBoard(null); }, &nullBuffer);
+    measure("displayBoard, /dev/null + flush", boards, [&] { board.displayBoard(devNull); devNull.flush(); },
+            nullptr);
+    for (BoardStyle style : {BoardStyle::Unicode, BoardStyle::Ascii, BoardStyle::Compact}) {
+        renderer.setStyle(style);
+        const char* name = style == BoardStyle::Unicode ? "render Unicode"
+                           : style == BoardStyle::Ascii ? "render ASCII"
+                                                        : "render compact";
+        measure(name, boards, [&] { bytes += renderer.render(board).size(); }, nullptr);
+    }
+    if (const RuleSet* rules = gameManager.getRules()) {
+        renderer.setStyle(BoardStyle::Unicode);
+        measure("render Unicode from GameState", boards,
+                [&] { bytes += renderer.render(*rules, gameManager.getState()).size(); }, nullptr);
+    }
+
+    renderer.setStyle(BoardStyle::Compact);
+    std::cout << "\nCompact:\n" << renderer.render(board);
+    renderer.setStyle(BoardStyle::Ascii);
+    std::cout << "ASCII:\n" << renderer.render(board) << std::flush;
+    return bytes == 0 || !identical;
+}
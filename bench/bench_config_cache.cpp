@@ -0,0 +1,76 @@
+// Cost of starting games from JSON text with and without the config cache.
+//
+// Usage: bench_config_cache [config.json] [games] [variants]
+//
+// The games cycle through a few variants of the config (differing only in
+// their name), as a server does when most games use a handful of variants.
+#include "../include/ConfigCache.hpp"
+#include "../include/GameManager.hpp"
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+int main(int argc, char* argv[]) {
+    std::string configPath = argc > 1 ? argv[1] : "data/chess_pieces.json";
+    int games = argc > 2 ? std::stoi(argv[2]) : 2000;
+    int variantCount = argc > 3 ? std::stoi(argv[3]) : 4;
+
+    std::ifstream file(configPath);
+    std::string base((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    auto nameAt = base.find("\"name\"");
+    if (nameAt == std::string::npos) {
+        std::cerr << "Config has no game name to vary" << std::endl;
+        return 1;
+    }
+    auto valueAt = base.find('"', base.find(':', nameAt)) + 1;
+    std::vector<std::string> variants;
+    for (int i = 0; i < variantCount; ++i) {
+        std::string text = base;
+        text.insert(valueAt, "Variant " + std::to_string(i) + " ");
+        variants.push_back(text);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    for (int game = 0; game < games; ++game) {
+        ConfigReader reader;
+        if (!reader.loadFromString(variants[game % variantCount])) {
+            return 1;
+        }
+        GameManager manager(reader.getConfig());
+        manager.initializeGame();
+    }
+    double uncached = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+    ConfigCache cache;
+    start = std::chrono::steady_clock::now();
+    for (int game = 0; game < games; ++game) {
+        auto compiled = cache.get(variants[game % variantCount]);
+        if (!compiled) {
+            return 1;
+        }
+        GameManager manager(compiled);
+        manager.initializeGame();
+    }
+    double cached = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    ConfigCache::Stats stats = cache.getStats();
+
+    std::printf("Uncached  %8.1f us/game\n", uncached / games);
+    std::printf("Cached    %8.1f us/game  (%llu hits, %llu misses, %zu entries, %.1f KB)\n", cached / games,
+                static_cast<unsigned long long>(stats.hits), static_cast<unsigned long long>(stats.misses),
+                stats.entries, stats.bytes / 1024.0);
+
+    // With room for only two entries, cycling through more variants evicts
+    cache.clear();
+    cache.setCapacity(stats.bytes / stats.entries * 2);
+    for (int game = 0; game < variantCount * 2; ++game) {
+        cache.get(variants[game % variantCount]);
+    }
+    stats = cache.getStats();
+    std::printf("Capped    %zu entries, %llu evictions\n", stats.entries,
+                static_cast<unsigned long long>(stats.evictions));
+    return 0;
+}
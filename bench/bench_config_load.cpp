@@ -0,0 +1,67 @@
+// Startup cost of getting a ready-to-use config: JSON parse plus rule
+// compilation, against opening a precompiled config image.
+//
+// Usage: bench_config_load [config.json] [iterations]
+#include "../include/ConfigImage.hpp"
+#include "../include/ConfigReader.hpp"
+#include "../include/RuleSet.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+namespace {
+    template <typename Load>
+    double averageMicros(int iterations, Load load) {
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; ++i) {
+            if (!load()) {
+                return -1;
+            }
+        }
+        return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() /
+               iterations;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    std::string configPath = argc > 1 ? argv[1] : "data/chess_pieces.json";
+    int iterations = argc > 2 ? std::stoi(argv[2]) : 200;
+    std::string imagePath = "/tmp/bench_config_load.img";
+
+    ConfigReader source;
+    if (!source.loadFromFile(configPath)) {
+        return 1;
+    }
+    auto compiled = RuleSet::compile(source.getConfig());
+    if (!compiled || !ConfigImage::write(imagePath, source.getConfig(), *compiled)) {
+        return 1;
+    }
+
+    double jsonMicros = averageMicros(iterations, [&] {
+        ConfigReader reader;
+        return reader.loadFromFile(configPath) && RuleSet::compile(reader.getConfig()) != nullptr;
+    });
+    double mapMicros = averageMicros(iterations, [&] {
+        return ConfigImage::open(imagePath) != nullptr;
+    });
+    double imageMicros = averageMicros(iterations, [&] {
+        ConfigReader reader;
+        return reader.loadFromImage(imagePath) && reader.getRuleSet() != nullptr;
+    });
+
+    // The image must carry exactly the rules the JSON compiles to
+    ConfigReader check;
+    bool same = check.loadFromImage(imagePath) &&
+                std::memcmp(check.getRuleSet().get(), compiled.get(), sizeof(RuleSet)) == 0 &&
+                check.getConfig().pieces.size() == source.getConfig().pieces.size() &&
+                check.getConfig().portals.size() == source.getConfig().portals.size();
+
+    std::printf("JSON parse + compile      %9.1f us\n", jsonMicros);
+    std::printf("Image map + verify        %9.1f us\n", mapMicros);
+    std::printf("Image load (with config)  %9.1f us\n", imageMicros);
+    std::printf("Rules %s\n", same ? "identical" : "DIFFER");
+    std::remove(imagePath.c_str());
+    return same ? 0 : 1;
+}
@@ -0,0 +1,268 @@
+// Parse time and peak memory of the DOM and SAX config loaders on a large
+// variant catalog (a JSON array of configs).
+//
+// Usage: bench_config_parse [catalog.json] [megabytes]
+//
+// The catalog is generated first if the file does not exist. Each loader runs
+// in its own child process so that its peak RSS is measured in isolation.
+// Both loaders must produce the same configs, which is checked by comparing a
+// fingerprint of every variant.
+#include "../include/ConfigReader.hpp"
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+    const char* kPieceNames[] = {"King", "Queen", "Rook", "Bishop", "Knight", "Pawn"};
+    const char* kCustomNames[] = {"Wizard", "Archer", "Dragon", "Jester", "Golem"};
+    const char* kCustomAbilities[] = {"teleport", "portal_master", "ranged", "fly"};
+
+    // Random free square, marked as taken (configs with overlaps are invalid)
+    int takeSquare(std::mt19937& rng, std::vector<bool>& taken) {
+        int square;
+        do {
+            square = static_cast<int>(rng() % taken.size());
+        } while (taken[square]);
+        taken[square] = true;
+        return square;
+    }
+
+    void writePositions(std::FILE* out, std::mt19937& rng, int size, int count, std::vector<bool>& taken) {
+        std::fprintf(out, "      \"positions\": {\n");
+        const char* colors[] = {"white", "black"};
+        for (int c = 0; c < 2; ++c) {
+            std::fprintf(out, "        \"%s\": [\n", colors[c]);
+            for (int i = 0; i < count; ++i) {
+                int square = takeSquare(rng, taken);
+                std::fprintf(out, "          { \"x\": %d, \"y\": %d }%s\n", square % size, square / size,
+                             i + 1 < count ? "," : "");
+            }
+            std::fprintf(out, "        ]%s\n", c == 0 ? "," : "");
+        }
+        std::fprintf(out, "      },\n");
+    }
+
+    void writePiece(std::FILE* out, std::mt19937& rng, int size, const char* type, bool custom, bool last,
+                    std::vector<bool>& taken) {
+        int count = 1 + static_cast<int>(rng() % 4);
+        std::fprintf(out, "    {\n      \"type\": \"%s\",\n", type);
+        writePositions(out, rng, size, count, taken);
+        std::fprintf(out,
+                     "      \"movement\": {\n        \"forward\": %d,\n        \"sideways\": %d,\n"
+                     "        \"diagonal\": %d,\n        \"l_shape\": %s\n      },\n",
+                     static_cast<int>(rng() % 9), static_cast<int>(rng() % 9), static_cast<int>(rng() % 9),
+                     rng() % 2 ? "true" : "false");
+        std::fprintf(out, "      \"special_abilities\": {\n        \"royal\": %s,\n        \"jump_over\": %s",
+                     rng() % 2 ? "true" : "false", rng() % 2 ? "true" : "false");
+        if (custom) {
+            std::fprintf(out, ",\n        \"%s\": true", kCustomAbilities[rng() % 4]);
+        }
+        std::fprintf(out, "\n      },\n      \"count\": %d\n    }%s\n", count, last ? "" : ",");
+    }
+
+    void writeVariant(std::FILE* out, std::mt19937& rng, int index) {
+        // At most 8 kinds x 4 x 2 colors plus 4 portal entries, so always room
+        int size = 10 + static_cast<int>(rng() % 7);
+        std::vector<bool> taken(size * size);
+        std::fprintf(out,
+                     "{\n  \"game_settings\": {\n    \"name\": \"Variant %d\",\n    \"board_size\": %d,\n"
+                     "    \"turn_limit\": %d\n  },\n  \"pieces\": [\n",
+                     index, size, 50 + static_cast<int>(rng() % 200));
+        for (int i = 0; i < 6; ++i) {
+            writePiece(out, rng, size, kPieceNames[i], false, i == 5, taken);
+        }
+        std::fprintf(out, "  ],\n  \"custom_pieces\": [\n");
+        int customCount = static_cast<int>(rng() % 3);
+        for (int i = 0; i < customCount; ++i) {
+            writePiece(out, rng, size, kCustomNames[rng() % 5], true, i + 1 == customCount, taken);
+        }
+        std::fprintf(out, "  ],\n  \"portals\": [\n");
+        int portalCount = static_cast<int>(rng() % 5);
+        for (int i = 0; i < portalCount; ++i) {
+            int entry = takeSquare(rng, taken);
+            std::fprintf(out,
+                         "    {\n      \"type\": \"Portal\",\n      \"id\": \"portal%d\",\n"
+                         "      \"positions\": {\n        \"entry\": { \"x\": %d, \"y\": %d },\n"
+                         "        \"exit\": { \"x\": %d, \"y\": %d }\n      },\n"
+                         "      \"properties\": {\n        \"preserve_direction\": %s,\n"
+                         "        \"allowed_colors\": [\"white\"%s],\n        \"cooldown\": %d\n      }\n    }%s\n",
+                         i, entry % size, entry / size, static_cast<int>(rng() % size), static_cast<int>(rng() % size),
+                         rng() % 2 ? "true" : "false", rng() % 2 ? ", \"black\"" : "",
+                         static_cast<int>(rng() % 4), i + 1 < portalCount ? "," : "");
+        }
+        std::fprintf(out, "  ]\n}");
+    }
+
+    bool generateCatalog(const std::string& path, long megabytes) {
+        std::FILE* out = std::fopen(path.c_str(), "w");
+        if (!out) {
+            std::cerr << "Cannot write " << path << std::endl;
+            return false;
+        }
+        std::mt19937 rng(31);
+        long target = megabytes * 1024 * 1024;
+        std::fprintf(out, "[\n");
+        for (int index = 0; std::ftell(out) < target; ++index) {
+            if (index > 0) {
+                std::fprintf(out, ",\n");
+            }
+            writeVariant(out, rng, index);
+        }
+        std::fprintf(out, "\n]\n");
+        std::fclose(out);
+        return true;
+    }
+
+    // FNV-1a over everything the loaders fill in
+    struct Fingerprint {
+        std::uint64_t value = 1469598103934665603ULL;
+
+        void add(std::uint64_t x) {
+            value ^= x;
+            value *= 1099511628211ULL;
+        }
+        void add(const std::string& text) {
+            for (char c : text) {
+                add(static_cast<std::uint64_t>(static_cast<unsigned char>(c)));
+            }
+            add(text.size());
+        }
+        void add(const PieceConfig& piece) {
+            add(piece.type);
+            add(piece.count);
+            for (const char* color : {"white", "black"}) {
+                auto it = piece.positions.find(color);
+                add(it == piece.positions.end() ? 0 : it->second.size() + 1);
+                if (it != piece.positions.end()) {
+                    for (const Position& pos : it->second) {
+                        add(pos.x * 1000 + pos.y);
+                    }
+                }
+            }
+            const Movement& m = piece.movement;
+            add(m.forward), add(m.sideways), add(m.diagonal), add(m.l_shape);
+            add(m.diagonal_capture), add(m.first_move_forward);
+            const SpecialAbilities& a = piece.special_abilities;
+            add(a.castling), add(a.royal), add(a.jump_over), add(a.promotion), add(a.en_passant);
+            std::uint64_t custom = 0;
+            for (const auto& ability : a.custom_abilities) {
+                Fingerprint entry;
+                entry.add(ability.first);
+                entry.add(ability.second);
+                custom ^= entry.value;
+            }
+            add(custom);
+        }
+        void add(const GameConfig& config) {
+            add(config.game_settings.name);
+            add(config.game_settings.board_size);
+            add(config.game_settings.turn_limit);
+            for (const auto& piece : config.pieces) add(piece);
+            for (const auto& piece : config.custom_pieces) add(piece);
+            for (const auto& portal : config.portals) {
+                add(portal.type);
+                add(portal.id);
+                add(portal.positions.entry.x), add(portal.positions.entry.y);
+                add(portal.positions.exit.x), add(portal.positions.exit.y);
+                add(portal.properties.preserve_direction);
+                add(portal.properties.cooldown);
+                for (const auto& color : portal.properties.allowed_colors) add(color);
+            }
+        }
+    };
+
+    // The current path: parse the whole catalog into a DOM, then convert
+    bool loadDom(const std::string& path, Fingerprint& fingerprint, std::size_t& variants) {
+        std::ifstream file(path);
+        nlohmann::json catalog;
+        file >> catalog;
+        ConfigReader reader;
+        for (const auto& variant : catalog) {
+            if (!reader.loadFromJson(variant)) {
+                return false;
+            }
+            fingerprint.add(reader.getConfig());
+            ++variants;
+        }
+        return true;
+    }
+
+    bool loadSax(const std::string& path, Fingerprint& fingerprint, std::size_t& variants) {
+        ConfigReader reader;
+        return reader.loadCatalogFromFile(path, [&](const GameConfig& config) {
+            fingerprint.add(config);
+            ++variants;
+        });
+    }
+
+    struct Result {
+        bool ok;
+        std::uint64_t fingerprint;
+        std::size_t variants;
+        double seconds;
+    };
+
+    // Run one loader in a child process and collect its result and peak RSS
+    bool runChild(const char* name, bool (*load)(const std::string&, Fingerprint&, std::size_t&),
+                  const std::string& path, Result& result) {
+        int fds[2];
+        if (pipe(fds) != 0) {
+            return false;
+        }
+        pid_t pid = fork();
+        if (pid == 0) {
+            close(fds[0]);
+            Fingerprint fingerprint;
+            Result child{};
+            auto start = std::chrono::steady_clock::now();
+            child.ok = load(path, fingerprint, child.variants);
+            child.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            child.fingerprint = fingerprint.value;
+            ssize_t written = write(fds[1], &child, sizeof(child));
+            _exit(written == sizeof(child) ? 0 : 1);
+        }
+        close(fds[1]);
+        bool received = read(fds[0], &result, sizeof(result)) == sizeof(result);
+        close(fds[0]);
+        int status = 0;
+        rusage usage{};
+        wait4(pid, &status, 0, &usage);
+        if (!received || !result.ok) {
+            std::cerr << name << " load failed" << std::endl;
+            return false;
+        }
+        std::printf("%-4s %8zu variants  %8.1f ms  peak RSS %8.1f MB\n", name, result.variants,
+                    result.seconds * 1000, usage.ru_maxrss / 1024.0);
+        return true;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    std::string path = argc > 1 ? argv[1] : "/tmp/chess_catalog.json";
+    long megabytes = argc > 2 ? std::stol(argv[2]) : 50;
+
+    if (!std::ifstream(path).good()) {
+        std::cout << "Generating " << megabytes << " MB catalog at " << path << std::endl;
+        if (!generateCatalog(path, megabytes)) {
+            return 1;
+        }
+    }
+
+    Result dom{};
+    Result sax{};
+    if (!runChild("DOM", loadDom, path, dom) || !runChild("SAX", loadSax, path, sax)) {
+        return 1;
+    }
+    bool same = dom.fingerprint == sax.fingerprint && dom.variants == sax.variants;
+    std::cout << "Speedup " << dom.seconds / sax.seconds << "x, configs "
+              << (same ? "identical" : "DIFFER") << std::endl;
+    return same ? 0 : 1;
+}
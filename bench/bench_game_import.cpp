@@ -0,0 +1,156 @@
+// Throughput of the PGN-style text importer: random legal games are written
+// as text with SanNotation, then imported into a game archive on one thread
+// and on all of them, and every game is replayed to check the moves. Some
+// games carry a comment with a line starting with '[', some have no tags,
+// and a last import in 1-byte chunks must give the same archive byte for
+// byte.
+//
+// Usage: bench_game_import [config.json] [games] [plies] [threads]
+#include "../include/AttackMap.hpp"
+#include "../include/ConfigCache.hpp"
+#include "../include/GameImport.hpp"
+#include "../include/GameRecord.hpp"
+#include "../include/MoveGenerator.hpp"
+#include "../include/SanNotation.hpp"
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <iterator>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+int main(int argc, char* argv[]) {
+    std::string configPath = argc > 1 ? argv[1] : "data/chess_pieces.json";
+    int gameCount = argc > 2 ? std::stoi(argv[2]) : 5000;
+    int maxPlies = argc > 3 ? std::stoi(argv[3]) : 120;
+    unsigned threads = argc > 4 ? static_cast<unsigned>(std::stoul(argv[4])) : 0;
+
+    auto variant = ConfigCache::instance().getFile(configPath);
+    if (!variant || !variant->rules) {
+        std::cerr << "Failed to load configuration. Exiting." << std::endl;
+        return 1;
+    }
+    const RuleSet& rules = *variant->rules;
+    auto directory = std::filesystem::temp_directory_path();
+    std::string textPath = (directory / "bench_game_import.pgn").string();
+    std::string archivePath = (directory / "bench_game_import.games").string();
+
+    // Random games, written as text and kept as packed moves for the check
+    MoveGenerator generator(rules);
+    AttackMap attacks(rules);
+    SanNotation san(rules);
+    auto moves = std::make_unique<MoveList>();
+    std::mt19937_64 rng(29);
+    std::vector<std::vector<std::uint32_t>> games(gameCount);
+    std::uint64_t portalMoves = 0;
+    {
+        std::ofstream text(textPath, std::ios::binary | std::ios::trunc);
+        char buffer[SanNotation::kMaxLength];
+        for (int i = 0; i < gameCount; ++i) {
+            GameState state;
+            state.reset(rules);
+            attacks.build(state);
+            if (i % 3 != 1) {
+                // Every third game has no tag section at all
+                text << "[Event \"bench\"]\n[Round \"" << i + 1 << "\"]\n\n";
+            }
+            int ply = 0;
+            for (; ply < maxPlies; ++ply) {
+                generator.generateLegal(state, attacks, *moves);
+                if (moves->count == 0) break;
+                EngineMove move = moves->moves[rng() % moves->count];
+                std::size_t length = san.write(state, attacks, move, buffer);
+                if (length == 0) {
+                    std::cerr << "The variant's pieces cannot all be written as text" << std::endl;
+                    return 1;
+                }
+                if (ply % 2 == 0) {
+                    text << ply / 2 + 1 << ". ";
+                }
+                text.write(buffer, static_cast<std::streamsize>(length));
+                text << (ply % 16 == 15 ? '\n' : ' ');
+                if (i % 4 == 0 && ply == 3) {
+                    // Not a tag section, though a line starts with '['
+                    text << "{ A note\n[that looks like a tag]\nover three lines }\n";
+                }
+                portalMoves += move.portal != kNoPortal;
+                games[i].push_back(move.pack());
+                int changed[4];
+                int changedCount = generator.getChangedSquares(move, changed);
+                generator.makeMove(state, move);
+                attacks.update(state, changed, changedCount);
+            }
+            text << (ply % 3 == 0 ? "1-0" : ply % 3 == 1 ? "0-1" : "1/2-1/2") << "\n\n";
+        }
+    }
+    std::uint64_t totalMoves = 0;
+    for (const auto& game : games) {
+        totalMoves += game.size();
+    }
+    std::printf("%d games, %llu moves (%llu through portals), %.1f MB of text\n", gameCount,
+                static_cast<unsigned long long>(totalMoves), static_cast<unsigned long long>(portalMoves),
+                static_cast<double>(std::filesystem::file_size(textPath)) / (1 << 20));
+
+    struct Run {
+        unsigned threads;
+        std::size_t chunkSize;
+    };
+    std::vector<Run> runs{{1, GameImporter::kDefaultChunkSize}};
+    unsigned allThreads = threads ? threads : std::thread::hardware_concurrency();
+    if (allThreads > 1) {
+        runs.push_back({allThreads, GameImporter::kDefaultChunkSize});
+    }
+    runs.push_back({allThreads, 1});
+    std::string firstArchive;
+    bool failed = false;
+    for (const Run& run : runs) {
+        std::filesystem::remove(archivePath);
+        GameRecordWriter archive(rules);
+        if (!archive.open(archivePath, variant->contentHash)) return 1;
+        GameImporter importer(rules, run.threads, run.chunkSize);
+        GameImportStats stats;
+        if (!importer.import(textPath, archive, stats) || !archive.close()) return 1;
+
+        // Every game must replay to the moves it was written from
+        auto reader = GameRecordReader::open(archivePath);
+        if (!reader) return 1;
+        GameReplayer replayer(rules);
+        std::size_t offset = 0;
+        std::size_t game = 0;
+        std::uint64_t mismatches = 0;
+        GameRecordView view;
+        while (reader->next(offset, view) && game < games.size()) {
+            replayer.start(view);
+            EngineMove move;
+            std::size_t ply = 0;
+            while (replayer.next(move)) {
+                mismatches += ply >= games[game].size() || move.pack() != games[game][ply];
+                ply++;
+            }
+            mismatches += ply != games[game].size();
+            game++;
+        }
+        reader.reset();
+
+        // The chunk size and thread count must not change a byte
+        std::ifstream in(archivePath, std::ios::binary);
+        std::string bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        if (firstArchive.empty()) {
+            firstArchive = bytes;
+        }
+        bool ok = mismatches == 0 && game == games.size() && stats.skipped == 0 && bytes == firstArchive;
+        failed = failed || !ok;
+        std::printf("import on %2u threads, %7zu-byte chunks %8.1f MB/s %10.0f moves/s  %llu games, %llu skipped%s\n",
+                    run.threads, run.chunkSize, static_cast<double>(stats.bytes) / (1 << 20) / stats.seconds,
+                    static_cast<double>(stats.moves) / stats.seconds, static_cast<unsigned long long>(stats.games),
+                    static_cast<unsigned long long>(stats.skipped), ok ? "" : "  MISMATCH");
+    }
+
+    std::filesystem::remove(textPath);
+    std::filesystem::remove(archivePath);
+    return failed;
+}
@@ -0,0 +1,166 @@
+// Size and speed of the compact game archive against the self-play log:
+// bytes per move, write throughput, and replay throughput (decoding every
+// move and playing it) on one thread and on all of them.
+//
+// Usage: bench_game_records [config.json] [games] [plies] [threads]
+//
+// Games are random legal move sequences of up to `plies` plies, written to
+// files in the temporary directory.
+#include "../include/AttackMap.hpp"
+#include "../include/ConfigCache.hpp"
+#include "../include/GameRecord.hpp"
+#include "../include/MoveGenerator.hpp"
+#include "../include/SelfPlay.hpp"
+#include "../include/ThreadPool.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+    std::vector<SelfPlayGame> makeGames(const RuleSet& rules, int count, int maxPlies) {
+        MoveGenerator generator(rules);
+        AttackMap attacks(rules);
+        auto moves = std::make_unique<MoveList>();
+        std::mt19937_64 rng(17);
+        std::vector<SelfPlayGame> games(count);
+        for (int i = 0; i < count; ++i) {
+            SelfPlayGame& game = games[i];
+            game.index = static_cast<std::uint32_t>(i);
+            GameState state;
+            state.reset(rules);
+            attacks.build(state);
+            for (int ply = 0; ply < maxPlies; ++ply) {
+                generator.generateLegal(state, attacks, *moves);
+                if (moves->count == 0) break;
+                EngineMove move = moves->moves[rng() % moves->count];
+                int changed[4];
+                int changedCount = generator.getChangedSquares(move, changed);
+                generator.makeMove(state, move);
+                attacks.update(state, changed, changedCount);
+                game.moves.push_back(move.pack());
+            }
+        }
+        return games;
+    }
+
+    double secondsSince(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+}
+
+int main(int argc, char* argv[]) {
+    std::string configPath = argc > 1 ? argv[1] : "data/chess_pieces.json";
+    int gameCount = argc > 2 ? std::stoi(argv[2]) : 5000;
+    int maxPlies = argc > 3 ? std::stoi(argv[3]) : 120;
+    unsigned threads = argc > 4 ? static_cast<unsigned>(std::stoul(argv[4])) : 0;
+
+    auto variant = ConfigCache::instance().getFile(configPath);
+    if (!variant || !variant->rules) {
+        std::cerr << "Failed to load configuration. Exiting." << std::endl;
+        return 1;
+    }
+    const RuleSet& rules = *variant->rules;
+    std::vector<SelfPlayGame> games = makeGames(rules, gameCount, maxPlies);
+    std::uint64_t totalMoves = 0;
+    for (const auto& game : games) {
+        totalMoves += game.moves.size();
+    }
+
+    auto directory = std::filesystem::temp_directory_path();
+    std::string logPath = (directory / "bench_game_records.splg").string();
+    std::string archivePath = (directory / "bench_game_records.games").string();
+    std::filesystem::remove(archivePath);
+
+    SelfPlayLog log;
+    auto start = std::chrono::steady_clock::now();
+    if (!log.create(logPath, variant->contentHash)) return 1;
+    for (const auto& game : games) {
+        log.write(game);
+    }
+    if (!log.close()) return 1;
+    double logWriteSeconds = secondsSince(start);
+
+    GameRecordWriter writer(rules);
+    start = std::chrono::steady_clock::now();
+    if (!writer.open(archivePath, variant->contentHash)) return 1;
+    for (const auto& game : games) {
+        writer.write(GameResult::Draw, game.moves);
+    }
+    if (!writer.close()) return 1;
+    double archiveWriteSeconds = secondsSince(start);
+
+    std::printf("%d games, %llu moves\n", gameCount, static_cast<unsigned long long>(totalMoves));
+    std::printf("self-play log  %10llu bytes  %5.2f bytes/move  write %8.0f games/s\n",
+                static_cast<unsigned long long>(std::filesystem::file_size(logPath)),
+                static_cast<double>(std::filesystem::file_size(logPath)) / totalMoves, gameCount / logWriteSeconds);
+    std::printf("game archive   %10llu bytes  %5.2f bytes/move  write %8.0f games/s\n",
+                static_cast<unsigned long long>(std::filesystem::file_size(archivePath)),
+                static_cast<double>(std::filesystem::file_size(archivePath)) / totalMoves,
+                gameCount / archiveWriteSeconds);
+
+    // Reading the log back copies every game; the archive is read in place
+    std::uint64_t configHash = 0;
+    std::vector<SelfPlayGame> readBack;
+    start = std::chrono::steady_clock::now();
+    if (!SelfPlayLog::read(logPath, configHash, readBack)) return 1;
+    std::printf("self-play log  read %10.0f moves/s (no replay)\n", totalMoves / secondsSince(start));
+
+    auto reader = GameRecordReader::open(archivePath);
+    if (!reader) return 1;
+    std::vector<GameRecordView> views;
+    start = std::chrono::steady_clock::now();
+    std::size_t offset = 0;
+    GameRecordView view;
+    while (reader->next(offset, view)) {
+        views.push_back(view);
+    }
+    std::printf("game archive   scan %10.0f games/s (%zu games)\n", views.size() / secondsSince(start), views.size());
+
+    ThreadPool pool(threads);
+    std::vector<unsigned> threadCounts{1};
+    if (pool.getThreadCount() > 1) {
+        threadCounts.push_back(pool.getThreadCount());
+    }
+    for (unsigned count : threadCounts) {
+        std::vector<std::unique_ptr<GameReplayer>> replayers;
+        for (unsigned i = 0; i < count; ++i) {
+            replayers.push_back(std::make_unique<GameReplayer>(rules));
+        }
+        std::atomic<std::uint64_t> replayed{0};
+        std::atomic<std::uint64_t> mismatches{0};
+        auto replay = [&](unsigned worker, std::size_t index) {
+            GameReplayer& replayer = *replayers[worker];
+            replayer.start(views[index]);
+            EngineMove move;
+            std::uint64_t moves = 0;
+            while (replayer.next(move)) {
+                if (move.pack() != games[index].moves[moves]) {
+                    mismatches++;
+                }
+                moves++;
+            }
+            replayed += moves;
+        };
+        start = std::chrono::steady_clock::now();
+        if (count == 1) {
+            for (std::size_t i = 0; i < views.size(); ++i) {
+                replay(0, i);
+            }
+        } else {
+            pool.parallelFor(views.size(), replay);
+        }
+        double seconds = secondsSince(start);
+        std::printf("game archive   replay on %2u threads %10.0f moves/s%s\n", count, replayed.load() / seconds,
+                    replayed.load() == totalMoves && mismatches.load() == 0 ? "" : "  MISMATCH");
+    }
+
+    std::filesystem::remove(logPath);
+    std::filesystem::remove(archivePath);
+    return 0;
+}
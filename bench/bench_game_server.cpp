@@ -0,0 +1,206 @@
+// Move latency of the game server with many concurrent games.
+//
+// Usage: bench_game_server [config.json] [games] [clients] [moves] [shards]
+//
+// Starts a GameServer on a Unix socket in this process, opens `games` games
+// spread over `clients` client threads, then has every client play random
+// legal moves round-robin over its games (asking the server for the legal
+// moves, then sending one) until `moves` moves have been played in total.
+// Finished games are ended and replaced. Reports the round-trip latency of
+// the MOVE requests, throughput and peak memory.
+#include "../include/ConfigCache.hpp"
+#include "../include/GameServer.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+    const char* kSocketPath = "/tmp/bench_game_server.sock";
+
+    // Blocking line-oriented client connection
+    class Client {
+    public:
+        bool connectTo(const char* path) {
+            fd = socket(AF_UNIX, SOCK_STREAM, 0);
+            sockaddr_un address{};
+            address.sun_family = AF_UNIX;
+            std::strncpy(address.sun_path, path, sizeof(address.sun_path) - 1);
+            return fd >= 0 && connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0;
+        }
+        ~Client() {
+            if (fd >= 0) close(fd);
+        }
+
+        // Send one request and read the one-line reply
+        bool request(const std::string& line, std::string& reply) {
+            std::string out = line + '\n';
+            for (std::size_t sent = 0; sent < out.size();) {
+                ssize_t bytes = send(fd, out.data() + sent, out.size() - sent, MSG_NOSIGNAL);
+                if (bytes <= 0) return false;
+                sent += static_cast<std::size_t>(bytes);
+            }
+            for (;;) {
+                std::size_t end = buffer.find('\n');
+                if (end != std::string::npos) {
+                    reply.assign(buffer, 0, end);
+                    buffer.erase(0, end + 1);
+                    return true;
+                }
+                char chunk[8192];
+                ssize_t bytes = recv(fd, chunk, sizeof(chunk), 0);
+                if (bytes <= 0) return false;
+                buffer.append(chunk, static_cast<std::size_t>(bytes));
+            }
+        }
+
+    private:
+        int fd = -1;
+        std::string buffer;
+    };
+
+    struct ClientResult {
+        std::vector<double> latencies; // Microseconds per MOVE round trip
+        std::size_t gamesFinished = 0;
+        bool ok = true;
+    };
+
+    std::string newGame(Client& client) {
+        std::string reply;
+        if (!client.request("NEW", reply) || reply.compare(0, 3, "OK ") != 0) return "";
+        return reply.substr(3);
+    }
+
+    void runClient(int games, std::atomic<long>& movesLeft, ClientResult& result, unsigned seed) {
+        Client client;
+        if (!client.connectTo(kSocketPath)) {
+            result.ok = false;
+            return;
+        }
+        std::vector<std::string> ids;
+        for (int i = 0; i < games; ++i) {
+            ids.push_back(newGame(client));
+            if (ids.back().empty()) {
+                result.ok = false;
+                return;
+            }
+        }
+
+        std::mt19937 rng(seed);
+        std::string reply;
+        std::vector<std::string> moves;
+        for (std::size_t next = 0; movesLeft.fetch_sub(1) > 0; next = (next + 1) % ids.size()) {
+            std::string& id = ids[next];
+            if (!client.request("MOVES " + id, reply)) {
+                result.ok = false;
+                return;
+            }
+            moves.clear();
+            std::size_t pos = 3 + id.size();
+            while (pos < reply.size()) {
+                std::size_t end = reply.find(' ', pos + 1);
+                moves.push_back(reply.substr(pos + 1, end == std::string::npos ? end : end - pos - 1));
+                pos = end == std::string::npos ? reply.size() : end;
+            }
+            if (moves.empty()) {
+                result.ok = false;
+                return;
+            }
+
+            // "e2e4" -> "MOVE <id> e2e4"; the server reads both squares
+            std::string request = "MOVE " + id + ' ' + moves[rng() % moves.size()];
+            auto start = std::chrono::steady_clock::now();
+            bool sent = client.request(request, reply);
+            auto elapsed = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+            if (!sent || reply.compare(0, 3, "OK ") != 0) {
+                std::cerr << request << " -> " << reply << std::endl;
+                result.ok = false;
+                return;
+            }
+            result.latencies.push_back(elapsed);
+
+            if (reply.compare(reply.size() - 7, 7, "ongoing") != 0) {
+                client.request("END " + id, reply);
+                id = newGame(client);
+                result.gamesFinished++;
+                if (id.empty()) {
+                    result.ok = false;
+                    return;
+                }
+            }
+        }
+    }
+}
+
+int main(int argc, char* argv[]) {
+    std::string configPath = argc > 1 ? argv[1] : "data/chess_pieces.json";
+    int games = argc > 2 ? std::stoi(argv[2]) : 10000;
+    int clients = argc > 3 ? std::stoi(argv[3]) : 16;
+    long moves = argc > 4 ? std::stol(argv[4]) : 200000;
+    unsigned shards = argc > 5 ? static_cast<unsigned>(std::stoul(argv[5])) : 0;
+
+    auto variant = ConfigCache::instance().getFile(configPath);
+    if (!variant || !variant->rules) {
+        std::cerr << "Failed to load configuration. Exiting." << std::endl;
+        return 1;
+    }
+    GameServer server(variant, shards);
+    if (!server.listenUnix(kSocketPath)) {
+        return 1;
+    }
+    std::thread serverThread([&server] { server.run(); });
+
+    std::atomic<long> movesLeft{moves};
+    std::vector<ClientResult> results(static_cast<std::size_t>(clients));
+    std::vector<std::thread> threads;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < clients; ++i) {
+        int share = games / clients + (i < games % clients ? 1 : 0);
+        threads.emplace_back(runClient, std::max(share, 1), std::ref(movesLeft), std::ref(results[i]), 100u + i);
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::size_t openGames = server.getGameCount();
+    server.stop();
+    serverThread.join();
+
+    std::vector<double> latencies;
+    std::size_t finished = 0;
+    bool ok = true;
+    for (const auto& result : results) {
+        latencies.insert(latencies.end(), result.latencies.begin(), result.latencies.end());
+        finished += result.gamesFinished;
+        ok = ok && result.ok;
+    }
+    if (!ok || latencies.empty()) {
+        std::cerr << "A client failed" << std::endl;
+        return 1;
+    }
+    std::sort(latencies.begin(), latencies.end());
+    auto percentile = [&](double p) {
+        return latencies[std::min(latencies.size() - 1, static_cast<std::size_t>(p * latencies.size()))];
+    };
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+
+    std::printf("%zu games open on %u shards, %d clients, %zu games finished\n", openGames,
+                server.getShardCount(), clients, finished);
+    std::printf("%zu moves in %.2f s (%.0f moves/s, including MOVES and NEW requests)\n", latencies.size(),
+                seconds, static_cast<double>(latencies.size()) / seconds);
+    std::printf("MOVE latency: p50 %.1f us  p90 %.1f us  p99 %.1f us  max %.1f us\n", percentile(0.50),
+                percentile(0.90), percentile(0.99), latencies.back());
+    std::printf("Peak RSS %.1f MB\n", usage.ru_maxrss / 1024.0);
+    return 0;
+}
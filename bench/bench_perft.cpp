@@ -0,0 +1,97 @@
+// Perft (move tree node count) for a config's starting position, using both
+// make/unmake and copy-make, the legal move tree count, plus a check that the incrementally updated hash
+// matches a full recomputation.
+//
+// Usage: bench_perft [config.json] [depth] [fen]
+//
+// A position in FEN (see GameState::readFen) replaces the
+// starting position.
+#include "../include/AttackMap.hpp"
+#include "../include/ConfigReader.hpp"
+#include "../include/GameState.hpp"
+#include "../include/MoveGenerator.hpp"
+#include "../include/RuleSet.hpp"
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+
+namespace {
+    // Play random games and compare the running hash with a recomputed one
+    bool checkHashes(const MoveGenerator& generator, int games, int plies) {
+        std::mt19937 rng(2024);
+        MoveList moves;
+        UndoInfo undo;
+        for (int game = 0; game < games; ++game) {
+            GameState state;
+            state.reset(generator.getRules());
+            for (int ply = 0; ply < plies; ++ply) {
+                generator.generate(state, moves);
+                if (moves.count == 0) break;
+                generator.makeMove(state, moves.moves[rng() % moves.count], undo);
+                if (state.hash != state.computeHash(generator.getRules())) {
+                    std::cerr << "Hash mismatch in game " << game << " at ply " << ply << std::endl;
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    std::string configPath = argc > 1 ? argv[1] : "data/chess_pieces.json";
+    int maxDepth = argc > 2 ? std::stoi(argv[2]) : 4;
+    std::string fen = argc > 3 ? argv[3] : "";
+
+    ConfigReader configReader;
+    if (!configReader.loadFromFile(configPath)) {
+        std::cerr << "Failed to load configuration. Exiting." << std::endl;
+        return 1;
+    }
+    auto rules = RuleSet::compile(configReader.getConfig());
+    if (!rules) {
+        return 1;
+    }
+
+    MoveGenerator generator(*rules);
+    GameState state;
+    state.reset(*rules);
+    if (!fen.empty() && !state.readFen(*rules, fen)) {
+        return 1;
+    }
+    std::cout << state.toFen(*rules) << std::endl;
+
+    bool countsOk = true;
+    for (int depth = 1; depth <= maxDepth; ++depth) {
+        auto start = std::chrono::steady_clock::now();
+        std::uint64_t nodes = generator.perft(state, depth);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        start = std::chrono::steady_clock::now();
+        std::uint64_t copyNodes = generator.perftCopy(state, depth);
+        double copySeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        countsOk = countsOk && nodes == copyNodes;
+
+        std::cout << "perft(" << depth << ") = " << nodes << "  make/unmake " << seconds * 1000 << " ms ("
+                  << static_cast<double>(nodes) / seconds / 1e6 << " Mnodes/s)  copy-make " << copySeconds * 1000
+                  << " ms (" << static_cast<double>(copyNodes) / copySeconds / 1e6 << " Mnodes/s)"
+                  << (nodes == copyNodes ? "" : "  COUNT MISMATCH") << std::endl;
+    }
+
+    // Legal move tree, with the attack map updated incrementally
+    auto attacks = std::make_unique<AttackMap>(*rules);
+    attacks->build(state);
+    for (int depth = 1; depth <= maxDepth; ++depth) {
+        auto start = std::chrono::steady_clock::now();
+        std::uint64_t nodes = generator.perftLegal(state, *attacks, depth);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "legal perft(" << depth << ") = " << nodes << "  " << seconds * 1000 << " ms ("
+                  << static_cast<double>(nodes) / seconds / 1e6 << " Mnodes/s)" << std::endl;
+    }
+
+    bool hashesOk = checkHashes(generator, 200, 200);
+    std::cout << "Incremental hash: " << (hashesOk ? "ok" : "MISMATCH") << std::endl;
+    return hashesOk && countsOk ? 0 : 1;
+}
@@ -0,0 +1,127 @@
+// Compares PortalSystem's square/id indexes with a linear scan of the portal
+// list (the previous lookup strategy).
+//
+// Usage: bench_portal_lookup [portals] [board_size] [rounds]
+#include "../include/PortalSystem.hpp"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+    // The previous implementation: scan every portal and compare
+    struct LinearPortals {
+        std::vector<const Portal*> portals;
+
+        const Portal* byEntry(const Position& position) const {
+            for (const Portal* portal : portals) {
+                if (portal->getEntry() == position) return portal;
+            }
+            return nullptr;
+        }
+        bool isExit(const Position& position) const {
+            for (const Portal* portal : portals) {
+                if (portal->getExit() == position) return true;
+            }
+            return false;
+        }
+        const Portal* byId(const std::string& id) const {
+            for (const Portal* portal : portals) {
+                if (portal->getId() == id) return portal;
+            }
+            return nullptr;
+        }
+    };
+
+    template <typename F>
+    double nsPerOp(long long ops, F&& body) {
+        auto start = std::chrono::steady_clock::now();
+        body();
+        auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return elapsed * 1e9 / static_cast<double>(ops);
+    }
+
+    void report(const char* name, double linear, double indexed) {
+        std::cout << "  " << name << ": linear " << linear << " ns, indexed " << indexed
+                  << " ns (" << linear / indexed << "x)" << std::endl;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    int portalCount = argc > 1 ? std::stoi(argv[1]) : 128;
+    int boardSize = argc > 2 ? std::stoi(argv[2]) : 32;
+    int rounds = argc > 3 ? std::stoi(argv[3]) : 200;
+
+    int squareCount = boardSize * boardSize;
+    if (portalCount * 2 > squareCount) {
+        std::cerr << "Too many portals for the board" << std::endl;
+        return 1;
+    }
+
+    // Distinct random entry/exit squares
+    std::mt19937 rng(12345);
+    std::vector<int> squares(squareCount);
+    std::iota(squares.begin(), squares.end(), 0);
+    std::shuffle(squares.begin(), squares.end(), rng);
+
+    PortalSystem portalSystem(boardSize);
+    std::vector<std::string> ids;
+    for (int i = 0; i < portalCount; ++i) {
+        Position entry(squares[2 * i] % boardSize, squares[2 * i] / boardSize);
+        Position exit(squares[2 * i + 1] % boardSize, squares[2 * i + 1] / boardSize);
+        ids.push_back("portal" + std::to_string(i));
+        portalSystem.addPortal(std::make_unique<Portal>(ids.back(), entry, exit, true, 0));
+    }
+
+    LinearPortals linear;
+    for (int i = 0; i < portalSystem.getPortalCount(); ++i) {
+        linear.portals.push_back(portalSystem.getPortal(i));
+    }
+
+    // Every square is probed, as move generation would
+    long long squareOps = static_cast<long long>(rounds) * squareCount;
+    long long idOps = static_cast<long long>(rounds) * portalCount;
+    std::size_t sink = 0;
+
+    double linearEntry = nsPerOp(squareOps, [&] {
+        for (int r = 0; r < rounds; ++r)
+            for (int sq = 0; sq < squareCount; ++sq)
+                sink += linear.byEntry({sq % boardSize, sq / boardSize}) != nullptr;
+    });
+    double indexedEntry = nsPerOp(squareOps, [&] {
+        for (int r = 0; r < rounds; ++r)
+            for (int sq = 0; sq < squareCount; ++sq)
+                sink += portalSystem.getPortalByEntry({sq % boardSize, sq / boardSize}) != nullptr;
+    });
+    double linearExit = nsPerOp(squareOps, [&] {
+        for (int r = 0; r < rounds; ++r)
+            for (int sq = 0; sq < squareCount; ++sq)
+                sink += linear.isExit({sq % boardSize, sq / boardSize});
+    });
+    double indexedExit = nsPerOp(squareOps, [&] {
+        for (int r = 0; r < rounds; ++r)
+            for (int sq = 0; sq < squareCount; ++sq)
+                sink += portalSystem.isExitPoint({sq % boardSize, sq / boardSize});
+    });
+    double linearId = nsPerOp(idOps, [&] {
+        for (int r = 0; r < rounds; ++r)
+            for (const auto& id : ids)
+                sink += linear.byId(id) != nullptr;
+    });
+    double indexedId = nsPerOp(idOps, [&] {
+        for (int r = 0; r < rounds; ++r)
+            for (const auto& id : ids)
+                sink += portalSystem.getPortalById(id) != nullptr;
+    });
+
+    std::cout << portalCount << " portals on a " << boardSize << "x" << boardSize << " board (ns per lookup)" << std::endl;
+    report("getPortalByEntry", linearEntry, indexedEntry);
+    report("isExitPoint     ", linearExit, indexedExit);
+    report("getPortalById   ", linearId, indexedId);
+    std::cout << "  (checksum " << sink << ")" << std::endl;
+
+    return 0;
+}
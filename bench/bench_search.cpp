@@ -0,0 +1,161 @@
+// Throughput of the two search engines on the same positions: alpha-beta
+// nodes per second against MCTS playouts per second (on one thread and on
+// all of them), optionally followed by a short match between the two.
+//
+// Usage: bench_search [config.json] [positions] [nodes] [playouts] [threads] [games]
+//
+// Positions are the start position and positions reached by random legal
+// moves from it. Each engine gets `nodes` nodes or `playouts` playouts per
+// position. In the match (none by default) the engines alternate colors.
+#include "../include/AttackMap.hpp"
+#include "../include/ConfigReader.hpp"
+#include "../include/GameState.hpp"
+#include "../include/Mcts.hpp"
+#include "../include/MoveGenerator.hpp"
+#include "../include/RuleSet.hpp"
+#include "../include/Search.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+    std::vector<GameState> makePositions(const RuleSet& rules, int count) {
+        MoveGenerator generator(rules);
+        AttackMap attacks(rules);
+        MoveList moves;
+        std::mt19937 rng(7);
+        std::vector<GameState> positions;
+        GameState state;
+        state.reset(rules);
+        positions.push_back(state);
+        while (static_cast<int>(positions.size()) < count) {
+            state.reset(rules);
+            attacks.build(state);
+            int plies = 4 + static_cast<int>(positions.size()) * 4;
+            for (int ply = 0; ply < plies; ++ply) {
+                generator.generateLegal(state, attacks, moves);
+                if (moves.count == 0) break;
+                EngineMove move = moves.moves[rng() % moves.count];
+                int changed[4];
+                int changedCount = generator.getChangedSquares(move, changed);
+                generator.makeMove(state, move);
+                attacks.update(state, changed, changedCount);
+            }
+            positions.push_back(state);
+        }
+        return positions;
+    }
+
+    double secondsSince(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    // Alpha-beta (white when `searchIsWhite`) against MCTS; 2 = search
+    // wins, 1 = draw, 0 = MCTS wins
+    int playMatchGame(const RuleSet& rules, Search& search, Mcts& mcts, std::uint64_t nodes,
+                      std::uint64_t playouts, bool searchIsWhite) {
+        MoveGenerator generator(rules);
+        AttackMap attacks(rules);
+        GameState state;
+        state.reset(rules);
+        attacks.build(state);
+        SearchLimits searchLimits;
+        searchLimits.nodes = nodes;
+        MctsLimits mctsLimits;
+        mctsLimits.playouts = playouts;
+        int maxPlies = rules.turnLimit > 0 ? rules.turnLimit : 300;
+        for (int ply = 0; ply < maxPlies; ++ply) {
+            bool searchToMove = (state.sideToMove == Color::WHITE) == searchIsWhite;
+            EngineMove move = searchToMove ? search.think(state, attacks, searchLimits).move
+                                           : mcts.think(state, mctsLimits).move;
+            if (move.pack() == 0) {
+                if (!attacks.isInCheck(state.sideToMove)) return 1;
+                return searchToMove ? 0 : 2;
+            }
+            int changed[4];
+            int changedCount = generator.getChangedSquares(move, changed);
+            generator.makeMove(state, move);
+            attacks.update(state, changed, changedCount);
+        }
+        return 1;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    std::string configPath = argc > 1 ? argv[1] : "data/chess_pieces.json";
+    int positionCount = argc > 2 ? std::stoi(argv[2]) : 8;
+    std::uint64_t nodes = argc > 3 ? std::stoull(argv[3]) : 200000;
+    std::uint64_t playouts = argc > 4 ? std::stoull(argv[4]) : 20000;
+    unsigned threads = argc > 5 ? static_cast<unsigned>(std::stoul(argv[5])) : 0;
+    int games = argc > 6 ? std::stoi(argv[6]) : 0;
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    ConfigReader configReader;
+    if (!configReader.loadFromFile(configPath)) {
+        std::cerr << "Failed to load configuration. Exiting." << std::endl;
+        return 1;
+    }
+    auto rules = RuleSet::compile(configReader.getConfig());
+    if (!rules) {
+        return 1;
+    }
+    std::vector<GameState> positions = makePositions(*rules, positionCount);
+
+    Search search(*rules);
+    AttackMap attacks(*rules);
+    SearchLimits searchLimits;
+    searchLimits.nodes = nodes;
+    std::uint64_t searchNodes = 0;
+    int depthSum = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (GameState state : positions) {
+        attacks.build(state);
+        SearchResult result = search.think(state, attacks, searchLimits);
+        searchNodes += result.nodes;
+        depthSum += result.depth;
+    }
+    double searchSeconds = secondsSince(start);
+    std::printf("%zu positions\n", positions.size());
+    std::printf("alpha-beta:        %10.0f nodes/s     (average depth %.1f)\n", searchNodes / searchSeconds,
+                static_cast<double>(depthSum) / positions.size());
+
+    MctsLimits mctsLimits;
+    mctsLimits.playouts = playouts;
+    std::vector<unsigned> threadCounts{1};
+    if (threads > 1) {
+        threadCounts.push_back(threads);
+    }
+    for (unsigned count : threadCounts) {
+        Mcts mcts(*rules, count);
+        std::uint64_t total = 0;
+        std::size_t nodesUsed = 0;
+        start = std::chrono::steady_clock::now();
+        for (const GameState& state : positions) {
+            MctsResult result = mcts.think(state, mctsLimits);
+            total += result.playouts;
+            nodesUsed = std::max(nodesUsed, result.nodes);
+        }
+        double seconds = secondsSince(start);
+        std::printf("MCTS, %2u thread%s: %10.0f playouts/s  (up to %zu tree nodes)\n", count, count == 1 ? " " : "s",
+                    total / seconds, nodesUsed);
+    }
+
+    if (games > 0) {
+        Mcts mcts(*rules, threads);
+        int points = 0;
+        start = std::chrono::steady_clock::now();
+        for (int game = 0; game < games; ++game) {
+            points += playMatchGame(*rules, search, mcts, nodes, playouts, game % 2 == 0);
+        }
+        std::printf("Match: alpha-beta %.1f - %.1f MCTS over %d games (%.1f s)\n", points / 2.0,
+                    games - points / 2.0, games, secondsSince(start));
+    }
+    return 0;
+}
@@ -0,0 +1,135 @@
+// Probe latency of plain tables against compressed ones, and their sizes.
+//
+// Usage: bench_tablebase [config.json] [material] [directory] [probes]
+//
+// The tables for `material` (and everything it turns into) are generated in
+// both formats under `directory` unless they are already there. Random
+// probes scatter over the whole table, so compressed tables decompress a
+// block on nearly every probe; local probes visit the positions one move
+// away from each other, the way a search does, and mostly hit the cache.
+#include "../include/AttackMap.hpp"
+#include "../include/ConfigReader.hpp"
+#include "../include/MoveGenerator.hpp"
+#include "../include/RuleSet.hpp"
+#include "../include/Tablebase.hpp"
+#include "../include/TablebaseGenerator.hpp"
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+    // Legal positions of the material: random ones, or random ones each
+    // followed by every position one legal move away that keeps the material
+    std::vector<GameState> makePositions(const RuleSet& rules, const TablebaseMaterial& material, std::size_t count,
+                                         bool local) {
+        TablebaseIndexer indexer(rules, material);
+        MoveGenerator generator(rules);
+        AttackMap attacks(rules);
+        MoveList moves;
+        std::mt19937_64 rng(11);
+        std::vector<GameState> positions;
+        while (positions.size() < count) {
+            GameState state;
+            if (!indexer.decode(rng() % indexer.size(), state)) continue;
+            attacks.build(state);
+            if (attacks.isInCheck(state.sideToMove == Color::WHITE ? Color::BLACK : Color::WHITE)) continue;
+            positions.push_back(state);
+            if (!local) continue;
+            generator.generateLegal(state, attacks, moves);
+            for (const EngineMove& move : moves) {
+                GameState next = state;
+                generator.makeMove(next, move);
+                TablebaseMaterial reached;
+                reached.read(rules, next);
+                if (reached.key() == material.key()) {
+                    positions.push_back(next);
+                }
+            }
+        }
+        positions.resize(count);
+        return positions;
+    }
+
+    std::size_t directoryBytes(const std::string& directory) {
+        std::size_t total = 0;
+        for (const auto& entry : std::filesystem::directory_iterator(directory)) {
+            total += entry.file_size();
+        }
+        return total;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    std::string configPath = argc > 1 ? argv[1] : "data/chess_pieces.json";
+    std::string materialText = argc > 2 ? argv[2] : "KQvK";
+    std::string directory = argc > 3 ? argv[3] : (std::filesystem::temp_directory_path() / "bench_tablebase").string();
+    std::size_t probes = argc > 4 ? std::stoull(argv[4]) : 1000000;
+
+    ConfigReader configReader;
+    if (!configReader.loadFromFile(configPath)) {
+        std::cerr << "Failed to load configuration. Exiting." << std::endl;
+        return 1;
+    }
+    auto rules = RuleSet::compile(configReader.getConfig());
+    if (!rules) {
+        return 1;
+    }
+    TablebaseMaterial material;
+    if (!material.parse(*rules, materialText)) {
+        return 1;
+    }
+
+    struct Format {
+        const char* name;
+        TablebaseFormat format;
+        std::string directory;
+        std::shared_ptr<const Tablebase> table;
+    };
+    std::vector<Format> formats{{"plain", TablebaseFormat::Plain, directory + "/plain", nullptr},
+                                {"compressed", TablebaseFormat::Compressed, directory + "/compressed", nullptr}};
+    for (auto& entry : formats) {
+        TablebaseGenerator generator(*rules, 0, entry.format);
+        if (!generator.generate(material, entry.directory)) {
+            return 1;
+        }
+        std::string path = entry.directory + "/" + materialText + Tablebase::extension(entry.format);
+        entry.table = Tablebase::open(path, *rules);
+        if (!entry.table) {
+            return 1;
+        }
+    }
+
+    std::printf("%s, %llu positions\n", materialText.c_str(),
+                static_cast<unsigned long long>(TablebaseIndexer(*rules, material).size()));
+    for (const auto& entry : formats) {
+        std::printf("%-10s  table %9zu bytes   all tables %9zu bytes\n", entry.name, entry.table->getFileSize(),
+                    directoryBytes(entry.directory));
+    }
+
+    for (bool local : {false, true}) {
+        std::vector<GameState> positions = makePositions(*rules, material, probes, local);
+        for (const auto& entry : formats) {
+            TablebaseCacheStats before = Tablebase::getCacheStats();
+            long long checksum = 0;
+            auto start = std::chrono::steady_clock::now();
+            for (const GameState& state : positions) {
+                TablebaseProbe probe = entry.table->probe(state);
+                checksum += probe.dtm + static_cast<int>(probe.wdl);
+            }
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            TablebaseCacheStats after = Tablebase::getCacheStats();
+            std::uint64_t lookups = after.hits + after.misses - before.hits - before.misses;
+            std::printf("%-6s probes, %-10s  %8.1f ns/probe", local ? "local" : "random", entry.name,
+                        seconds * 1e9 / positions.size());
+            if (lookups > 0) {
+                std::printf("   cache hit rate %5.1f%%", 100.0 * (after.hits - before.hits) / lookups);
+            }
+            std::printf("   (checksum %lld)\n", checksum);
+        }
+    }
+    return 0;
+}
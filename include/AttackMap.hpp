@@ -0,0 +1,87 @@
+#pragma once
+
+#include "GameState.hpp"
+#include "RuleSet.hpp"
+#include <cstdint>
+#include <initializer_list>
+
+// Set of squares of the compact board, one bit per square
+struct SquareSet {
+    std::uint64_t words[kMaxSquares / 64] = {};
+
+    bool test(int square) const { return (words[square >> 6] >> (square & 63)) & 1; }
+    void set(int square) { words[square >> 6] |= 1ULL << (square & 63); }
+    void reset(int square) { words[square >> 6] &= ~(1ULL << (square & 63)); }
+    void clear() { *this = SquareSet{}; }
+    bool empty() const { return (words[0] | words[1] | words[2] | words[3]) == 0; }
+
+    SquareSet& operator|=(const SquareSet& other) {
+        for (int i = 0; i < kMaxSquares / 64; ++i) words[i] |= other.words[i];
+        return *this;
+    }
+
+    // Call f(square) for every square in the set, in ascending order
+    template <typename F>
+    void forEach(F&& f) const {
+        for (int i = 0; i < kMaxSquares / 64; ++i) {
+            for (std::uint64_t bits = words[i]; bits != 0; bits &= bits - 1) {
+                f(i * 64 + __builtin_ctzll(bits));
+            }
+        }
+    }
+};
+
+// Per-color attack counts for every square of a GameState, kept up to date
+// incrementally.
+//
+// A square is attacked by a piece if the piece could capture there: along its
+// capture rays up to the first piece in the way (inclusive), and through open
+// portals the way the move generator teleports. Own pieces count as attacked
+// too (they are defended).
+//
+// For every occupied square the map stores the squares its piece attacks, and
+// for every square the pieces attacking it. After a move only the pieces on
+// the changed squares and the pieces whose attacks reach those squares (or
+// the entry of a portal that opened or closed) are recomputed, so a move
+// costs a handful of ray walks rather than a full rebuild.
+class AttackMap {
+public:
+    explicit AttackMap(const RuleSet& rules) : rules(rules) {}
+
+    // Compute everything from scratch
+    void build(const GameState& state);
+
+    // Bring the map in line with `state` after the pieces on `changed` moved,
+    // appeared or disappeared. Works the same after makeMove and unmakeMove.
+    void update(const GameState& state, const int* changed, int count);
+    void update(const GameState& state, std::initializer_list<int> changed) {
+        update(state, changed.begin(), static_cast<int>(changed.size()));
+    }
+
+    int getAttackCount(int square, Color by) const { return counts[colorIndex(by)][square]; }
+    bool isAttacked(int square, Color by) const { return counts[colorIndex(by)][square] != 0; }
+    const SquareSet& getAttacks(int square) const { return attacksFrom[square]; }
+    const SquareSet& getAttackers(int square) const { return attackedBy[square]; }
+
+    // True if any royal piece of the color is attacked (false if it has none)
+    bool isInCheck(Color color) const;
+
+    // Squares holding royal pieces of the color
+    const SquareSet& getRoyalSquares(Color color) const { return royals[colorIndex(color)]; }
+
+private:
+    const RuleSet& rules;
+    SquareSet attacksFrom[kMaxSquares];
+    SquareSet attackedBy[kMaxSquares];
+    std::uint8_t counts[2][kMaxSquares] = {};
+    SquareSet royals[2];
+    std::uint8_t codes[kMaxSquares] = {}; // Piece whose attacks are stored for each square
+    std::uint32_t openPortals = 0;        // Bit set for every portal not cooling down
+
+    std::uint32_t computeOpenPortals(const GameState& state) const;
+    void computeAttacks(const GameState& state, int square, SquareSet& attacks) const;
+    void addPortalAttacks(const GameState& state, int from, const MoveRay& ray, Color color, int entry,
+                          int remaining, bool master, SquareSet& attacks) const;
+    void refresh(const GameState& state, int square);
+    void refreshRoyal(const GameState& state, int square);
+};
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Byte-oriented LZ77 compression for small independent blocks (a few KB),
+// tuned for decompression speed rather than ratio.
+//
+// A block is a series of sequences: a token byte (literal count in the high
+// nibble, match length - 4 in the low nibble), extra length bytes for counts
+// of 15 or more, the literals, then a 2-byte little-endian match offset. The
+// last sequence has literals only. Matches may overlap their own output, so
+// long runs of one value cost a few bytes.
+namespace BlockCodec {
+    // Append the compressed form of `size` bytes to `out`
+    void compress(const std::uint8_t* input, std::size_t size, std::vector<std::uint8_t>& out);
+
+    // Decompress a block into exactly `outputSize` bytes. Returns false if
+    // the input is corrupt or does not decode to that size.
+    bool decompress(const std::uint8_t* input, std::size_t inputSize, std::uint8_t* output, std::size_t outputSize);
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "ChessBoard.hpp"
+#include "GameState.hpp"
+#include "RuleSet.hpp"
+#include <array>
+#include <cstdint>
+#include <ostream>
+#include <string_view>
+#include <vector>
+
+// How BoardRenderer draws a board:
+//  - Unicode: a grid with chess glyphs and file and rank labels on every
+//    side (what ChessBoard::displayBoard prints);
+//  - Ascii: a grid of letters, upper case for white, with aligned borders
+//    and rank labels on any board size;
+//  - Compact: one line per rank of letters, '.' for an empty square, and
+//    the files below.
+enum class BoardStyle : std::uint8_t { Unicode, Ascii, Compact };
+
+// Draws boards into a buffer that is kept from one board to the next, so
+// that once it has grown to the largest board drawn, rendering allocates
+// nothing and the text goes out in a single write. One per thread.
+class BoardRenderer {
+public:
+    explicit BoardRenderer(BoardStyle style = BoardStyle::Unicode) : style(style) {}
+
+    void setStyle(BoardStyle value) { style = value; }
+    BoardStyle getStyle() const { return style; }
+
+    // Draw a board, or a compact position of the given rules. The text stays
+    // valid until the next call.
+    std::string_view render(const ChessBoard& board);
+    std::string_view render(const RuleSet& rules, const GameState& state);
+
+    // Draw and write in one call
+    void write(std::ostream& os, const ChessBoard& board);
+    void write(std::ostream& os, const RuleSet& rules, const GameState& state);
+
+private:
+    BoardStyle style;
+    std::vector<char> buffer;
+
+    // Symbols of each piece code of the rules being drawn
+    std::array<std::string_view, kMaxPieceCodes> glyphs{};
+    std::array<char, kMaxPieceCodes> letters{};
+
+    template <typename Piece>
+    std::string_view draw(int size, const Piece& pieceAt);
+    void prepareSymbols(const RuleSet& rules);
+};
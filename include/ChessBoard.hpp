@@ -8,6 +8,7 @@
 #include <string>
 #include <vector>
 #include <optional>
+#include <string_view>
 
 class ChessBoard {
 public:
@@ -15,10 +16,13 @@ public:
     ~ChessBoard() = default;
     
     // Board state management
-    bool placePiece(std::unique_ptr<ChessPiece> piece, const Position& pos);
-    std::unique_ptr<ChessPiece> removePiece(const Position& pos);
+    bool placePiece(PiecePtr piece, const Position& pos);
+    PiecePtr removePiece(const Position& pos);
     const ChessPiece* getPieceAt(const Position& pos) const;
     
+    // Remove every piece, keeping the square storage for the next game
+    void clear();
+    
     // Movement
     bool movePiece(const Position& from, const Position& to);
     bool isMoveValid(const Position& from, const Position& to) const;
@@ -32,14 +36,18 @@ public:
     std::vector<std::pair<Position, const ChessPiece*>> getPiecesByColor(Color color) const;
     
     // Find a specific piece type
-    std::optional<Position> findPiece(const std::string& type, Color color) const;
+    std::optional<Position> findPiece(std::string_view type, Color color) const;
     
-    // Display
+    // Display as a Unicode grid in one write (see BoardRenderer for other
+    // styles)
     void displayBoard(std::ostream& os = std::cout) const;
     
 private:
-    // The board is represented as a hashmap from position to piece
-    // This provides O(1) lookups for any position
-    std::unordered_map<Position, std::unique_ptr<ChessPiece>> board;
+    // The board is represented as a flat array of squares indexed by
+    // y * size + x. This provides O(1) lookups for any position and, unlike a
+    // hashmap, needs no node allocation when pieces are placed or moved.
+    std::vector<PiecePtr> board;
     int size;
+    
+    int squareIndex(const Position& pos) const { return pos.y * size + pos.x; }
 };
\ No newline at end of file
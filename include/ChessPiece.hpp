@@ -2,46 +2,83 @@
 
 #include "Utilities.hpp"
 #include <string>
+#include <string_view>
 #include <memory>
+#include <memory_resource>
 #include <vector>
 #include <unordered_map>
 
+class ChessPiece;
+
+// Deleter for pieces created from a memory resource (see ChessPiece::createPiece).
+// Pieces living in a GameArena are only destroyed here; their memory is
+// reclaimed in bulk when the arena is released.
+struct PieceDeleter {
+    std::pmr::memory_resource* resource = nullptr;
+    std::size_t size = 0;
+    std::size_t alignment = alignof(std::max_align_t);
+
+    void operator()(ChessPiece* piece) const;
+};
+
+using PiecePtr = std::unique_ptr<ChessPiece, PieceDeleter>;
+
+// Hash that lets the property tables be queried with string literals and
+// string_views without building a temporary key string
+struct PropertyHash {
+    using is_transparent = void;
+    std::size_t operator()(std::string_view key) const { return std::hash<std::string_view>{}(key); }
+};
+
+using PropertyMap = std::pmr::unordered_map<std::pmr::string, int, PropertyHash, std::equal_to<>>;
+
 class ChessPiece {
 public:
-    ChessPiece(Color color, const std::string& type);
+    using allocator_type = std::pmr::polymorphic_allocator<>;
+
+    ChessPiece(Color color, std::string_view type, allocator_type alloc = {});
     virtual ~ChessPiece() = default;
     
     // Getters
     Color getColor() const { return color; }
-    std::string getType() const { return type; }
+    std::string_view getType() const { return type; }
     bool hasMoved() const { return moved; }
     
-    // Mark piece as moved
-    void setMoved() { moved = true; }
+    // Mark piece as moved (or as unmoved again when its move is taken back)
+    void setMoved(bool value = true) { moved = value; }
     
     // Movement validation
     virtual bool canMoveTo(const Position& from, const Position& to, 
                           const class ChessBoard& board) const = 0;
     
-    // Get symbol for display
-    virtual std::string getSymbol() const = 0;
+    // Get symbol for display: a Unicode glyph (static text, so drawing a
+    // board allocates nothing) and an ASCII letter, upper case for white
+    virtual std::string_view getSymbol() const = 0;
+    virtual char getLetter() const = 0;
     
     // Special abilities
-    bool hasSpecialAbility(const std::string& ability) const;
-    int getAbilityValue(const std::string& ability) const;
-    void setSpecialAbility(const std::string& ability, int value = 1);
+    bool hasSpecialAbility(std::string_view ability) const;
+    int getAbilityValue(std::string_view ability) const;
+    void setSpecialAbility(std::string_view ability, int value = 1);
     
-    // Factory method to create piece from type string
-    static std::unique_ptr<ChessPiece> createPiece(const std::string& type, Color color,
-                                              const std::unordered_map<std::string, int>& movement,
-                                              const std::unordered_map<std::string, int>& abilities);
+    // Factory method to create piece from type string. The piece and its
+    // property tables are allocated from the given resource (a GameArena for
+    // pooled games, the heap otherwise).
+    static PiecePtr createPiece(const std::string& type, Color color,
+                                const std::unordered_map<std::string, int>& movement,
+                                const std::unordered_map<std::string, int>& abilities,
+                                std::pmr::memory_resource* resource = std::pmr::get_default_resource());
 
 protected:
     Color color;
-    std::string type;
+    std::pmr::string type;
     bool moved;
-    std::unordered_map<std::string, int> specialAbilities;
-    std::unordered_map<std::string, int> movementProperties;
+    PropertyMap specialAbilities;
+    PropertyMap movementProperties;
+    
+    // Property table helpers (insert without temporary key strings)
+    int getMovementValue(std::string_view key) const;
+    void setMovementProperty(std::string_view key, int value);
     
     // Helper methods for movement validation
     bool isValidForwardMove(const Position& from, const Position& to, const ChessBoard& board) const;
@@ -54,44 +91,50 @@ protected:
 // Standard Chess Pieces
 class King : public ChessPiece {
 public:
-    King(Color color);
+    King(Color color, allocator_type alloc = {});
     bool canMoveTo(const Position& from, const Position& to, const ChessBoard& board) const override;
-    std::string getSymbol() const override;
+    std::string_view getSymbol() const override;
+    char getLetter() const override;
 };
 
 class Queen : public ChessPiece {
 public:
-    Queen(Color color);
+    Queen(Color color, allocator_type alloc = {});
     bool canMoveTo(const Position& from, const Position& to, const ChessBoard& board) const override;
-    std::string getSymbol() const override;
+    std::string_view getSymbol() const override;
+    char getLetter() const override;
 };
 
 class Rook : public ChessPiece {
 public:
-    Rook(Color color);
+    Rook(Color color, allocator_type alloc = {});
     bool canMoveTo(const Position& from, const Position& to, const ChessBoard& board) const override;
-    std::string getSymbol() const override;
+    std::string_view getSymbol() const override;
+    char getLetter() const override;
 };
 
 class Bishop : public ChessPiece {
 public:
-    Bishop(Color color);
+    Bishop(Color color, allocator_type alloc = {});
     bool canMoveTo(const Position& from, const Position& to, const ChessBoard& board) const override;
-    std::string getSymbol() const override;
+    std::string_view getSymbol() const override;
+    char getLetter() const override;
 };
 
 class Knight : public ChessPiece {
 public:
-    Knight(Color color);
+    Knight(Color color, allocator_type alloc = {});
     bool canMoveTo(const Position& from, const Position& to, const ChessBoard& board) const override;
-    std::string getSymbol() const override;
+    std::string_view getSymbol() const override;
+    char getLetter() const override;
 };
 
 class Pawn : public ChessPiece {
 public:
-    Pawn(Color color);
+    Pawn(Color color, allocator_type alloc = {});
     bool canMoveTo(const Position& from, const Position& to, const ChessBoard& board) const override;
-    std::string getSymbol() const override;
+    std::string_view getSymbol() const override;
+    char getLetter() const override;
 };
 
 // Custom piece implementation with configurable movement
@@ -99,7 +142,9 @@ class CustomPiece : public ChessPiece {
 public:
     CustomPiece(Color color, const std::string& type, 
                 const std::unordered_map<std::string, int>& movement,
-                const std::unordered_map<std::string, int>& abilities);
+                const std::unordered_map<std::string, int>& abilities,
+                allocator_type alloc = {});
     bool canMoveTo(const Position& from, const Position& to, const ChessBoard& board) const override;
-    std::string getSymbol() const override;
+    std::string_view getSymbol() const override;
+    char getLetter() const override;
 };
\ No newline at end of file
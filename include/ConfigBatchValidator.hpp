@@ -0,0 +1,56 @@
+#pragma once
+
+#include "ConfigReader.hpp"
+#include "ThreadPool.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Outcome of loading and validating one config file
+struct ConfigCheckResult {
+    std::string path;
+    bool valid = false;
+    std::string errors;     // Everything the reader reported, one per line
+    std::uint64_t bytes = 0;
+};
+
+struct ConfigBatchReport {
+    std::vector<ConfigCheckResult> results; // In the order the paths were given
+    std::size_t validCount = 0;
+    std::size_t invalidCount = 0;
+    std::uint64_t totalBytes = 0;
+    double seconds = 0;
+
+    double filesPerSecond() const { return seconds > 0 ? results.size() / seconds : 0; }
+    double megabytesPerSecond() const { return seconds > 0 ? totalBytes / seconds / (1024.0 * 1024.0) : 0; }
+};
+
+// Loads and validates many config files in parallel.
+//
+// Each pool worker owns a ConfigReader and an error buffer that live as long
+// as the validator, so the streaming parser's read buffer and the config's
+// vectors are reused from file to file and batch to batch.
+class ConfigBatchValidator {
+public:
+    // 0 threads means one per hardware thread
+    explicit ConfigBatchValidator(unsigned threads = 0);
+
+    ConfigBatchReport validateFiles(const std::vector<std::string>& paths);
+
+    // Every *.json file directly inside the directory, in name order
+    ConfigBatchReport validateDirectory(const std::string& directory);
+
+    unsigned getThreadCount() const { return pool.getThreadCount(); }
+
+private:
+    struct Worker {
+        ConfigReader reader;
+        std::ostringstream errors;
+    };
+
+    ThreadPool pool;
+    std::vector<std::unique_ptr<Worker>> workers;
+};
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "ConfigReader.hpp"
+#include "RuleSet.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+// A parsed, validated config together with everything built from it. Shared
+// read-only by every game of the variant.
+struct CompiledConfig {
+    std::uint64_t contentHash = 0;
+    std::string source;                   // The JSON text, to tell hash collisions from hits
+    GameConfig config;
+    std::shared_ptr<const RuleSet> rules; // nullptr if the config exceeds the rule table limits
+    std::size_t bytes = 0;                // Approximate memory held by this entry
+};
+
+// Process-wide cache of compiled configs keyed by a hash of the JSON text.
+//
+// A lookup for text that was seen before returns the shared entry without
+// parsing or compiling anything. The hash only finds the entry: its text
+// must match as well, so two configs whose hashes collide never share rules
+// (the later one is compiled and returned uncached). Entries are evicted
+// least recently used first once their total size exceeds the capacity;
+// games still holding an evicted entry keep it alive until they finish.
+// Invalid configs are not cached. Thread-safe; a miss is parsed outside the
+// lock.
+class ConfigCache {
+public:
+    struct Stats {
+        std::uint64_t hits = 0;
+        std::uint64_t misses = 0;
+        std::uint64_t evictions = 0;
+        std::size_t entries = 0;
+        std::size_t bytes = 0;
+        std::size_t capacityBytes = 0;
+    };
+
+    explicit ConfigCache(std::size_t capacityBytes = kDefaultCapacity);
+
+    // Shared cache used by the game server and tools
+    static ConfigCache& instance();
+
+    // Compiled config for the JSON text, or nullptr (with the reason on
+    // std::cerr) if it does not load
+    std::shared_ptr<const CompiledConfig> get(std::string_view json);
+
+    // Same, reading the text from a file first
+    std::shared_ptr<const CompiledConfig> getFile(const std::string& path);
+
+    Stats getStats() const;
+    void setCapacity(std::size_t capacityBytes);
+    void clear();
+
+    static constexpr std::size_t kDefaultCapacity = 64 * 1024 * 1024;
+
+private:
+    using Entry = std::shared_ptr<const CompiledConfig>;
+    using LruList = std::list<Entry>; // Most recently used first
+
+    mutable std::mutex mutex;
+    LruList lru;
+    std::unordered_map<std::uint64_t, LruList::iterator> index;
+    std::size_t capacity;
+    std::size_t bytes = 0;
+    std::uint64_t hits = 0;
+    std::uint64_t misses = 0;
+    std::uint64_t evictions = 0;
+
+    static Entry compile(std::string_view json, std::uint64_t contentHash);
+    void evictLocked();
+};
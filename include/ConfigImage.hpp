@@ -0,0 +1,54 @@
+#pragma once
+
+#include "ConfigReader.hpp"
+#include "RuleSet.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+// Precompiled config: a validated GameConfig together with its compiled
+// RuleSet, stored in one versioned, checksummed binary file.
+//
+// Opening an image maps the file read-only and uses the RuleSet in place, so
+// workers skip JSON parsing and rule compilation entirely. The GameConfig
+// part is stored as flat records and rebuilt on request.
+//
+// Images are tied to the build that wrote them: the version, byte order and
+// sizeof(RuleSet) are checked on open, and a mismatch means the image has to
+// be compiled again.
+class ConfigImage {
+public:
+    static constexpr char kMagic[8] = {'C', 'H', 'S', 'C', 'F', 'G', 'I', 'M'};
+    static constexpr std::uint32_t kVersion = 2;
+
+    ~ConfigImage();
+    ConfigImage(const ConfigImage&) = delete;
+    ConfigImage& operator=(const ConfigImage&) = delete;
+
+    // Write an image for a validated config. The file is written next to the
+    // target and renamed into place, so readers never see a partial image.
+    static bool write(const std::string& path, const GameConfig& config, const RuleSet& rules);
+
+    // Map an image. Returns nullptr (and reports the reason on std::cerr) if
+    // the file is missing, truncated, corrupt or from another version.
+    static std::shared_ptr<const ConfigImage> open(const std::string& path);
+
+    // True if the file starts with the image magic
+    static bool isImageFile(const std::string& path);
+
+    // Compiled rules, pointing into the mapped file
+    const RuleSet& getRules() const { return *rules; }
+
+    // Rebuild the GameConfig stored in the image
+    GameConfig toConfig() const;
+
+    std::size_t getSize() const { return size; }
+
+private:
+    ConfigImage(const std::uint8_t* data, std::size_t size);
+
+    const std::uint8_t* data;
+    std::size_t size;
+    const RuleSet* rules;
+};
@@ -1,6 +1,9 @@
 #pragma once
 
 #include "Utilities.hpp"
+#include <cstdint>
+#include <functional>
+#include <iosfwd>
 #include <memory>
 #include "nlohmann/json.hpp"
 #include <string>
@@ -8,6 +11,8 @@
 #include <vector>
 
 // Forward declarations
+class ConfigImage;
+struct RuleSet;
 struct Position;
 struct Movement;
 struct SpecialAbilities;
@@ -54,9 +59,9 @@ struct PieceConfig {
 
 // Properties for portals
 struct PortalProperties {
-  bool preserve_direction;
+  bool preserve_direction = true;
   std::vector<std::string> allowed_colors;
-  int cooldown;
+  int cooldown = 0;
 };
 
 // Configuration for a portal
@@ -85,23 +90,69 @@ struct GameConfig {
 
 class ConfigReader {
 public:
+  // Largest board a config may declare
+  static constexpr int kMaxConfigBoardSize = 1024;
+
   // Constructor
   ConfigReader();
 
+  // Where load and validation errors are reported (std::cerr by default)
+  void setErrorStream(std::ostream &errors);
+
   // Load configuration from a file
   bool loadFromFile(const std::string &filePath);
 
   // Load configuration from a JSON string
   bool loadFromString(const std::string &jsonString);
 
+  // Load configuration from an already parsed JSON document
+  bool loadFromJson(const nlohmann::json &jsonData);
+
+  // Load configuration from a file with the SAX parser, filling the config
+  // directly instead of building a JSON document first. Reads the same
+  // configs as loadFromFile, including text after the object being ignored.
+  bool loadFromFileStreaming(const std::string &filePath);
+
+  // Stream a catalog file (a JSON array of configs), validating each variant
+  // and passing it to onVariant. Only one variant is held in memory at a
+  // time; getConfig() returns the last one. Stops at the first invalid one.
+  bool loadCatalogFromFile(
+      const std::string &filePath,
+      const std::function<void(const GameConfig &)> &onVariant);
+
+  // Load a precompiled image written by compile_config. The compiled rules
+  // are used straight from the mapped file.
+  bool loadFromImage(const std::string &filePath);
+
   // Get the parsed configuration
   const GameConfig &getConfig() const;
 
-  // Validate the configuration
+  // Compiled rules of a loaded image, nullptr after a JSON load
+  std::shared_ptr<const RuleSet> getRuleSet() const;
+
+  // Validate the configuration. After the basic checks, piece placement is
+  // checked in one sweep over a square-occupancy bitmap and every conflict
+  // (overlapping or off-board pieces, occupied or shared portal entries) is
+  // reported, not just the first.
   bool validateConfig();
 
 private:
   GameConfig m_config;
+  std::shared_ptr<const ConfigImage> m_image;
+  std::vector<char> m_readBuffer;
+  std::ostream *m_errors;
+  std::vector<std::uint64_t> m_pieceSquares;
+  std::vector<std::uint64_t> m_portalSquares;
+
+  // Placement checks run at the end of validateConfig
+  bool validatePlacement();
+
+  // "King (white)" for the first piece configured on the square
+  std::string describeOccupant(const Position &pos) const;
+
+  // Run the SAX parser over a file, calling onVariant for each config
+  bool streamFile(const std::string &filePath, bool catalog,
+                  std::function<bool(GameConfig &)> onVariant);
 
   // Parse game settings from JSON
   void parseGameSettings(const nlohmann::json &json);
@@ -0,0 +1,114 @@
+#pragma once
+
+#include "ConfigReader.hpp"
+#include "nlohmann/json.hpp"
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+// SAX handler that fills a GameConfig straight from the parser events,
+// without building a JSON DOM first.
+//
+// The document is either a single config object or, in catalog mode, an
+// array of config objects. The same GameConfig is refilled for every variant
+// and handed to the callback when the variant's object closes, so memory use
+// does not grow with the size of the catalog. Returning false from the
+// callback stops the parse.
+//
+// Defaults, accepted keys and type errors match ConfigReader's DOM path, and
+// so do repeated keys: the last one wins.
+class ConfigSaxHandler {
+public:
+  using VariantCallback = std::function<bool(GameConfig &)>;
+
+  ConfigSaxHandler(GameConfig &config, bool catalog,
+                   VariantCallback onVariant);
+
+  // Empty when the parse was stopped by the callback
+  const std::string &getError() const { return m_error; }
+  std::size_t getVariantCount() const { return m_variants; }
+
+  // nlohmann::json SAX interface
+  bool null();
+  bool boolean(bool val);
+  bool number_integer(std::int64_t val);
+  bool number_unsigned(std::uint64_t val);
+  bool number_float(double val, const std::string &s);
+  bool string(std::string &val);
+  bool binary(nlohmann::json::binary_t &val);
+  bool start_object(std::size_t elements);
+  bool key(std::string &val);
+  bool end_object();
+  bool start_array(std::size_t elements);
+  bool end_array();
+  bool parse_error(std::size_t position, const std::string &last_token,
+                   const nlohmann::detail::exception &ex);
+
+private:
+  // Where the parser currently is
+  enum class Context : std::uint8_t {
+    Document,
+    Catalog,
+    Config,
+    Settings,
+    PieceList,
+    Piece,
+    PiecePositions,
+    PositionList,
+    Point,
+    Movement,
+    Abilities,
+    PortalList,
+    Portal,
+    PortalPositions,
+    PortalProperties,
+    ColorList,
+    Skip
+  };
+
+  // What the current key (or array element) expects
+  enum class Kind : std::uint8_t {
+    Unknown,       // Not a config field, skipped
+    String,
+    Int,
+    Bool,
+    CustomAbility, // Kept if boolean, ignored otherwise
+    Object,        // Other types are an error
+    OptionalObject, // Other types are ignored
+    OptionalArray  // Other types are ignored
+  };
+
+  struct Field {
+    Kind kind = Kind::Unknown;
+    Context opens = Context::Skip;
+    std::string *text = nullptr;
+    int *number = nullptr;
+    bool *flag = nullptr;
+  };
+
+  GameConfig &m_config;
+  bool m_catalog;
+  VariantCallback m_onVariant;
+  std::vector<Context> m_stack;
+  std::string m_key;
+  std::string m_error;
+  std::size_t m_variants = 0;
+
+  // Objects being filled
+  std::vector<PieceConfig> *m_pieceList = nullptr;
+  PieceConfig *m_piece = nullptr;
+  std::string m_positionColor;
+  std::vector<Position> *m_positionList = nullptr;
+  Position *m_point = nullptr;
+  PortalConfig *m_portal = nullptr;
+  bool m_sawAllowedColors = false;
+
+  Field currentField();
+  bool openContainer(bool isObject);
+  bool storeInt(std::int64_t val);
+  bool typeError(const char *found);
+  void defaultSettings();
+  void beginConfig();
+  void resetField();
+};
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// 64-bit hash of a byte range, computed over 32-byte blocks in four
+// independent lanes so it runs at memory speed. Used for config image
+// checksums and config cache keys; not a cryptographic hash.
+inline std::uint64_t hashBytes(const void* data, std::size_t length) {
+    constexpr std::uint64_t kPrime1 = 0x9E3779B185EBCA87ULL;
+    constexpr std::uint64_t kPrime2 = 0xC2B2AE3D27D4EB4FULL;
+    auto round = [](std::uint64_t acc, std::uint64_t word) {
+        acc += word * kPrime2;
+        acc = (acc << 31) | (acc >> 33);
+        return acc * kPrime1;
+    };
+
+    const auto* bytes = static_cast<const std::uint8_t*>(data);
+    std::uint64_t lanes[4] = {kPrime1 + kPrime2, kPrime2, 0, 0 - kPrime1};
+    std::size_t offset = 0;
+    for (; offset + 32 <= length; offset += 32) {
+        for (int lane = 0; lane < 4; ++lane) {
+            std::uint64_t word;
+            std::memcpy(&word, bytes + offset + lane * 8, 8);
+            lanes[lane] = round(lanes[lane], word);
+        }
+    }
+    std::uint64_t hash = length;
+    for (std::uint64_t lane : lanes) {
+        hash = round(hash ^ lane, lane);
+    }
+    for (; offset < length; ++offset) {
+        hash = round(hash, bytes[offset]);
+    }
+    hash ^= hash >> 29;
+    hash *= kPrime1;
+    return hash ^ (hash >> 32);
+}
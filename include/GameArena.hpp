@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <optional>
+
+// Memory resource that forwards to an upstream resource and counts every
+// request that reaches it. Used as the upstream of GameArena so the number of
+// real heap allocations made on behalf of a game can be observed.
+class CountingResource : public std::pmr::memory_resource {
+public:
+    explicit CountingResource(std::pmr::memory_resource* upstream = std::pmr::new_delete_resource())
+        : upstream(upstream) {}
+
+    std::size_t getAllocations() const { return allocations; }
+    std::size_t getDeallocations() const { return deallocations; }
+    std::size_t getBytesAllocated() const { return bytesAllocated; }
+
+private:
+    std::pmr::memory_resource* upstream;
+    std::size_t allocations = 0;
+    std::size_t deallocations = 0;
+    std::size_t bytesAllocated = 0;
+
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override;
+    void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override;
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+};
+
+// Per-game bump allocator for pieces and their property tables.
+//
+// Everything allocated from resource() is released in one operation by
+// release(). The arena keeps its initial buffer between games; if a game
+// overflowed it, the buffer is grown on release so that the next game with
+// the same setup is served entirely from the buffer (zero heap allocations).
+class GameArena {
+public:
+    struct Stats {
+        std::size_t upstreamAllocations; // Heap allocations made since construction
+        std::size_t upstreamBytes;       // Heap bytes requested since construction
+        std::size_t bufferSize;          // Current size of the reusable buffer
+        std::size_t releases;            // Number of completed release() calls
+    };
+
+    explicit GameArena(std::size_t initialBytes = 16 * 1024);
+    ~GameArena() = default;
+
+    GameArena(const GameArena&) = delete;
+    GameArena& operator=(const GameArena&) = delete;
+
+    std::pmr::memory_resource* resource() { return &*arena; }
+
+    // Drop every allocation made since the last release
+    void release();
+
+    Stats getStats() const;
+
+private:
+    CountingResource upstream;
+    std::unique_ptr<std::byte[]> buffer;
+    std::size_t bufferSize;
+    std::size_t releases = 0;
+    std::size_t bytesAtLastRelease = 0;
+    std::optional<std::pmr::monotonic_buffer_resource> arena;
+};
@@ -0,0 +1,98 @@
+#pragma once
+
+#include "AttackMap.hpp"
+#include "GameRecord.hpp"
+#include "GameState.hpp"
+#include "MoveGenerator.hpp"
+#include "RuleSet.hpp"
+#include "SanNotation.hpp"
+#include "ThreadPool.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Totals of one GameImporter::import
+struct GameImportStats {
+    std::uint64_t games = 0;        // Written to the archive
+    std::uint64_t skipped = 0;      // Games with a move that could not be read or played
+    std::uint64_t moves = 0;
+    std::uint64_t bytes = 0;        // Text read
+    double seconds = 0;
+};
+
+// Converts PGN-style text archives into a GameRecordWriter archive.
+//
+// A game is a tag section ([Name "value"] lines) followed by movetext:
+// move numbers, moves in SanNotation, {comments}, ; comments, $NAGs and
+// (variations), which are skipped, and a termination marker (1-0, 0-1,
+// 1/2-1/2 or *) that gives the result. Games with a FEN tag for another
+// position than the start are skipped, as are games with a move that does
+// not resolve to exactly one legal move; the first few reasons go to
+// std::cerr with their line numbers.
+//
+// The file is read in chunks cut after a termination marker or before a
+// tag section that follows movetext (never inside a comment or variation),
+// which the pool parses in parallel. Games
+// reach the archive in file order. Memory stays at about two chunks per
+// thread, whatever the size of the input; a chunk only grows past the
+// chunk size for a single game longer than that.
+class GameImporter {
+public:
+    static constexpr std::size_t kDefaultChunkSize = 1 << 20;
+    static constexpr int kMaxReported = 20;
+
+    // 0 threads means one per hardware thread
+    GameImporter(const RuleSet& rules, unsigned threads = 0, std::size_t chunkSize = kDefaultChunkSize);
+
+    // Import every game of a text file into `archive`, adding to `stats`.
+    // Returns false (with the reason on std::cerr) if the file cannot be
+    // read or the archive cannot be written; bad games only count as
+    // skipped.
+    bool import(const std::string& path, GameRecordWriter& archive, GameImportStats& stats);
+
+    unsigned getThreadCount() const { return pool.getThreadCount(); }
+
+private:
+    // A game read from a chunk: its moves are indices[first, first + plies)
+    struct ParsedGame {
+        GameResult result;
+        std::size_t first;
+        std::size_t plies;
+    };
+
+    struct ImportError {
+        std::size_t offset;         // In the chunk text
+        std::string message;
+    };
+
+    struct Chunk {
+        std::string text;
+        std::vector<std::uint32_t> indices;
+        std::vector<ParsedGame> games;
+        std::vector<ImportError> errors;    // Up to kMaxReported
+        std::uint64_t skipped = 0;
+        std::size_t lines = 0;
+    };
+
+    struct Worker {
+        explicit Worker(const RuleSet& rules) : generator(rules), attacks(rules), san(rules) {}
+
+        MoveGenerator generator;
+        GameState state;
+        GameState tagState;         // Position of a FEN tag
+        AttackMap attacks;
+        SanNotation san;
+    };
+
+    const RuleSet& rules;
+    std::size_t chunkSize;
+    ThreadPool pool;
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::vector<Chunk> chunks;
+    GameState startState;
+
+    void parseChunk(Worker& worker, Chunk& chunk) const;
+};
@@ -1,30 +1,162 @@
 #pragma once
 
 #include "ChessBoard.hpp"
+#include "ConfigCache.hpp"  // Shared compiled configs
 #include "ConfigReader.hpp" // For GameConfig, Movement, SpecialAbilities
 #include "ChessPiece.hpp"   // For ChessPiece::createPiece and Color enum
+#include "GameArena.hpp"    // Per-game storage for pieces
+#include "GameState.hpp"    // Compact position for the move generator
+#include "MoveGenerator.hpp"  // Move validation and make/unmake
+#include "OpeningBook.hpp"
+#include "PortalSystem.hpp"
+#include "RuleSet.hpp"
+#include "Search.hpp"
+#include <iostream>
 #include <memory>           // For std::unique_ptr if we choose to use it for board_
+#include <optional>
+#include <random>
 #include <vector>
 #include <string>
 #include <unordered_map>   // For the helper maps in piece creation
 
+// How a game stands after the last move. A turn is one move by one player
+// (the unit portal cooldowns are counted in); a game that reaches the
+// config's turn_limit is drawn.
+enum class GameStatus {
+    Ongoing,
+    Checkmate,  // The player to move is in check and has no legal move
+    Stalemate,  // The player to move is not in check but has no legal move
+    TurnLimit
+};
+
 class GameManager {
 public:
-    GameManager(const GameConfig& config);
+    // Rules are compiled from the config unless precompiled ones are given
+    // (e.g. from a config image)
+    explicit GameManager(const GameConfig& config, std::shared_ptr<const RuleSet> rules = nullptr);
+
+    // Game of a cached variant: the config and rules are shared with every
+    // other game of it and kept alive by this game
+    explicit GameManager(std::shared_ptr<const CompiledConfig> compiled);
     ~GameManager() = default;
 
+    // Set up the starting position. Calling it again resets the game; once
+    // the arena has grown to fit the setup, a reset makes no heap allocations.
     void initializeGame();
     void displayBoard() const;
     
-    // Future methods:
-    // void runGame();
-    // bool processMove(const Position& from, const Position& to);
-    // bool isGameOver() const;
-    // Color getCurrentPlayer() const;
+    // Allocation counters for the per-game arena
+    GameArena::Stats getArenaStats() const { return arena_.getStats(); }
+    
+    const ChessBoard& getBoard() const { return board_; }
+    const PortalSystem& getPortalSystem() const { return portals_; }
+    
+    // Compiled rules and compact position for the move generator (rules are
+    // null if the config exceeds the generator's limits)
+    const RuleSet* getRules() const { return rules_.get(); }
+    const GameState& getState() const { return state_; }
+    
+    // Refresh the compact position from the board and portals (keeping the
+    // turn count), or rebuild the board and portal cooldowns from a compact
+    // position (taking its turn count). Both fail if there are no compiled
+    // rules.
+    bool captureState(Color sideToMove);
+    bool restoreState(const GameState& state);
+    
+    // Play a game from the current position, reading one move per line
+    // ("e2 e4" or "e2e4"; files a-p, ranks 1-16), or "go" to let the
+    // computer move, until it is over or the input ends
+    void runGame(std::istream& in = std::cin, std::ostream& out = std::cout);
+
+    // Opening book for computer moves, or nullptr for none
+    void setOpeningBook(std::shared_ptr<const OpeningBook> book) { book_ = std::move(book); }
+
+    // Play a move for the current player chosen by the computer: a book move
+    // if the opening book has one for the position, else the best move a
+    // search finds within `limits`. `fromBook` tells which it was. Returns
+    // false when the game is over or there are no compiled rules.
+    bool playEngineMove(const SearchLimits& limits = SearchLimits{}, bool* fromBook = nullptr);
+
+    // Play a move for the current player if it is legal: the board and the
+    // compact position are updated, portal cooldowns tick, an undo record is
+    // pushed and the game status is refreshed. A move without a portal id
+    // that can only be reached through a portal uses that portal; pawns
+    // promote to the first promotion kind. Returns false (changing nothing)
+    // for an illegal move or when the game is over. Makes no heap
+    // allocations once the history has grown to the turn limit.
+    bool processMove(const Position& from, const Position& to);
+    bool processMove(const Move& move);
+
+    // Take back the last move: only the squares it changed are put back, and
+    // a piece it captured is created again from the game's arena (whose
+    // memory comes back at the next reset). Returns false if there is none.
+    bool undoMove();
+
+    // Legal moves of the current player (none if the rules could not be
+    // compiled). The position is left unchanged.
+    void getLegalMoves(MoveList& moves);
+
+    bool isGameOver() const { return status_ != GameStatus::Ongoing; }
+    GameStatus getStatus() const { return status_; }
+    Color getCurrentPlayer() const { return state_.sideToMove; }
+    // Turns played since the start of the game, including those before a
+    // restored position
+    int getTurnCount() const { return state_.ply; }
 
 private:
+    // Piece placement prepared once from the config so that resets do not
+    // rebuild the movement/ability maps for every piece
+    struct PieceSetup {
+        std::string type;
+        Color color;
+        Position position;
+        std::size_t propertiesIndex; // Index into pieceProperties_
+        bool custom;
+    };
+
+    // Config entry of a compiled piece kind, for pieces created mid-game
+    // (promotions, captures taken back)
+    struct KindSetup {
+        const std::string* type;
+        std::size_t propertiesIndex; // Index into pieceProperties_
+    };
+
+    // Everything needed to take a move back
+    struct HistoryEntry {
+        EngineMove move;
+        UndoInfo undo;
+        PortalCooldownUndo portalUndo; // portalIndex is -1 if no portal was used
+    };
+
     const GameConfig& gameConfig_; // Store a reference to the loaded configuration
+    std::shared_ptr<const CompiledConfig> compiled_; // Owner of gameConfig_ for cached variants
+    GameArena arena_;              // Must outlive board_: pieces live in it
     ChessBoard board_;             // GameManager owns the board
+    PortalSystem portals_;
+    std::shared_ptr<const RuleSet> rules_;
+    GameState state_;
+    std::optional<MoveGenerator> generator_;   // Engaged whenever rules_ is set
+    std::unique_ptr<AttackMap> attacks_;       // Kept in step with state_
+    std::shared_ptr<const OpeningBook> book_;
+    std::unique_ptr<Search> search_;           // Created on the first computer move
+    std::mt19937_64 random_{std::random_device{}()};  // Picks among book moves
+    std::vector<HistoryEntry> history_;
+    std::vector<PortalExpiry> cooldownUndo_;   // Portal expiries of the moves in history_
+    GameStatus status_ = GameStatus::Ongoing;
+    std::vector<PieceSetup> pieceSetup_;
+    std::vector<KindSetup> kindSetup_;         // Indexed by compiled piece kind
+    std::vector<std::pair<std::unordered_map<std::string, int>, std::unordered_map<std::string, int>>> pieceProperties_;
+    
+    void preparePieceSetup();
+    void preparePortals();
+    bool resolvePieceKinds();
+    PiecePtr createPiece(int kind, Color color);
+    PiecePtr createPiece(std::string_view type, Color color);
+    void startFromState();
+    void playMove(const EngineMove& move);
+    void applyToBoard(const EngineMove& move);
+    void undoOnBoard(const EngineMove& move, const UndoInfo& undo);
+    void updateStatus();
 
     // Helper to convert config structs to maps needed for piece creation
     // This is similar to the lambda previously in main.cpp
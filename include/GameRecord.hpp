@@ -0,0 +1,146 @@
+#pragma once
+
+#include "AttackMap.hpp"
+#include "GameState.hpp"
+#include "MoveGenerator.hpp"
+#include "RuleSet.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+enum class GameResult : std::uint8_t { WhiteWin, BlackWin, Draw, Unknown };
+
+// Archive of games of one variant, every game played from the starting
+// position.
+//
+// Layout (little endian): a header with the content hash of the config and
+// the game count, then one record per game: a varint byte count of the rest
+// of the record, the result byte, a varint ply count and, per ply, the
+// varint index of the move played in MoveGenerator::generate's list for the
+// position. Most moves take one byte. Only legal moves are written, but the
+// index is into the pseudo-legal list so that replaying a game needs no
+// legality checks. Indices only mean something under the same rules, hence
+// the config hash.
+//
+// GameRecordWriter appends games through an in-memory buffer that is
+// written out when full. Thread-safe.
+class GameRecordWriter {
+public:
+    static constexpr char kMagic[8] = {'C', 'H', 'S', 'G', 'A', 'M', 'E', 'S'};
+    static constexpr std::uint32_t kVersion = 1;
+
+    explicit GameRecordWriter(const RuleSet& rules);
+    ~GameRecordWriter();
+    GameRecordWriter(const GameRecordWriter&) = delete;
+    GameRecordWriter& operator=(const GameRecordWriter&) = delete;
+
+    // Start a new archive, or append to an existing one written for the
+    // same config. Returns false (with the reason on std::cerr) if the file
+    // cannot be created or belongs to another config.
+    bool open(const std::string& path, std::uint64_t configHash);
+
+    // Append a game given as EngineMove::pack() values. Returns false
+    // (writing nothing) if a move is not legal in its position.
+    bool write(GameResult result, const std::uint32_t* moves, std::size_t count);
+    bool write(GameResult result, const std::vector<std::uint32_t>& moves) {
+        return write(result, moves.data(), moves.size());
+    }
+
+    // Append a game given as the index of each move in MoveGenerator::generate's
+    // list for its position, from a caller that has replayed the game
+    // already (an importer). The indices are not checked.
+    bool writeIndices(GameResult result, const std::uint32_t* indices, std::size_t count);
+
+    // Flush the buffer and update the header's game count. Returns false if
+    // any write failed.
+    bool close();
+
+    std::uint64_t getGameCount() const { return count; }
+
+private:
+    static constexpr std::size_t kBufferSize = 1 << 20;
+
+    const RuleSet& rules;
+    MoveGenerator generator;
+    AttackMap attacks;
+    GameState state;
+    std::unique_ptr<MoveList> moves;
+    std::vector<std::uint8_t> record;   // Encoding of the game being written
+    std::vector<std::uint8_t> buffer;
+    std::FILE* file = nullptr;
+    std::mutex mutex;
+    std::uint64_t count = 0;
+    bool failed = false;
+
+    bool flush();
+    void appendRecord();
+};
+
+// One game of an archive, pointing into the mapped file
+struct GameRecordView {
+    GameResult result = GameResult::Unknown;
+    std::uint32_t plies = 0;
+    const std::uint8_t* moves = nullptr;    // Varint move indices
+    const std::uint8_t* end = nullptr;
+};
+
+// An archive mapped read-only. Games are read in place, without copying.
+// Thread-safe.
+class GameRecordReader {
+public:
+    ~GameRecordReader();
+    GameRecordReader(const GameRecordReader&) = delete;
+    GameRecordReader& operator=(const GameRecordReader&) = delete;
+
+    // Map an archive. Returns nullptr (and reports the reason on std::cerr)
+    // if the file is missing or not an archive of this version.
+    static std::shared_ptr<const GameRecordReader> open(const std::string& path);
+
+    // Game at byte `offset` (start at 0), moving `offset` to the next one.
+    // Returns false at the end of the archive or at a damaged record.
+    bool next(std::size_t& offset, GameRecordView& game) const;
+
+    std::uint64_t getConfigHash() const { return configHash; }
+    std::uint64_t getGameCount() const { return gameCount; }    // As stored in the header
+    std::size_t getSize() const { return size; }
+
+private:
+    GameRecordReader(const std::uint8_t* data, std::size_t size) : data(data), size(size) {}
+
+    const std::uint8_t* data;
+    std::size_t size;
+    const std::uint8_t* records = nullptr;
+    std::size_t recordBytes = 0;
+    std::uint64_t configHash = 0;
+    std::uint64_t gameCount = 0;
+};
+
+// Plays the moves of a recorded game on a GameState, without an AttackMap
+// (build one from getState() where needed). One per thread.
+class GameReplayer {
+public:
+    explicit GameReplayer(const RuleSet& rules);
+
+    // Set up the starting position for a game
+    void start(const GameRecordView& game);
+
+    // Decode and play the next move. Returns false when the game is over or
+    // the move index does not fit the position (a damaged record, or other
+    // rules).
+    bool next(EngineMove& move);
+
+    const GameState& getState() const { return state; }
+
+private:
+    const RuleSet& rules;
+    MoveGenerator generator;
+    GameState state;
+    std::unique_ptr<MoveList> moves;
+    const std::uint8_t* cursor = nullptr;
+    const std::uint8_t* end = nullptr;
+    std::uint32_t remaining = 0;
+};
@@ -0,0 +1,110 @@
+#pragma once
+
+#include "ConfigCache.hpp"
+#include "MpscQueue.hpp"
+#include "Utilities.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// Request forwarded from the I/O thread to the shard owning a game
+struct ServerRequest {
+    enum class Kind : std::uint8_t { New, Move, Moves, Undo, Status, End };
+
+    Kind kind = Kind::New;
+    std::uint32_t connection = 0;
+    std::uint64_t game = 0;
+    Position from;
+    Position to;
+};
+
+// Reply from a shard, written back to the connection by the I/O thread
+struct ServerResponse {
+    std::uint32_t connection = 0;
+    std::string text;
+};
+
+// Hosts many independent games of one variant in a single process.
+//
+// Games are sharded over a fixed set of worker threads by id (game id modulo
+// the shard count) and only ever touched by their shard, so playing a move
+// takes no lock. One I/O thread (the one calling run()) accepts connections,
+// parses request lines and hands them to the shards through lock-free MPSC
+// queues; replies come back the same way and are written out by the I/O
+// thread.
+//
+// Line protocol, one request per line, every reply naming the game so that
+// requests for different games can be pipelined:
+//   NEW                      -> OK <id>
+//   MOVE <id> <from> <to>    -> OK <id> <status>          e.g. MOVE 7 e2 e4
+//   MOVES <id>               -> OK <id> <move>...         e.g. OK 7 e2e4 d2d4
+//   UNDO <id>                -> OK <id> <status>
+//   STATUS <id>              -> OK <id> <white|black> <turn> <status>
+//   END <id>                 -> OK <id>
+//   STATS                    -> OK games <n> shards <n> connections <n>
+//   QUIT                        closes the connection
+// Status is one of ongoing, checkmate, stalemate, turn_limit. Errors are
+// reported as "ERR [<id>] <reason>". Replies for one game come in request
+// order; replies for different games may interleave.
+//
+// The I/O thread never waits on a shard: a request finding its shard's
+// queue full is answered "ERR [<id>] busy" and may be sent again. A client
+// that lets its replies pile up is not read from until it catches up, and
+// is dropped if they keep growing.
+class GameServer {
+public:
+    // 0 shards means one per hardware thread
+    explicit GameServer(std::shared_ptr<const CompiledConfig> variant, unsigned shards = 0);
+    ~GameServer();
+    GameServer(const GameServer&) = delete;
+    GameServer& operator=(const GameServer&) = delete;
+
+    // Listen on a Unix socket (an existing socket file is replaced) or on a
+    // TCP port of the loopback interface. Report failures on std::cerr.
+    bool listenUnix(const std::string& path);
+    bool listenTcp(int port);
+
+    // Serve connections on the calling thread until stop() is called
+    void run();
+
+    // Make run() return. Safe from any thread and from signal handlers.
+    void stop();
+
+    unsigned getShardCount() const { return static_cast<unsigned>(shards.size()); }
+    std::size_t getGameCount() const { return gameCount.load(std::memory_order_relaxed); }
+
+private:
+    struct Shard;
+    struct Connection;
+
+    std::shared_ptr<const CompiledConfig> variant;
+    std::vector<std::unique_ptr<Shard>> shards;
+    MpscQueue<ServerResponse> responses;
+    std::vector<int> listeners;
+    std::unordered_map<std::uint32_t, std::unique_ptr<Connection>> connections;
+    std::string unixPath;
+    int wakeFd = -1;                    // eventfd: responses waiting or stop requested
+    std::atomic<bool> wakePending{false};
+    std::atomic<bool> stopping{false};
+    std::atomic<std::size_t> gameCount{0};
+    std::uint32_t nextConnection = 1;
+    std::uint64_t nextGame = 1;
+    std::size_t inFlight = 0;           // Requests dispatched and not yet answered (I/O thread)
+
+    void shardLoop(Shard& shard);
+    void handleRequest(Shard& shard, ServerRequest& request, ServerResponse& response);
+    void respond(ServerResponse&& response);
+    bool dispatch(ServerRequest&& request);
+    void drainResponses();
+    void acceptConnections(int listener);
+    bool readConnection(std::uint32_t id, Connection& connection);
+    void handleLine(std::uint32_t connection, std::string_view line);
+    void sendReply(std::uint32_t connection, std::string text);
+    bool flushConnection(Connection& connection);
+};
@@ -0,0 +1,93 @@
+#pragma once
+
+#include "ChessPiece.hpp"
+#include "RuleSet.hpp"
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+class ChessBoard;
+class PortalSystem;
+
+// No en-passant square. Square 255 is the far corner of a 16x16 board, which
+// can never be an en-passant target.
+constexpr std::uint8_t kNoSquare = 0xFF;
+
+// Compact game position used by the move generator: one byte per square,
+// one bit per unmoved piece (castling and first-move rights), the en-passant
+// target, remaining cooldown per portal and the Zobrist hash of all of it.
+//
+// The struct is trivially copyable and a few hundred bytes, so search and
+// rollouts can copy a position instead of unmaking a move.
+struct GameState {
+    std::uint8_t squares[kMaxSquares];
+    std::uint64_t unmoved[kMaxSquares / 64];
+    std::uint8_t cooldowns[kMaxPortals];
+    std::uint64_t hash;
+    std::uint16_t ply;
+    Color sideToMove;
+    std::uint8_t epSquare;
+
+    // Creates the piece for a kind name when a state is written to a board
+    using PieceFactory = std::function<PiecePtr(std::string_view type, Color color)>;
+
+    // Starting position of a rule set
+    void reset(const RuleSet& rules);
+
+    // Read the position of a board (and the cooldowns of its portals, which
+    // must be in rule set order). Returns false, leaving the state
+    // unspecified, if the board holds a piece type the rules do not know.
+    bool loadFromBoard(const RuleSet& rules, const ChessBoard& board, Color toMove,
+                       const PortalSystem* portals = nullptr);
+
+    // Replace the board's pieces with this position. Portal cooldowns are
+    // copied into the portal system if one is given.
+    bool storeToBoard(const RuleSet& rules, ChessBoard& board, const PieceFactory& createPiece,
+                      PortalSystem* portals = nullptr) const;
+
+    // FEN: the six standard fields, and a seventh for portals.
+    //  1. Placement, top rank first, ranks separated by '/': a piece is its
+    //     kind's letter (upper case for white, lower case for black), a run
+    //     of empty squares its length (up to 16).
+    //  2. Side to move, 'w' or 'b'.
+    //  3. Castling rights, '-' if none: 'K' and 'Q' for the outermost
+    //     castling partner on the king's and queen's side, other partners by
+    //     file letter as in X-FEN, lower case for black. Each may be listed
+    //     once. Other pieces count as unmoved (first-move rights) exactly
+    //     when they stand on their starting square.
+    //  4. En-passant target square or '-'.
+    //  5. Halfmove clock. Not tracked: written as 0, read and dropped.
+    //  6. Fullmove number, starting at 1.
+    //  7. Remaining portal cooldowns in rule set order, comma separated
+    //     ("0,2,0"). Only written while a portal is cooling down.
+    // Fields 5 to 7 may be left out when reading. The start position of
+    // standard chess reads
+    // "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1".
+    static constexpr std::size_t kMaxFenLength = 1200;
+
+    // Write the position into `out` without a terminating zero, in one pass.
+    // Returns the length, or 0 if it needs more than `capacity` characters
+    // or the position cannot be written: a piece kind without a letter
+    // (variants with more than 26 kinds), or an unmoved castling partner on
+    // the K file that is not the outermost one.
+    std::size_t writeFen(const RuleSet& rules, char* out, std::size_t capacity) const;
+    std::string toFen(const RuleSet& rules) const;
+
+    // Read a position in one pass, without allocating. Returns false (with
+    // the reason on std::cerr), leaving the state unspecified, if the text
+    // is malformed or does not fit the rules.
+    bool readFen(const RuleSet& rules, std::string_view text);
+
+    // Hash computed from scratch (the generator keeps `hash` up to date)
+    std::uint64_t computeHash(const RuleSet& rules) const;
+
+    bool isUnmoved(int square) const { return (unmoved[square >> 6] >> (square & 63)) & 1; }
+    void setUnmoved(int square) { unmoved[square >> 6] |= 1ULL << (square & 63); }
+    void clearUnmoved(int square) { unmoved[square >> 6] &= ~(1ULL << (square & 63)); }
+};
+
+static_assert(std::is_trivially_copyable_v<GameState>, "GameState is copied with memcpy");
+static_assert(sizeof(GameState) <= 512, "GameState should stay cheap to copy");
@@ -0,0 +1,117 @@
+#pragma once
+
+#include "AttackMap.hpp"
+#include "GameState.hpp"
+#include "MoveGenerator.hpp"
+#include "RuleSet.hpp"
+#include "ThreadPool.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <vector>
+
+// Budget for one MCTS search
+struct MctsLimits {
+    std::uint64_t playouts = 10000;
+    int rolloutPlies = 80;          // Random plies per rollout before it is scored a draw
+    double exploration = 1.4;       // UCT exploration constant
+};
+
+struct MctsResult {
+    EngineMove move{};              // All zero if the side to move has no legal move
+    double winRate = 0;             // Of the chosen move for the side to move, draws counting half
+    std::uint32_t visits = 0;       // Playouts through the chosen move
+    std::uint64_t playouts = 0;
+    std::size_t nodes = 0;          // Arena nodes used
+};
+
+// Monte Carlo tree search with UCT selection and random rollouts, for
+// variants where the alpha-beta Search's evaluation knows nothing useful
+// (custom pieces, portals). Needs no evaluation at all: a playout is scored
+// by how its random game ended, a draw if it runs past the rollout limit.
+//
+// Tree parallelism: all threads descend the same tree. Every node a thread
+// passes gets a virtual loss until the playout is backed up, steering the
+// other threads to different lines; node statistics are relaxed atomics.
+// A node is expanded (all legal moves at once) on its second visit by
+// whichever thread claims it first.
+//
+// Nodes live in an arena allocated once, so searches allocate nothing. When
+// the arena is full the tree stops growing and playouts start from its
+// leaves. Each thread keeps its own state, attack map and move buffers.
+class Mcts {
+public:
+    // 0 threads means one per hardware thread; with 1 the search runs on the
+    // calling thread
+    Mcts(const RuleSet& rules, unsigned threads = 1, std::size_t nodeCapacity = 1 << 20);
+
+    MctsResult think(const GameState& state, const MctsLimits& limits);
+
+    unsigned getThreadCount() const { return static_cast<unsigned>(workers.size()); }
+
+    // Seed the per-thread random generators, for reproducible searches
+    void seed(std::uint64_t value);
+
+private:
+    static constexpr std::uint8_t kUnexpanded = 0;
+    static constexpr std::uint8_t kExpanding = 1;
+    static constexpr std::uint8_t kExpanded = 2;
+    static constexpr std::uint8_t kLeaf = 3;     // Arena was full: never expanded
+    static constexpr int kMaxPath = 1024;
+
+    struct Node {
+        std::atomic<std::uint32_t> visits{0};
+        std::atomic<std::uint32_t> virtualLoss{0};
+        std::atomic<std::uint64_t> score{0};     // Half points for the side that moved into the node
+        std::uint32_t firstChild = 0;            // Published by `expansion`
+        std::uint16_t childCount = 0;
+        std::atomic<std::uint8_t> expansion{kUnexpanded};
+        std::uint32_t move = 0;                  // EngineMove::pack() of the move into the node
+    };
+
+    struct PathEntry {
+        std::uint32_t node;
+        EngineMove move;
+        Color mover;
+        UndoInfo undo;
+    };
+
+    struct Worker {
+        explicit Worker(const RuleSet& rules) : attacks(rules) {}
+
+        GameState state;
+        AttackMap attacks;
+        MoveList moves;
+        std::mt19937_64 rng;
+        std::unique_ptr<PathEntry[]> path = std::make_unique<PathEntry[]>(kMaxPath);
+    };
+
+    const RuleSet& rules;
+    MoveGenerator generator;
+    std::unique_ptr<Node[]> nodes;
+    std::size_t capacity;
+    std::atomic<std::size_t> nodeCount{0};
+    std::atomic<std::uint64_t> playoutsStarted{0};
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::unique_ptr<ThreadPool> pool;
+
+    void playouts(Worker& worker, const MctsLimits& limits);
+    void playout(Worker& worker, const MctsLimits& limits);
+
+    // Create the children of `index` if this thread wins the claim. Returns
+    // the node's expansion state afterwards.
+    std::uint8_t expand(Worker& worker, std::uint32_t index);
+    std::uint32_t select(const Node& parent, double exploration) const;
+
+    // Random game from the worker's position; half points for white. The
+    // position is restored afterwards.
+    int rollout(Worker& worker, int depth, const MctsLimits& limits);
+
+    // Play a random legal move as path entry `depth`; false if there is none
+    bool playRandomMove(Worker& worker, int depth);
+    void play(Worker& worker, PathEntry& entry);
+    void unplay(Worker& worker, int from, int to);  // Path entries [from, to), last first
+    int scoreTerminal(const Worker& worker) const;
+};
@@ -0,0 +1,172 @@
+#pragma once
+
+#include "AttackMap.hpp"
+#include "GameState.hpp"
+#include "RuleSet.hpp"
+#include "Utilities.hpp"
+#include <cstdint>
+#include <type_traits>
+
+// Move on the compact board, 32 bits in total so that move lists, hash
+// table entries and history tables stay small.
+//
+// `flags` packs the kind of move into one byte: the low two bits hold the
+// special move (castling, en passant or a double step that leaves an
+// en-passant square behind), bit 2 marks a promotion and the top five bits
+// the kind promoted to. A castling move is encoded as the royal piece moving
+// onto its partner's square; both pieces then land beside each other, see
+// MoveGenerator.
+struct EngineMove {
+    std::uint8_t from;
+    std::uint8_t to;
+    std::uint8_t portal;    // Portal travelled through, kNoPortal if none
+    std::uint8_t flags;
+
+    static constexpr std::uint8_t kNormal = 0;
+    static constexpr std::uint8_t kCastle = 1;
+    static constexpr std::uint8_t kEnPassant = 2;
+    static constexpr std::uint8_t kDoubleStep = 3;
+    static constexpr std::uint8_t kSpecialMask = 3;
+    static constexpr std::uint8_t kPromotion = 4;
+
+    static constexpr std::uint8_t promotionFlags(int kind) {
+        return static_cast<std::uint8_t>(kPromotion | (kind << 3));
+    }
+
+    int special() const { return flags & kSpecialMask; }
+    bool isPromotion() const { return (flags & kPromotion) != 0; }
+    int promotionKind() const { return flags >> 3; }
+
+    // The move as one 32-bit word (from, to, portal, flags from the low byte
+    // up). Zero never encodes a real move, so it can mark "no move".
+    std::uint32_t pack() const {
+        return static_cast<std::uint32_t>(from) | static_cast<std::uint32_t>(to) << 8 |
+               static_cast<std::uint32_t>(portal) << 16 | static_cast<std::uint32_t>(flags) << 24;
+    }
+    static EngineMove unpack(std::uint32_t packed) {
+        return EngineMove{static_cast<std::uint8_t>(packed), static_cast<std::uint8_t>(packed >> 8),
+                          static_cast<std::uint8_t>(packed >> 16), static_cast<std::uint8_t>(packed >> 24)};
+    }
+
+    bool operator==(const EngineMove& other) const = default;
+};
+
+static_assert(sizeof(EngineMove) == 4 && std::is_trivially_copyable_v<EngineMove>, "EngineMove is a packed word");
+
+constexpr int kMaxMoves = 2048;
+
+// Fixed-capacity move list, filled without heap allocation
+struct MoveList {
+    EngineMove moves[kMaxMoves];
+    int count = 0;
+
+    void add(int from, int to, std::uint8_t portal = kNoPortal, std::uint8_t flags = 0) {
+        if (count < kMaxMoves) {
+            moves[count++] = EngineMove{static_cast<std::uint8_t>(from), static_cast<std::uint8_t>(to), portal, flags};
+        }
+    }
+    const EngineMove* begin() const { return moves; }
+    const EngineMove* end() const { return moves + count; }
+};
+
+// Everything makeMove changes that unmakeMove cannot recompute
+struct UndoInfo {
+    std::uint64_t hash;
+    std::uint8_t piece;
+    std::uint8_t captured;
+    std::uint8_t epSquare;
+    bool fromUnmoved;
+    bool capturedUnmoved;
+    std::uint8_t cooldowns[kMaxPortals];
+};
+
+// Pseudo-legal move generation and make/unmake on a GameState.
+//
+// Pieces move along the rays compiled in the RuleSet. A move that ends on an
+// empty portal entry may instead teleport: the piece arrives on the exit
+// and, for preserve_direction portals, may keep sliding along the exit ray
+// in the same direction for the rest of its range. Portals are closed while
+// cooling down and to colors they do not allow, except for pieces with the
+// portal_master ability.
+//
+// Every move is a turn: all portal cooldowns tick down, then a portal used by
+// the move starts its cooldown. The hash covers pieces, unmoved flags, side
+// to move, the en-passant square and every cooldown counter.
+//
+// Special moves follow the piece abilities rather than piece names:
+//  - castling: an unmoved royal piece with the castling ability and the
+//    first unmoved non-royal castling piece along its rank, at least three
+//    files away with nothing in between. The royal piece moves two files
+//    towards the partner, which lands on the square it crossed. The royal
+//    piece may not be in check or cross an attacked square (checked by
+//    isLegal, the pseudo-legal generator only needs the path to be empty);
+//  - en passant: a piece with the ability that moves two or more squares
+//    straight forward leaves the square behind it as the en-passant target
+//    for one turn, which a piece with the ability may capture onto with a
+//    one-step capture-only move (a pawn's diagonal);
+//  - promotion: a promotable piece that ends its move on the last rank
+//    becomes one of RuleSet::promotionKinds, one move per kind.
+class MoveGenerator {
+public:
+    explicit MoveGenerator(const RuleSet& rules) : rules(rules) {}
+
+    const RuleSet& getRules() const { return rules; }
+
+    void generate(const GameState& state, MoveList& moves) const;
+    void makeMove(GameState& state, const EngineMove& move, UndoInfo& undo) const;
+    void unmakeMove(GameState& state, const EngineMove& move, const UndoInfo& undo) const;
+
+    // Copy-make: apply a move to a copy of the parent position, which is then
+    // simply dropped instead of unmade
+    void makeMove(GameState& state, const EngineMove& move) const;
+
+    // Count leaf nodes of the pseudo-legal move tree, with make/unmake and
+    // with copy-make respectively
+    std::uint64_t perft(GameState& state, int depth) const;
+    std::uint64_t perftCopy(const GameState& state, int depth) const;
+
+    // Legality, with `attacks` kept in step with `state` (both are restored
+    // before returning). A move is legal if it does not leave a royal piece
+    // of the mover attacked; variants without royal pieces have no checks.
+    bool isLegal(GameState& state, AttackMap& attacks, const EngineMove& move) const;
+    void generateLegal(GameState& state, AttackMap& attacks, MoveList& moves) const;
+    bool hasLegalMove(GameState& state, AttackMap& attacks) const;
+    bool isCheckmate(GameState& state, AttackMap& attacks) const;
+    bool isStalemate(GameState& state, AttackMap& attacks) const;
+    std::uint64_t perftLegal(GameState& state, AttackMap& attacks, int depth) const;
+
+    // Squares whose contents a move changes (up to 4 for castling), for
+    // AttackMap::update. Returns the number of squares written.
+    int getChangedSquares(const EngineMove& move, int (&squares)[4]) const;
+
+    // Square of the piece a move captures (differs from `to` for en passant)
+    int getCapturedSquare(const EngineMove& move) const;
+
+    // Conversions to and from the board-level Move. A castling Move goes to
+    // the square the royal piece lands on, and its portal is named by id.
+    Move toMove(const EngineMove& move) const;
+
+    // Capture details are taken from `before`, the position the move is
+    // played in
+    MoveRecord toMoveRecord(const GameState& before, const EngineMove& move) const;
+
+    // Find the pseudo-legal move of `state` that a Move describes. A Move
+    // without a portal prefers the direct move but falls back to one through
+    // a portal. A Move does not say what a piece promotes to, so
+    // `promotionKind` picks it (-1 for the first of RuleSet::promotionKinds).
+    // Returns false if there is no such move.
+    bool fromMove(const GameState& state, const Move& move, EngineMove& result, int promotionKind = -1) const;
+
+private:
+    const RuleSet& rules;
+
+    void generatePieceMoves(const GameState& state, int from, MoveList& moves) const;
+    void generatePortalMoves(const GameState& state, int from, const PieceRules& kind, Color color,
+                             const MoveRay& ray, int entry, int remaining, MoveList& moves) const;
+    void addMove(const PieceRules& kind, Color color, int from, int to, std::uint8_t portal, std::uint8_t flags,
+                 MoveList& moves) const;
+    void generateCastling(const GameState& state, int from, Color color, MoveList& moves) const;
+    void setCooldown(GameState& state, int portal, int value) const;
+    void placePiece(GameState& state, int square, std::uint8_t code) const;
+    std::uint8_t removePiece(GameState& state, int square) const;
+};
@@ -3,69 +3,126 @@
 #include "ChessBoard.hpp"
 #include "PortalSystem.hpp"
 #include "Utilities.hpp"
-#include <unordered_map>
-#include <unordered_set>
+#include <cstdint>
+#include <span>
+#include <string>
 #include <vector>
-#include <queue>
-#include <memory>
 
-// Simple graph representation for move validation
+// Compact graph representation for move validation.
+//
+// Nodes are square indices (y * size + x). Edges are stored in CSR form: the
+// edges of square s live in edges[offsets[s] .. offsets[s] + degree[s]). The
+// slot range of every square is sized once for the largest number of targets
+// any piece could have from it, so a square's edges can be rewritten in place
+// without touching the rest of the graph.
 class MoveGraph {
 public:
-    // Add a node (position) to the graph
-    void addNode(const Position& pos);
-    
-    // Add a directed edge between positions
-    void addEdge(const Position& from, const Position& to, bool isPortal = false);
-    
-    // Get all neighbors of a position
-    std::vector<Position> getNeighbors(const Position& pos) const;
-    
-    // Check if there's a portal edge between positions
-    bool isPortalEdge(const Position& from, const Position& to) const;
-    
-    // Clear the graph
+    // Lay out the slot ranges, one capacity per square
+    void allocate(const std::vector<int>& capacities);
+
+    // Remove all edges leaving a square
+    void clearNode(int square) { degree[square] = 0; }
+
+    // Add a directed edge between squares
+    void addEdge(int from, int to, bool isPortal = false);
+
+    // Get all neighbors of a square (portal edges have kPortalBit set)
+    std::span<const std::uint16_t> getNeighbors(int square) const {
+        return {edges.data() + offsets[square], degree[square]};
+    }
+
+    // Check if there's a portal edge between squares
+    bool isPortalEdge(int from, int to) const;
+
+    // Clear the graph (keeps the layout)
     void clear();
-    
+
+    static constexpr std::uint16_t kPortalBit = 0x8000;
+    static constexpr std::uint16_t kSquareMask = 0x7FFF;
+
 private:
-    // Adjacency list representation of the graph
-    std::unordered_map<Position, std::vector<Position>> adjacencyList;
-    
-    // Set of portal edges (from, to)
-    std::unordered_set<std::pair<Position, Position>, 
-                       std::function<size_t(const std::pair<Position, Position>&)>> portalEdges;
+    std::vector<std::uint32_t> offsets;
+    std::vector<std::uint16_t> degree;
+    std::vector<std::uint16_t> edges;
 };
 
+// Reachability queries over a ChessBoard and its portals. A standalone
+// library, not a legality check: the game loop checks moves through RuleSet
+// and MoveGenerator, which can disagree with it. After the piece's own first
+// hop, findPath chains any number of portal hops from empty squares, and it
+// ignores preserve_direction (a piece never slides on from an exit) and
+// whether the mover's king is left in check.
+//
+// Squares are stored in the graph's 15 bits, and every square has slots for
+// full queen rays, so boards larger than kMaxGraphBoardSize are refused: the
+// error goes to std::cerr and every query then finds no move. This bound is
+// for the graph only; RuleSet's kMaxBoardSize is the game's limit.
 class MoveValidator {
 public:
+    static constexpr int kMaxGraphBoardSize = 181;   // 181 * 181 squares fit in MoveGraph::kSquareMask
+
     MoveValidator(const ChessBoard& board, const PortalSystem& portalSystem);
-    
-    // Validate a move using graph-based approach
+
+    // False if the board was too large to build the graph for
+    bool isReady() const { return ready; }
+
+    // True if findPath finds a path
     bool isValidMove(const Position& from, const Position& to) const;
-    
-    // Find a valid path between positions (including portals)
+
+    // Shortest chain of hops from the piece on `from` to `to`: one move of
+    // the piece, then portal hops (empty if `to` cannot be reached)
     std::vector<Position> findPath(const Position& from, const Position& to) const;
-    
+
     // Check if a piece can use a portal
     bool canUsePortal(const Position& pos, const ChessPiece* piece) const;
-    
-    // Rebuild the graph (called when board state changes)
+
+    // Rebuild the whole graph (board replaced or first use)
     void rebuildGraph();
-    
+
+    // Incremental updates: only the squares whose edges can change are rebuilt
+    void onPieceMoved(const Position& from, const Position& to);
+    void onPortalCooldownChanged(const std::string& portalId);
+
 private:
     const ChessBoard& board;
     const PortalSystem& portalSystem;
     MoveGraph graph;
-    
+    int size;
+    bool ready = false;
+
+    // Candidate targets per square: the 8 rays to the board edge and the 8
+    // L-shaped jumps. Every piece move is among them. The geometry is
+    // symmetric, so the candidates of a square are also the squares whose
+    // edges may change when that square changes.
+    std::vector<std::uint32_t> candidateOffsets;
+    std::vector<std::uint16_t> candidates;
+
+    // Scratch buffers for the incremental update and the BFS
+    mutable std::vector<std::uint32_t> visitStamp;
+    mutable std::uint32_t currentStamp = 0;
+    mutable std::vector<std::uint16_t> searchQueue;
+    mutable std::vector<std::int32_t> parent;
+
+    Position toPosition(int square) const { return Position(square % size, square / size); }
+    int toSquare(const Position& pos) const { return pos.y * size + pos.x; }
+
     // Build the graph representation of possible moves
     void buildGraph();
-    
+
+    // Precompute candidate targets and size the graph
+    void buildGeometry();
+
+    // Recompute all edges leaving one square
+    void updateSquare(int square);
+
     // Add standard movement edges to the graph
-    void addStandardMoveEdges();
-    
+    void addStandardMoveEdges(int square);
+
     // Add portal edges to the graph
-    void addPortalEdges();
-    
+    void addPortalEdges(int square);
+
+    std::uint32_t nextStamp() const;
+
     // BFS algorithm to find path between positions
     std::vector<Position> bfs(const Position& start, const Position& goal) const;
-};
\ No newline at end of file
+};
@@ -0,0 +1,103 @@
+#pragma once
+
+#include "AttackMap.hpp"
+#include "GameState.hpp"
+#include "MoveGenerator.hpp"
+#include "RuleSet.hpp"
+#include "SelfPlay.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// One book move: the position's Zobrist hash, the move as EngineMove::pack()
+// and how often it scored (two points per win, one per draw)
+struct BookEntry {
+    std::uint64_t hash;
+    std::uint32_t move;
+    std::uint32_t weight;
+};
+
+static_assert(sizeof(BookEntry) == 16, "Book entries are stored as-is");
+
+// Opening moves of one variant, mapped read-only from a file written by
+// OpeningBookBuilder. Thread-safe.
+//
+// File layout: a header, then the entries sorted by hash and, within a
+// position, heaviest first, found by binary search in the mapping. Books are
+// tied to the rules they were built for by RuleSet::movementKey.
+class OpeningBook {
+public:
+    static constexpr char kMagic[8] = {'C', 'H', 'S', 'B', 'O', 'O', 'K', 'S'};
+    static constexpr std::uint32_t kVersion = 1;
+
+    ~OpeningBook();
+    OpeningBook(const OpeningBook&) = delete;
+    OpeningBook& operator=(const OpeningBook&) = delete;
+
+    // Write entries in any order (they are sorted here)
+    static bool write(const std::string& path, const RuleSet& rules, std::vector<BookEntry> entries);
+
+    // Map a book. Returns nullptr (and reports the reason on std::cerr) if
+    // the file is missing, truncated or built for other rules.
+    static std::shared_ptr<const OpeningBook> open(const std::string& path, const RuleSet& rules);
+
+    // Pick a legal book move for the position, with a chance proportional to
+    // its weight: `random` is any uniform 64-bit value, and 0 always gives
+    // the heaviest move. Entries whose move is not legal (a hash collision)
+    // are skipped. Returns false if the book has no move for the position.
+    bool probe(GameState& state, AttackMap& attacks, const MoveGenerator& generator, EngineMove& move,
+               std::uint64_t random = 0) const;
+
+    // Entries of a position, heaviest first; `count` is 0 if there are none
+    const BookEntry* find(std::uint64_t hash, std::size_t& count) const;
+
+    std::size_t getEntryCount() const { return entryCount; }
+
+private:
+    OpeningBook(const std::uint8_t* data, std::size_t size) : data(data), size(size) {}
+
+    const std::uint8_t* data;
+    std::size_t size;
+    const BookEntry* entries = nullptr;
+    std::size_t entryCount = 0;
+};
+
+// Collects the moves played in the first plies of finished games and
+// writes them as an OpeningBook.
+class OpeningBookBuilder {
+public:
+    // Moves after `maxPlies` plies of a game are not recorded
+    explicit OpeningBookBuilder(const RuleSet& rules, int maxPlies = 20);
+
+    // Replay a game from the starting position, crediting each move with the
+    // game's result for the side that played it. Returns false (with the
+    // reason on std::cerr, recording nothing) if a move is not legal.
+    bool addGame(const SelfPlayGame& game);
+
+    // Write every move played in at least `minGames` games that scored at
+    // least once. Returns false (with the reason on std::cerr) on failure.
+    bool write(const std::string& path, int minGames = 1) const;
+
+    std::size_t getGameCount() const { return games; }
+    std::size_t getPositionCount() const { return positions.size(); }
+
+private:
+    struct Candidate {
+        std::uint32_t move;
+        std::uint32_t weight;
+        std::uint32_t games;
+    };
+
+    const RuleSet& rules;
+    int maxPlies;
+    MoveGenerator generator;
+    AttackMap attacks;
+    GameState state;
+    std::unique_ptr<MoveList> moves;
+    std::vector<BookEntry> pending;     // Moves of the game being replayed
+    std::unordered_map<std::uint64_t, std::vector<Candidate>> positions;
+    std::size_t games = 0;
+};
@@ -23,10 +23,10 @@ public:
     // Add allowed color
     void addAllowedColor(Color color);
     
-    // Cooldown management
-    bool isInCooldown() const { return remainingCooldown > 0; }
-    void activateCooldown() { remainingCooldown = cooldown; }
-    void decrementCooldown() { if (remainingCooldown > 0) remainingCooldown--; }
+    // Remove all allowed colors (before adding the permitted ones)
+    void clearAllowedColors() { allowedColors.clear(); }
+    
+    // Remaining cooldown is tracked by the PortalSystem that owns the portal
     
 private:
     std::string id;
@@ -34,6 +34,5 @@ private:
     Position exit;
     bool preserveDirection;
     int cooldown;
-    int remainingCooldown;
     std::unordered_set<Color> allowedColors;
 };
\ No newline at end of file
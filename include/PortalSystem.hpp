@@ -4,41 +4,105 @@
 #include "ChessPiece.hpp"
 #include <vector>
 #include <memory>
-#include <queue>
+#include <span>
 #include <string>
 #include <unordered_map>
+#include <cstdint>
 
-// Class to manage portal cooldowns using a queue
-struct PortalCooldown {
-    std::string portalId;
-    int turnsRemaining;
-    
-    PortalCooldown(std::string id, int turns) : portalId(id), turnsRemaining(turns) {}
+// Undo information for PortalSystem::usePortal
+struct PortalCooldownUndo {
+    std::int32_t portalIndex;
+    std::int64_t previousExpiry;
+};
+
+// Undo information for PortalSystem::processCooldowns: a portal whose
+// cooldown ended on the given turn
+struct PortalExpiry {
+    int turn;
+    std::int32_t portalIndex;
 };
 
 class PortalSystem {
 public:
-    PortalSystem() = default;
+    explicit PortalSystem(int boardSize);
     ~PortalSystem() = default;
     
-    // Portal management
+    // Portal management (all lookups are O(1) via the indexes built in addPortal)
     void addPortal(std::unique_ptr<Portal> portal);
     const Portal* getPortalById(const std::string& id) const;
     const Portal* getPortalByEntry(const Position& position) const;
     bool isEntryPoint(const Position& position) const;
     bool isExitPoint(const Position& position) const;
     
+    // Index-based access (index = order in which portals were added, -1 = none)
+    int getPortalIndexByEntry(const Position& position) const;
+    int getPortalIndexById(const std::string& id) const;
+    const Portal* getPortal(int index) const { return portals[index].get(); }
+    int getPortalCount() const { return static_cast<int>(portals.size()); }
+    
     // Teleportation logic
     bool canUsePortal(const Portal* portal, const ChessPiece* piece) const;
+    bool canUsePortal(int index, const ChessPiece* piece) const;
     Position getExitPosition(const Position& entryPos) const;
     void usePortal(const std::string& portalId);
     
-    // Cooldown management
-    void processCooldowns();
+    // Cooldown management.
+    //
+    // Cooldowns are kept as the turn on which each portal becomes usable
+    // again, filed in a timer wheel with one bucket per turn. Advancing a turn
+    // only visits the bucket of the new turn: the portals expiring on it, and
+    // with cooldowns longer than the wheel, those due on a later round.
+    // Both operations can be undone (last in, first out) for make/unmake,
+    // from undo records the caller keeps. processCooldowns() only appends to
+    // `undo` for portals that expire, and keeps nothing without it.
+    PortalCooldownUndo usePortal(int index);
+    void undoUsePortal(const PortalCooldownUndo& undo);
+    void processCooldowns(std::vector<PortalExpiry>* undo = nullptr);
+    void undoProcessCooldowns(std::vector<PortalExpiry>& undo);
+    
+    bool isInCooldown(int index) const { return cooldownExpiry[index] > currentTurn; }
+    int getRemainingCooldown(int index) const;
+    int getCurrentTurn() const { return currentTurn; }
     std::vector<std::string> getPortalsInCooldown() const;
     
+    // Portals whose cooldown ended in the last processCooldowns() call
+    std::span<const std::int32_t> getExpiredLastTurn() const;
+    
+    // Clear all cooldowns (new game)
+    void resetCooldowns();
+    
+    // Put a portal in cooldown for the given number of turns (capped at its
+    // configured cooldown), e.g. when loading a saved position. Not undoable.
+    void setRemainingCooldown(int index, int turns);
+    
 private:
+    int boardSize;
     std::vector<std::unique_ptr<Portal>> portals;
-    std::queue<PortalCooldown> cooldownQueue;
-    std::unordered_map<std::string, bool> portalCooldownStatus;
+    
+    // Per-square portal index (-1 if no portal enters/exits there). When
+    // several portals share a square, the first one added wins.
+    std::vector<std::int32_t> entryIndex;
+    std::vector<std::int32_t> exitIndex;
+    std::unordered_map<std::string, int> indexById;
+    
+    // Hashed timer wheel. Each portal in cooldown is linked into the bucket
+    // of its expiry turn. The wheel has more buckets than the longest
+    // cooldown, up to kMaxWheelBuckets; past that a bucket also holds portals
+    // expiring on later rounds of the wheel, which stay linked when it comes
+    // round.
+    static constexpr std::size_t kMaxWheelBuckets = 1024;
+    int currentTurn = 0;
+    std::vector<std::int64_t> cooldownExpiry;
+    std::vector<std::int32_t> wheelNext;
+    std::vector<std::int32_t> wheelPrev;
+    std::vector<std::int32_t> wheelHead;
+    int wheelMask = 0;
+    
+    // Portals expired by the last processCooldowns() call
+    std::vector<std::int32_t> expiredLastTurn;
+    
+    int squareOf(const Position& position) const;
+    void linkCooldown(int index);
+    void unlinkCooldown(int index);
+    void resizeWheel(int maxCooldown);
 };
\ No newline at end of file
@@ -0,0 +1,132 @@
+#pragma once
+
+#include "ConfigReader.hpp"
+#include "Utilities.hpp"
+#include <cstdint>
+#include <memory>
+#include <string_view>
+
+// Limits of the compiled rule tables. Boards up to 16x16 keep every square
+// index in one byte and every table a fixed size, so a RuleSet is a plain
+// block of memory that can be shared between threads (and stored on disk).
+constexpr int kMaxBoardSize = 16;
+constexpr int kMaxSquares = kMaxBoardSize * kMaxBoardSize;
+constexpr int kMaxPieceKinds = 32;
+constexpr int kMaxPieceCodes = kMaxPieceKinds * 2 + 1;
+constexpr int kMaxPortals = 32;
+constexpr int kMaxCooldown = 63;
+constexpr int kMaxRaysPerKind = 24;
+constexpr int kMaxNameLength = 24;
+constexpr std::uint8_t kNoPortal = 0xFF;
+
+// Piece codes used on the compact board: 0 is an empty square, otherwise
+// code = kind * 2 + color + 1 (white = 0, black = 1)
+constexpr std::uint8_t kEmptySquare = 0;
+constexpr std::uint8_t makePieceCode(int kind, Color color) {
+    return static_cast<std::uint8_t>(kind * 2 + (color == Color::BLACK ? 1 : 0) + 1);
+}
+constexpr int pieceKind(std::uint8_t code) { return (code - 1) >> 1; }
+constexpr Color pieceColor(std::uint8_t code) { return ((code - 1) & 1) ? Color::BLACK : Color::WHITE; }
+constexpr int colorIndex(Color color) { return color == Color::WHITE ? 0 : 1; }
+
+// The 8 unit directions, indexable by MoveRay::direction
+constexpr int kDirections[8][2] = {
+    {0, 1}, {0, -1}, {1, 0}, {-1, 0}, {1, 1}, {1, -1}, {-1, 1}, {-1, -1}
+};
+
+// One line of movement. dx/dy are given for white; black mirrors dy.
+struct MoveRay {
+    std::int8_t dx;
+    std::int8_t dy;
+    std::uint8_t range;         // Maximum number of steps (1 for leaps)
+    std::uint8_t firstRange;    // Maximum number of steps while the piece is unmoved
+    std::uint8_t flags;         // MoveRay::k* flags
+    std::int8_t direction[2];   // kDirections index per color, -1 for leaps
+
+    static constexpr std::uint8_t kMove = 1;        // May move to an empty square
+    static constexpr std::uint8_t kCapture = 2;     // May capture an enemy piece
+    static constexpr std::uint8_t kJump = 4;        // Ignores pieces in between
+};
+
+// Compiled movement of one piece type
+struct PieceRules {
+    char name[kMaxNameLength];
+    char letter;            // Upper-case letter used in text notations
+    std::uint8_t abilities; // PieceRules::k* flags
+    std::uint8_t rayCount;
+    MoveRay rays[kMaxRaysPerKind];
+
+    static constexpr std::uint8_t kRoyal = 1;
+    static constexpr std::uint8_t kCastling = 2;     // Royal: castles; non-royal: castling partner
+    static constexpr std::uint8_t kPromotion = 4;
+    static constexpr std::uint8_t kEnPassant = 8;
+    static constexpr std::uint8_t kJumpOver = 16;
+    static constexpr std::uint8_t kPortalMaster = 32;
+
+    bool has(std::uint8_t ability) const { return (abilities & ability) != 0; }
+};
+
+// Compiled portal, including the squares a piece passes through when it
+// leaves the exit in each of the 8 directions (preserve_direction portals)
+struct PortalRules {
+    char id[kMaxNameLength];
+    std::uint8_t entry;
+    std::uint8_t exit;
+    std::uint8_t cooldown;
+    std::uint8_t colorMask;          // Bit 0 = white allowed, bit 1 = black allowed
+    bool preserveDirection;
+    std::uint8_t exitRayLength[8];
+    std::uint8_t exitRay[8][kMaxBoardSize - 1];
+
+    bool allows(Color color) const { return (colorMask >> colorIndex(color)) & 1; }
+};
+
+// Movement rules, portals, starting position and hash keys compiled from a
+// GameConfig. Trivially copyable and position independent.
+struct RuleSet {
+    int boardSize;
+    int squareCount;
+    int kindCount;
+    int portalCount;
+    int turnLimit;
+
+    PieceRules kinds[kMaxPieceKinds];
+    PortalRules portals[kMaxPortals];
+
+    // Portal leaving each square (kNoPortal if none)
+    std::uint8_t portalAt[kMaxSquares];
+
+    // Starting position
+    std::uint8_t initialSquares[kMaxSquares];
+
+    // Kinds a promoting piece may become (every kind that is neither royal
+    // nor promotable itself, in config order)
+    int promotionCount;
+    std::uint8_t promotionKinds[kMaxPieceKinds];
+
+    // Zobrist keys
+    std::uint64_t pieceKeys[kMaxSquares][kMaxPieceCodes];
+    std::uint64_t unmovedKeys[kMaxSquares];
+    std::uint64_t cooldownKeys[kMaxPortals][kMaxCooldown + 1];
+    std::uint64_t sideKey;
+    std::uint64_t epKeys[kMaxSquares];
+
+    // Build the tables for a validated config. Returns nullptr (and reports
+    // the reason on std::cerr) if the config exceeds the table limits.
+    static std::unique_ptr<RuleSet> compile(const GameConfig& config);
+
+    // Hash of everything that decides the legal moves of a position (piece
+    // movement, portals, promotions, board size). Files of positions and
+    // moves, such as tablebases and opening books, are tied to it.
+    std::uint64_t movementKey() const;
+
+    // Kind index for a piece type name, -1 if unknown
+    int findKind(std::string_view type) const;
+
+    int squareOf(int x, int y) const { return y * boardSize + x; }
+    int fileOf(int square) const { return square % boardSize; }
+    int rankOf(int square) const { return square / boardSize; }
+
+    // Rank on which promotable pieces of the color promote
+    int promotionRank(Color color) const { return color == Color::WHITE ? boardSize - 1 : 0; }
+};
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "AttackMap.hpp"
+#include "GameState.hpp"
+#include "MoveGenerator.hpp"
+#include "RuleSet.hpp"
+#include <cstddef>
+#include <memory>
+#include <string_view>
+
+enum class SanStatus : std::uint8_t { Ok, Malformed, NoMove, Ambiguous };
+
+// Standard algebraic notation, generalized to the compiled rules:
+//
+//   [kind][from file][from rank][x][entry>]to[=kind][+|#]
+//
+// A kind is its letter; promotable kinds (pawns) are written without one.
+// Files run from 'a', ranks from 1 (up to 16 on a 16x16 board). A move
+// through a portal names the portal's entry square before the square the
+// piece ends on: "Bc4>f7". Castling is "O-O" towards the higher files and
+// "O-O-O" towards the lower ones. The origin is only given when another
+// legal move of the same kind reaches the same square the same way.
+//
+// One per thread: both directions use a scratch move list.
+class SanNotation {
+public:
+    // Longest move text written: a disambiguated portal capture with
+    // promotion and check on a 16x16 board
+    static constexpr std::size_t kMaxLength = 16;
+
+    explicit SanNotation(const RuleSet& rules);
+
+    // Find the legal move a text describes, and its index in
+    // MoveGenerator::generate's list for the position. Check and
+    // annotation marks ("+", "#", "!", "?") are ignored, as is a missing
+    // or extra capture mark. Only moves that match the text are checked
+    // for legality. `state` and `attacks` are restored before returning.
+    SanStatus parse(GameState& state, AttackMap& attacks, std::string_view text, EngineMove& move, int& index);
+
+    // Write a legal move into `out` (kMaxLength characters, no terminating
+    // zero). Returns the length, or 0 if the piece or promotion kind has no
+    // letter.
+    std::size_t write(GameState& state, AttackMap& attacks, const EngineMove& move, char* out);
+
+private:
+    const RuleSet& rules;
+    MoveGenerator generator;
+    std::unique_ptr<MoveList> moves;
+    int letterKinds[26];            // Kind of each upper-case letter, -1 if none
+    bool implicitKind = false;      // Exactly one promotable kind, written without a letter
+
+    int readKind(char letter) const;
+    bool readSquare(std::string_view& text, int& square) const;
+};
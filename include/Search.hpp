@@ -0,0 +1,85 @@
+#pragma once
+
+#include "AttackMap.hpp"
+#include "GameState.hpp"
+#include "MoveGenerator.hpp"
+#include "RuleSet.hpp"
+#include "Tablebase.hpp"
+#include <cstdint>
+#include <memory>
+
+// Budget for one search; whichever limit is reached first ends it
+struct SearchLimits {
+    std::uint64_t nodes = 20000;
+    int depth = 32;
+};
+
+struct SearchResult {
+    EngineMove move{};          // All zero if the side to move has no legal move
+    int score = 0;              // For the side to move; mates are +-(kMateScore - plies)
+    int depth = 0;              // Deepest completed iteration
+    std::uint64_t nodes = 0;
+    std::uint64_t tablebaseHits = 0;
+};
+
+// Iterative-deepening alpha-beta search (negamax) with a captures-only
+// quiescence search, for any variant the move generator supports.
+//
+// The evaluation is material plus a small bonus for central and advanced
+// pieces. Standard pieces have their usual values; custom pieces are valued
+// by how many squares they reach from the middle of an empty board, on the
+// queen's scale. Royal pieces carry no material since they are never
+// captured legally.
+//
+// With tablebases set, positions they cover are scored exactly (mate
+// distance from the table) instead of searched further.
+//
+// All working memory (one move list per ply) is allocated once, so a Search
+// can be reused for every move of many games without allocating. Not
+// thread-safe: use one Search per thread.
+class Search {
+public:
+    static constexpr int kMaxPly = 64;
+    static constexpr int kMateScore = 1000000;
+
+    explicit Search(const RuleSet& rules);
+
+    // Best move for the side to move. `attacks` must match `state`; both are
+    // restored before returning.
+    SearchResult think(GameState& state, AttackMap& attacks, const SearchLimits& limits);
+
+    // Static evaluation for the side to move, in centipawns
+    int evaluate(const GameState& state) const;
+
+    int getPieceValue(int kind) const { return pieceValues[kind]; }
+
+    // Tables to probe below the root, or nullptr for none. Not owned.
+    void setTablebases(const TablebaseSet* tables) { tablebases = tables; }
+
+private:
+    struct Ply {
+        MoveList moves;
+        int scores[kMaxMoves];
+    };
+
+    const RuleSet& rules;
+    MoveGenerator generator;
+    int pieceValues[kMaxPieceKinds];
+    std::unique_ptr<int[]> squareValues;  // [code * kMaxSquares + square], from white's point of view
+    std::unique_ptr<Ply[]> plies;
+    const TablebaseSet* tablebases = nullptr;
+    std::uint64_t nodes = 0;
+    std::uint64_t nodeLimit = 0;
+    std::uint64_t tablebaseHits = 0;
+    bool stopped = false;
+
+    int negamax(GameState& state, AttackMap& attacks, int depth, int ply, int alpha, int beta, EngineMove& best);
+    int quiesce(GameState& state, AttackMap& attacks, int ply, int alpha, int beta);
+    void scoreMoves(const GameState& state, Ply& data, const EngineMove& first) const;
+    static const EngineMove& pickNext(Ply& data, int index);
+    bool isCapture(const GameState& state, const EngineMove& move) const;
+
+    // Play a pseudo-legal move; false (with nothing changed) if it is illegal
+    bool tryMove(GameState& state, AttackMap& attacks, const EngineMove& move, UndoInfo& undo);
+    void undoMove(GameState& state, AttackMap& attacks, const EngineMove& move, const UndoInfo& undo);
+};
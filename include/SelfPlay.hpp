@@ -0,0 +1,138 @@
+#pragma once
+
+#include "AttackMap.hpp"
+#include "ConfigCache.hpp"
+#include "GameState.hpp"
+#include "Mcts.hpp"
+#include "Search.hpp"
+#include "ThreadPool.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+class GameRecordWriter;
+class OpeningBook;
+
+enum class SelfPlayOutcome : std::uint8_t { WhiteWin, BlackWin, Stalemate, TurnLimit };
+enum class SelfPlayEngine { AlphaBeta, Mcts };
+
+// One finished game: its moves as EngineMove::pack() values, in order
+struct SelfPlayGame {
+    std::uint32_t index = 0;
+    SelfPlayOutcome outcome = SelfPlayOutcome::TurnLimit;
+    std::vector<std::uint32_t> moves;
+};
+
+struct SelfPlayOptions {
+    int games = 100;
+    SelfPlayEngine engine = SelfPlayEngine::AlphaBeta;
+    SearchLimits limits;        // Per move, for alpha-beta
+    const TablebaseSet* tablebases = nullptr; // Probed by alpha-beta if set
+    const OpeningBook* book = nullptr;        // Played from (weighted by the game's seed) while it has a move
+    MctsLimits mcts;            // Per move, for MCTS (single-threaded within each game)
+    int randomPlies = 4;        // Random legal moves opening each game, so games differ
+    std::uint64_t seed = 1;     // Game i is seeded with seed + i, whatever thread plays it
+    int maxPlies = 0;           // 0: the config's turn limit, or 500 if it has none
+};
+
+struct SelfPlayWorkerStats {
+    std::size_t games = 0;
+    std::size_t outcomes[4] = {}; // Indexed by SelfPlayOutcome
+    std::uint64_t plies = 0;
+    std::uint64_t nodes = 0;    // Search nodes, or playouts for MCTS
+    std::uint64_t bookMoves = 0;
+    double seconds = 0;         // Time spent playing games
+
+    double nodesPerSecond() const { return seconds > 0 ? nodes / seconds : 0; }
+};
+
+struct SelfPlayReport {
+    std::size_t games = 0;
+    std::size_t outcomes[4] = {}; // Indexed by SelfPlayOutcome
+    std::uint64_t plies = 0;
+    std::uint64_t nodes = 0;
+    std::uint64_t bookMoves = 0;
+    double seconds = 0;
+    std::vector<SelfPlayWorkerStats> workers;
+
+    double gamesPerHour() const { return seconds > 0 ? games * 3600.0 / seconds : 0; }
+    double averagePlies() const { return games > 0 ? static_cast<double>(plies) / games : 0; }
+};
+
+// Compact binary log of self-play games.
+//
+// Layout (little endian): the header "SPLG", a uint32 version, the uint64
+// content hash of the config and a uint32 game count, then per game a uint32
+// index, a uint16 ply count, one outcome byte and the packed uint32 moves.
+// Games appear in the order they finished, not by index.
+class SelfPlayLog {
+public:
+    static constexpr std::uint32_t kVersion = 1;
+
+    SelfPlayLog() = default;
+    ~SelfPlayLog();
+    SelfPlayLog(const SelfPlayLog&) = delete;
+    SelfPlayLog& operator=(const SelfPlayLog&) = delete;
+
+    // Start a new log; the game count is filled in by close()
+    bool create(const std::string& path, std::uint64_t configHash);
+
+    // Append one game. Thread-safe.
+    bool write(const SelfPlayGame& game);
+
+    // Finish the header. Returns false if any write failed.
+    bool close();
+
+    // Read a whole log back. Returns false (with the reason on std::cerr)
+    // if the file is missing, truncated or of another version.
+    static bool read(const std::string& path, std::uint64_t& configHash, std::vector<SelfPlayGame>& games);
+
+private:
+    std::FILE* file = nullptr;
+    std::mutex mutex;
+    std::uint32_t count = 0;
+    bool failed = false;
+};
+
+// Plays engine-vs-engine games of one variant in parallel, for measuring
+// throughput and collecting games.
+//
+// Each pool worker owns a search engine, a GameState and an AttackMap that
+// live as long as the runner, so a game allocates nothing but its move record.
+class SelfPlayRunner {
+public:
+    // 0 threads means one per hardware thread. The variant must have rules.
+    SelfPlayRunner(std::shared_ptr<const CompiledConfig> variant, unsigned threads = 0);
+
+    // Play options.games games; every finished game goes to `log` and
+    // `archive` if given
+    SelfPlayReport run(const SelfPlayOptions& options, SelfPlayLog* log = nullptr,
+                       GameRecordWriter* archive = nullptr);
+
+    unsigned getThreadCount() const { return pool.getThreadCount(); }
+
+private:
+    struct Worker {
+        explicit Worker(const RuleSet& rules) : search(rules), generator(rules), attacks(rules) {}
+
+        Search search;
+        std::unique_ptr<Mcts> mcts; // Created on first use
+        MoveGenerator generator;
+        GameState state;
+        AttackMap attacks;
+        MoveList moves;
+        SelfPlayGame game;
+        SelfPlayWorkerStats stats;
+    };
+
+    std::shared_ptr<const CompiledConfig> variant;
+    ThreadPool pool;
+    std::vector<std::unique_ptr<Worker>> workers;
+
+    // Play game `index` into worker.game
+    void playGame(Worker& worker, const SelfPlayOptions& options, std::uint32_t index);
+};
@@ -0,0 +1,196 @@
+#pragma once
+
+#include "GameState.hpp"
+#include "RuleSet.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+constexpr int kMaxTablebasePieces = 5;
+
+// Largest table generated or opened, in positions
+constexpr std::uint64_t kMaxTablebasePositions = std::uint64_t{1} << 32;
+
+// Win/draw/loss for the side to move, as stored (2 bits per position)
+enum class Wdl : std::uint8_t { Draw = 0, Win = 1, Loss = 2, Invalid = 3 };
+
+struct TablebaseProbe {
+    Wdl wdl = Wdl::Draw;
+    int dtm = 0;            // Plies to mate with best play (0 for draws)
+};
+
+// How a table is stored on disk
+enum class TablebaseFormat {
+    Plain,          // Fixed-size arrays, probed in place
+    Compressed      // Independently compressed blocks, see Tablebase
+};
+
+// Compressed block lookups made by the calling thread
+struct TablebaseCacheStats {
+    std::uint64_t hits = 0;
+    std::uint64_t misses = 0;       // Blocks decompressed
+};
+
+// The pieces of a tablebase, as piece codes in ascending order. Written as
+// the white letters, 'v', then the black letters: "KRvK".
+struct TablebaseMaterial {
+    int count = 0;
+    std::uint8_t codes[kMaxTablebasePieces] = {};
+
+    // Parse "KRvK" with the rule set's piece letters. Returns false (with
+    // the reason on std::cerr) for unknown letters or too many pieces.
+    bool parse(const RuleSet& rules, std::string_view text);
+    std::string toString(const RuleSet& rules) const;
+
+    // Material on the board; false if there are more than kMaxTablebasePieces
+    bool read(const RuleSet& rules, const GameState& state);
+
+    // Unique number for the piece multiset
+    std::uint64_t key() const;
+};
+
+// Numbering of the positions of one material.
+//
+// The pieces take one square each in material order, then come the portal
+// cooldowns (mixed radix over the portals that have one) and the side to
+// move. Identical pieces are only valid in ascending square order, so each
+// position has exactly one index. Castling rights, unmoved pieces and
+// en-passant squares are not part of a position: tables cover endgames in
+// which every piece has moved.
+class TablebaseIndexer {
+public:
+    TablebaseIndexer(const RuleSet& rules, const TablebaseMaterial& material);
+
+    // Number of positions; UINT64_MAX if it does not fit in 64 bits
+    std::uint64_t size() const { return positionCount; }
+    const TablebaseMaterial& getMaterial() const { return material; }
+
+    // Index of a position with this material
+    std::uint64_t index(const GameState& state) const;
+
+    // Position for an index; false if the placement is invalid (pieces
+    // sharing a square, identical pieces out of order, a promotable piece
+    // on its promotion rank)
+    bool decode(std::uint64_t index, GameState& state) const;
+
+    // True if the position's hidden state (unmoved pieces with first-move
+    // rights, an en-passant square) is something tables do not model
+    static bool hasHiddenState(const RuleSet& rules, const GameState& state);
+
+private:
+    const RuleSet& rules;
+    TablebaseMaterial material;
+    std::uint64_t positionCount;
+    int cooldownPortals[kMaxPortals];
+    int cooldownPortalCount = 0;
+    std::uint64_t cooldownStates = 1;
+};
+
+// A solved table, mapped read-only from a file written by
+// TablebaseGenerator. Thread-safe.
+//
+// Plain layout: a TablebaseHeader, the WDL values packed four positions per
+// byte, then one DTM byte per position. Compressed layout: a header, a block
+// index of file offsets, then runs of kBlockPositions position values, each
+// compressed on its own with BlockCodec. A probe decompresses only its block,
+// into a small per-thread LRU cache, so probes near each other (as a search
+// makes them) mostly hit the cache and only the touched blocks are paged in.
+// Tables are tied to the rules they were built for by RuleSet::movementKey.
+class Tablebase {
+public:
+    static constexpr char kMagic[8] = {'C', 'H', 'S', 'T', 'B', 'W', 'D', 'L'};
+    static constexpr char kCompressedMagic[8] = {'C', 'H', 'S', 'T', 'B', 'L', 'Z', 'B'};
+    static constexpr std::uint32_t kVersion = 1;
+    static constexpr const char* kExtension = ".tbw";
+    static constexpr const char* kCompressedExtension = ".tbz";
+    static constexpr std::uint32_t kBlockPositions = 4096;
+
+    // Position values as passed to write(): kDrawValue, dtm + 1 for a win
+    // (odd dtm) or loss (even dtm) of the side to move, or kInvalidValue
+    static constexpr std::uint8_t kDrawValue = 0;
+    static constexpr std::uint8_t kInvalidValue = 255;
+
+    ~Tablebase();
+    Tablebase(const Tablebase&) = delete;
+    Tablebase& operator=(const Tablebase&) = delete;
+
+    // Write a table from one value per position
+    static bool write(const std::string& path, const RuleSet& rules, const TablebaseMaterial& material,
+                      std::uint64_t positionCount, const std::uint8_t* values, int maxDtm,
+                      TablebaseFormat format = TablebaseFormat::Plain);
+
+    // Map a table of either format. Returns nullptr (and reports the reason
+    // on std::cerr) if the file is missing, truncated or built for other
+    // rules.
+    static std::shared_ptr<const Tablebase> open(const std::string& path, const RuleSet& rules);
+
+    // File extension for a format
+    static const char* extension(TablebaseFormat format);
+
+    // Value of a position with this table's material. Invalid if the
+    // position's block of a compressed table is corrupt.
+    TablebaseProbe probe(const GameState& state) const;
+
+    const TablebaseMaterial& getMaterial() const { return indexer.getMaterial(); }
+    int getMaxDtm() const { return maxDtm; }
+    TablebaseFormat getFormat() const { return blockIndex ? TablebaseFormat::Compressed : TablebaseFormat::Plain; }
+    std::size_t getFileSize() const { return size; }
+
+    // Lookups of compressed blocks made by the calling thread so far
+    static TablebaseCacheStats getCacheStats();
+
+private:
+    Tablebase(const RuleSet& rules, const TablebaseMaterial& material, const std::uint8_t* data, std::size_t size);
+
+    static std::shared_ptr<const Tablebase> openPlain(std::unique_ptr<Tablebase> table, const std::string& path,
+                                                      const RuleSet& rules);
+    static std::shared_ptr<const Tablebase> openCompressed(std::unique_ptr<Tablebase> table,
+                                                           const std::string& path, const RuleSet& rules);
+    static bool writePlain(std::ofstream& file, const RuleSet& rules, const TablebaseMaterial& material,
+                           std::uint64_t positionCount, const std::uint8_t* values, int maxDtm);
+    static bool writeCompressed(std::ofstream& file, const RuleSet& rules, const TablebaseMaterial& material,
+                                std::uint64_t positionCount, const std::uint8_t* values, int maxDtm);
+
+    // Decompressed values of a block, from the calling thread's cache
+    const std::uint8_t* loadBlock(std::uint64_t block) const;
+
+    TablebaseIndexer indexer;
+    const std::uint8_t* data;
+    std::size_t size;
+    std::uint64_t id;                   // Tells tables apart in the block cache
+    // Plain tables
+    const std::uint8_t* wdl = nullptr;
+    const std::uint8_t* dtm = nullptr;
+    // Compressed tables: blockCount + 1 file offsets, block i spans
+    // [blockIndex[i], blockIndex[i + 1])
+    const std::uint64_t* blockIndex = nullptr;
+    std::uint64_t blockCount = 0;
+    int maxDtm = 0;
+};
+
+// Every table of a variant found in a directory, looked up by material
+class TablebaseSet {
+public:
+    explicit TablebaseSet(const RuleSet& rules) : rules(rules) {}
+
+    // Load every table file in the directory built for these rules. Returns
+    // the number of tables loaded.
+    int loadDirectory(const std::string& directory);
+
+    void add(std::shared_ptr<const Tablebase> table);
+
+    // Value of the position if a table covers it
+    bool probe(const GameState& state, TablebaseProbe& result) const;
+
+    int getMaxPieces() const { return maxPieces; }
+    std::size_t getTableCount() const { return tables.size(); }
+
+private:
+    const RuleSet& rules;
+    std::unordered_map<std::uint64_t, std::shared_ptr<const Tablebase>> tables;
+    int maxPieces = 0;
+};
@@ -0,0 +1,92 @@
+#pragma once
+
+#include "AttackMap.hpp"
+#include "GameState.hpp"
+#include "MoveGenerator.hpp"
+#include "RuleSet.hpp"
+#include "Tablebase.hpp"
+#include "ThreadPool.hpp"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct TablebaseStats {
+    std::string material;
+    std::uint64_t positions = 0;    // Valid positions
+    std::uint64_t wins = 0;         // For the side to move
+    std::uint64_t losses = 0;
+    std::uint64_t draws = 0;
+    int maxDtm = 0;
+    int sweeps = 0;
+    double seconds = 0;
+    bool reused = false;            // Found in the directory instead of solved
+};
+
+// Solves endgames of any variant by retrograde analysis and writes them as
+// Tablebase files.
+//
+// Every position of a material is numbered by TablebaseIndexer. Mates and
+// stalemates are found first; then each sweep over the unresolved positions
+// resolves a win in n plies if some move reaches a loss in n - 1, and a loss
+// in n if every move reaches a win of at most n - 1 for the opponent.
+// Positions still open when a sweep changes nothing are draws. Moves are
+// generated forwards (the generator's portal and custom-piece rules have no
+// cheap inverse), and captures and promotions look up the smaller tables,
+// which are solved first. Sweeps are split into chunks over a ThreadPool;
+// a sweep only reads values settled by earlier sweeps, so the result does
+// not depend on thread timing.
+//
+// The turn limit is ignored: values are for unlimited play.
+class TablebaseGenerator {
+public:
+    // 0 threads means one per hardware thread. New tables are written in
+    // `format`.
+    explicit TablebaseGenerator(const RuleSet& rules, unsigned threads = 0,
+                                TablebaseFormat format = TablebaseFormat::Plain);
+
+    // Solve a material and everything it can turn into, writing one file per
+    // material into the directory. Tables already there, in either format,
+    // are reused. Returns
+    // false (with the reason on std::cerr) on failure.
+    bool generate(const TablebaseMaterial& material, const std::string& directory);
+
+    // One entry per table generated or reused, smaller materials first
+    const std::vector<TablebaseStats>& getStats() const { return stats; }
+
+    unsigned getThreadCount() const { return pool.getThreadCount(); }
+
+    // Largest table the generator will attempt, in positions
+    static constexpr std::uint64_t kMaxPositions = kMaxTablebasePositions;
+
+private:
+    struct Solved {
+        std::shared_ptr<const Tablebase> table;
+        int maxDtm = 0;
+    };
+
+    struct Worker {
+        explicit Worker(const RuleSet& rules) : attacks(rules) {}
+
+        GameState state;
+        GameState next;
+        AttackMap attacks;
+        MoveList moves;
+        std::uint64_t changed = 0;
+    };
+
+    const RuleSet& rules;
+    TablebaseFormat format;
+    MoveGenerator generator;
+    ThreadPool pool;
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::unordered_map<std::uint64_t, Solved> solved;
+    std::vector<TablebaseStats> stats;
+
+    bool solve(const TablebaseMaterial& material, const std::string& directory);
+
+    // Materials one move can turn `material` into (captures, promotions)
+    std::vector<TablebaseMaterial> successors(const TablebaseMaterial& material) const;
+};
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads for data-parallel batches.
+//
+// parallelFor hands out indices one at a time from a shared counter, so slow
+// items do not hold up a whole chunk. The worker number passed to the task is
+// stable for the life of the pool, letting callers keep per-worker state
+// (buffers, readers) that is reused from one batch to the next.
+class ThreadPool {
+public:
+    using Task = std::function<void(unsigned worker, std::size_t index)>;
+
+    // 0 threads means one per hardware thread
+    explicit ThreadPool(unsigned threads = 0);
+    ~ThreadPool();
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    unsigned getThreadCount() const { return static_cast<unsigned>(workers.size()); }
+
+    // Run task for every index in [0, count) and wait for all of them. Not
+    // reentrant: one batch runs at a time. The task must not throw.
+    void parallelFor(std::size_t count, const Task& task);
+
+private:
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable finished;
+
+    // Current batch, guarded by mutex (next is claimed lock-free)
+    const Task* task = nullptr;
+    std::size_t count = 0;
+    std::atomic<std::size_t> next{0};
+    std::size_t generation = 0;
+    unsigned busy = 0;
+    bool stopping = false;
+
+    void workerLoop(unsigned worker);
+};
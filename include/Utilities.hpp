@@ -1,6 +1,8 @@
 #pragma once
 
+#include <cstddef>
 #include <string>
+#include <string_view>
 #include <utility>
 #include <tuple>
 
@@ -25,12 +27,31 @@ struct Position {
         return Position(x, y);
     }
     
-    // Convert Position to chess notation (e.g., Position(4, 3) -> "e4")
+    // Convert Position to chess notation (e.g., Position(4, 3) -> "e4",
+    // Position(0, 11) -> "a12")
     std::string toChessNotation() const {
         char file = 'a' + x;
-        char rank = '1' + y;
         
-        return std::string(1, file) + std::string(1, rank);
+        return std::string(1, file) + std::to_string(y + 1);
+    }
+    
+    // Parse a square in chess notation (files a-p, ranks 1-16) starting at
+    // `pos` after any spaces, leaving `pos` just past it. Unlike
+    // fromChessNotation this reads two-digit ranks and reports bad input.
+    static bool parseNotation(std::string_view text, std::size_t& pos, Position& square) {
+        while (pos < text.size() && (text[pos] == ' ' || text[pos] == '\t')) ++pos;
+        if (pos >= text.size() || text[pos] < 'a' || text[pos] > 'p') {
+            return false;
+        }
+        square.x = text[pos++] - 'a';
+        int rank = 0;
+        int digits = 0;
+        while (pos < text.size() && text[pos] >= '0' && text[pos] <= '9' && digits < 2) {
+            rank = rank * 10 + (text[pos++] - '0');
+            ++digits;
+        }
+        square.y = rank - 1;
+        return digits > 0 && rank > 0;
     }
     
     // Convert Position to string format "x,y"
@@ -0,0 +1,180 @@
+#include "../include/AttackMap.hpp"
+#include <algorithm>
+
+std::uint32_t AttackMap::computeOpenPortals(const GameState& state) const {
+    std::uint32_t open = 0;
+    for (int portal = 0; portal < rules.portalCount; ++portal) {
+        if (state.cooldowns[portal] == 0) {
+            open |= 1u << portal;
+        }
+    }
+    return open;
+}
+
+void AttackMap::build(const GameState& state) {
+    for (int square = 0; square < kMaxSquares; ++square) {
+        attacksFrom[square].clear();
+        attackedBy[square].clear();
+    }
+    std::fill(&counts[0][0], &counts[0][0] + 2 * kMaxSquares, 0);
+    std::fill(codes, codes + kMaxSquares, kEmptySquare);
+    royals[0].clear();
+    royals[1].clear();
+    openPortals = computeOpenPortals(state);
+
+    for (int square = 0; square < rules.squareCount; ++square) {
+        refresh(state, square);
+        refreshRoyal(state, square);
+    }
+}
+
+void AttackMap::update(const GameState& state, const int* changed, int count) {
+    // Pieces on the changed squares, plus every piece whose attacks reached
+    // them: a ray ending or passing there is now longer or shorter
+    SquareSet dirty;
+    for (int i = 0; i < count; ++i) {
+        dirty.set(changed[i]);
+        dirty |= attackedBy[changed[i]];
+    }
+
+    // A portal that opened or closed changes the attacks of every piece
+    // whose rays reach its entry
+    std::uint32_t open = computeOpenPortals(state);
+    for (std::uint32_t toggled = open ^ openPortals; toggled != 0; toggled &= toggled - 1) {
+        dirty |= attackedBy[rules.portals[__builtin_ctz(toggled)].entry];
+    }
+    openPortals = open;
+
+    dirty.forEach([&](int square) { refresh(state, square); });
+    for (int i = 0; i < count; ++i) {
+        refreshRoyal(state, changed[i]);
+    }
+}
+
+bool AttackMap::isInCheck(Color color) const {
+    const SquareSet& royal = royals[colorIndex(color)];
+    const std::uint8_t* enemyCounts = counts[colorIndex(color) ^ 1];
+    for (int i = 0; i < kMaxSquares / 64; ++i) {
+        for (std::uint64_t bits = royal.words[i]; bits != 0; bits &= bits - 1) {
+            if (enemyCounts[i * 64 + __builtin_ctzll(bits)] != 0) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void AttackMap::refresh(const GameState& state, int square) {
+    // Withdraw the attacks stored for the square...
+    if (codes[square] != kEmptySquare) {
+        std::uint8_t* oldCounts = counts[colorIndex(pieceColor(codes[square]))];
+        attacksFrom[square].forEach([&](int target) {
+            attackedBy[target].reset(square);
+            oldCounts[target]--;
+        });
+    }
+
+    // ...and add those of the piece there now
+    codes[square] = state.squares[square];
+    computeAttacks(state, square, attacksFrom[square]);
+    if (codes[square] != kEmptySquare) {
+        std::uint8_t* newCounts = counts[colorIndex(pieceColor(codes[square]))];
+        attacksFrom[square].forEach([&](int target) {
+            attackedBy[target].set(square);
+            newCounts[target]++;
+        });
+    }
+}
+
+void AttackMap::refreshRoyal(const GameState& state, int square) {
+    royals[0].reset(square);
+    royals[1].reset(square);
+    std::uint8_t code = state.squares[square];
+    if (code != kEmptySquare && rules.kinds[pieceKind(code)].has(PieceRules::kRoyal)) {
+        royals[colorIndex(pieceColor(code))].set(square);
+    }
+}
+
+// Same walk as MoveGenerator::generatePieceMoves, collecting the squares the
+// piece could capture on instead of moves
+void AttackMap::computeAttacks(const GameState& state, int from, SquareSet& attacks) const {
+    attacks.clear();
+    std::uint8_t code = state.squares[from];
+    if (code == kEmptySquare) {
+        return;
+    }
+    const PieceRules& kind = rules.kinds[pieceKind(code)];
+    Color color = pieceColor(code);
+    bool master = kind.has(PieceRules::kPortalMaster);
+    int forward = (color == Color::WHITE) ? 1 : -1;
+    bool unmoved = state.isUnmoved(from);
+    int size = rules.boardSize;
+    int fromX = rules.fileOf(from);
+    int fromY = rules.rankOf(from);
+
+    for (int r = 0; r < kind.rayCount; ++r) {
+        const MoveRay& ray = kind.rays[r];
+        if (!(ray.flags & MoveRay::kCapture)) {
+            continue;
+        }
+        int range = unmoved ? ray.firstRange : ray.range;
+        int dx = ray.dx;
+        int dy = ray.dy * forward;
+        int x = fromX;
+        int y = fromY;
+
+        for (int step = 1; step <= range; ++step) {
+            x += dx;
+            y += dy;
+            if (x < 0 || x >= size || y < 0 || y >= size) {
+                break;
+            }
+
+            int to = rules.squareOf(x, y);
+            attacks.set(to);
+            if (state.squares[to] == kEmptySquare) {
+                if ((ray.flags & MoveRay::kMove) && rules.portalAt[to] != kNoPortal) {
+                    addPortalAttacks(state, from, ray, color, to, range - step, master, attacks);
+                }
+                continue;
+            }
+            if (!(ray.flags & MoveRay::kJump)) {
+                break;
+            }
+        }
+    }
+}
+
+void AttackMap::addPortalAttacks(const GameState& state, int from, const MoveRay& ray, Color color, int entry,
+                                 int remaining, bool master, SquareSet& attacks) const {
+    std::uint8_t portalIndex = rules.portalAt[entry];
+    const PortalRules& portal = rules.portals[portalIndex];
+    if (!master && (state.cooldowns[portalIndex] > 0 || !portal.allows(color))) {
+        return;
+    }
+
+    // As in move generation, the piece does not block itself
+    auto occupied = [&](int square) { return square != from && state.squares[square] != kEmptySquare; };
+
+    if (portal.exit != from) {
+        attacks.set(portal.exit);
+    }
+    if (occupied(portal.exit)) {
+        return;
+    }
+
+    int direction = ray.direction[colorIndex(color)];
+    if (!portal.preserveDirection || direction < 0) {
+        return;
+    }
+    int length = portal.exitRayLength[direction];
+    for (int step = 0; step < remaining && step < length; ++step) {
+        int to = portal.exitRay[direction][step];
+        if (to != from) {
+            attacks.set(to);
+        }
+        if (occupied(to) && !(ray.flags & MoveRay::kJump)) {
+            break;
+        }
+    }
+}
@@ -0,0 +1,161 @@
+#include "../include/BlockCodec.hpp"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+    constexpr std::size_t kMinMatch = 4;
+    constexpr std::size_t kMaxOffset = 65535;
+    constexpr int kHashBits = 12;
+    constexpr std::size_t kFastCopy = 16;
+
+    std::uint32_t read32(const std::uint8_t* bytes) {
+        std::uint32_t value;
+        std::memcpy(&value, bytes, sizeof(value));
+        return value;
+    }
+
+    std::uint32_t hash32(std::uint32_t value) {
+        return (value * 2654435761U) >> (32 - kHashBits);
+    }
+
+    // Lengths of 15 and more continue in bytes of 255 and a final remainder
+    void writeLength(std::size_t length, std::vector<std::uint8_t>& out) {
+        for (length -= 15; length >= 255; length -= 255) {
+            out.push_back(255);
+        }
+        out.push_back(static_cast<std::uint8_t>(length));
+    }
+
+    bool readLength(const std::uint8_t* input, std::size_t inputSize, std::size_t& position, std::size_t& length) {
+        std::uint8_t byte;
+        do {
+            if (position >= inputSize) {
+                return false;
+            }
+            byte = input[position++];
+            length += byte;
+        } while (byte == 255);
+        return true;
+    }
+
+    void writeSequence(const std::uint8_t* literals, std::size_t literalCount, std::size_t matchLength,
+                       std::size_t offset, std::vector<std::uint8_t>& out) {
+        std::size_t matchCode = matchLength == 0 ? 0 : matchLength - kMinMatch;
+        std::uint8_t token = static_cast<std::uint8_t>((literalCount < 15 ? literalCount : 15) << 4);
+        token |= static_cast<std::uint8_t>(matchCode < 15 ? matchCode : 15);
+        out.push_back(token);
+        if (literalCount >= 15) {
+            writeLength(literalCount, out);
+        }
+        out.insert(out.end(), literals, literals + literalCount);
+        if (matchLength == 0) {
+            return;
+        }
+        out.push_back(static_cast<std::uint8_t>(offset & 0xFF));
+        out.push_back(static_cast<std::uint8_t>(offset >> 8));
+        if (matchCode >= 15) {
+            writeLength(matchCode, out);
+        }
+    }
+}
+
+void BlockCodec::compress(const std::uint8_t* input, std::size_t size, std::vector<std::uint8_t>& out) {
+    // Last position seen for each hash of four bytes, plus one (0 is empty)
+    std::uint32_t recent[1 << kHashBits] = {};
+    std::size_t anchor = 0;
+    std::size_t position = 0;
+    while (position + kMinMatch <= size) {
+        std::uint32_t bytes = read32(input + position);
+        std::uint32_t& slot = recent[hash32(bytes)];
+        std::size_t candidate = slot;
+        slot = static_cast<std::uint32_t>(position + 1);
+        if (candidate == 0 || position - (candidate - 1) > kMaxOffset || read32(input + candidate - 1) != bytes) {
+            ++position;
+            continue;
+        }
+        candidate--;
+        std::size_t length = kMinMatch;
+        while (position + length < size && input[candidate + length] == input[position + length]) {
+            ++length;
+        }
+        writeSequence(input + anchor, position - anchor, length, position - candidate, out);
+        position += length;
+        anchor = position;
+    }
+    writeSequence(input + anchor, size - anchor, 0, 0, out);
+}
+
+bool BlockCodec::decompress(const std::uint8_t* input, std::size_t inputSize, std::uint8_t* output,
+                            std::size_t outputSize) {
+    std::size_t in = 0;
+    std::size_t out = 0;
+    while (in < inputSize) {
+        std::uint8_t token = input[in++];
+        std::size_t literalCount = token >> 4;
+        if (literalCount == 15 && !readLength(input, inputSize, in, literalCount)) {
+            return false;
+        }
+        if (literalCount > inputSize - in || literalCount > outputSize - out) {
+            return false;
+        }
+        if (literalCount <= kFastCopy && inputSize - in >= kFastCopy && outputSize - out >= kFastCopy) {
+            // Fixed-size copies compile to a few moves; the bytes past the
+            // literals are overwritten by what follows
+            std::memcpy(output + out, input + in, kFastCopy);
+        } else {
+            std::memcpy(output + out, input + in, literalCount);
+        }
+        in += literalCount;
+        out += literalCount;
+        if (in == inputSize) {
+            break;
+        }
+
+        if (inputSize - in < 2) {
+            return false;
+        }
+        std::size_t offset = input[in] | (static_cast<std::size_t>(input[in + 1]) << 8);
+        in += 2;
+        std::size_t matchLength = token & 15;
+        if (matchLength == 15 && !readLength(input, inputSize, in, matchLength)) {
+            return false;
+        }
+        matchLength += kMinMatch;
+        if (offset == 0 || offset > out || matchLength > outputSize - out) {
+            return false;
+        }
+        std::uint8_t* target = output + out;
+        const std::uint8_t* source = target - offset;
+        if (outputSize - out >= matchLength + 8) {
+            // Eight bytes at a time from a whole number of periods back, so
+            // each chunk reads only output written before it. Short periods
+            // are first spelled out byte by byte.
+            std::size_t copied = 0;
+            std::size_t distance = offset;
+            if (offset < 8) {
+                for (; copied < 8; ++copied) {
+                    target[copied] = source[copied];
+                }
+                distance = offset * ((8 + offset - 1) / offset);
+            }
+            for (; copied < matchLength; copied += 8) {
+                std::memcpy(target + copied, target + copied - distance, 8);
+            }
+        } else if (offset == 1) {
+            std::memset(target, *source, matchLength);
+        } else if (offset >= matchLength) {
+            std::memcpy(target, source, matchLength);
+        } else {
+            // Overlapping: the output repeats with period `offset`, so each
+            // copy can take twice as much of it as the one before
+            std::size_t copied = 0;
+            for (std::size_t period = offset; copied < matchLength; period *= 2) {
+                std::size_t chunk = std::min(period, matchLength - copied);
+                std::memcpy(target + copied, source, chunk);
+                copied += chunk;
+            }
+        }
+        out += matchLength;
+    }
+    return out == outputSize;
+}
@@ -0,0 +1,214 @@
+#include "../include/BoardRenderer.hpp"
+#include <charconv>
+#include <cstring>
+
+namespace {
+    // Longest glyph drawn; longer piece symbols are cut
+    constexpr std::size_t kMaxGlyphBytes = 8;
+
+    struct StandardGlyph {
+        std::string_view type;
+        std::string_view white;
+        std::string_view black;
+    };
+
+    // Same glyphs as the standard ChessPiece classes
+    constexpr StandardGlyph kStandardGlyphs[] = {
+        {"King", "♚", "♔"}, {"Queen", "♛", "♕"}, {"Rook", "♜", "♖"},
+        {"Bishop", "♝", "♗"}, {"Knight", "♞", "♘"}, {"Pawn", "♟", "♙"},
+    };
+
+    int digitCount(int value) {
+        int digits = 1;
+        while (value >= 10) {
+            value /= 10;
+            digits++;
+        }
+        return digits;
+    }
+}
+
+template <typename Piece>
+std::string_view BoardRenderer::draw(int size, const Piece& pieceAt) {
+    // Large enough for any style: at most 2 * size + 6 lines of at most
+    // size * (glyph + 3) + 32 bytes
+    std::size_t bound = static_cast<std::size_t>(2 * size + 6) *
+                        (static_cast<std::size_t>(size) * (kMaxGlyphBytes + 3) + 32);
+    if (buffer.size() < bound) {
+        buffer.resize(bound);
+    }
+    char* out = buffer.data();
+    auto put = [&out](std::string_view text) {
+        std::memcpy(out, text.data(), text.size());
+        out += text.size();
+    };
+    auto putNumber = [&out](int value) { out = std::to_chars(out, out + 12, value).ptr; };
+    std::string_view glyph;
+    char letter = 0;
+
+    if (style == BoardStyle::Compact) {
+        int width = digitCount(size);
+        for (int y = size - 1; y >= 0; --y) {
+            for (int pad = digitCount(y + 1); pad < width; ++pad) {
+                *out++ = ' ';
+            }
+            putNumber(y + 1);
+            *out++ = ' ';
+            for (int x = 0; x < size; ++x) {
+                *out++ = pieceAt(x, y, glyph, letter) ? letter : '.';
+            }
+            *out++ = '\n';
+        }
+        for (int pad = 0; pad <= width; ++pad) {
+            *out++ = ' ';
+        }
+        for (int x = 0; x < size; ++x) {
+            *out++ = static_cast<char>('a' + x);
+        }
+        *out++ = '\n';
+        return std::string_view(buffer.data(), static_cast<std::size_t>(out - buffer.data()));
+    }
+
+    if (style == BoardStyle::Ascii) {
+        int width = digitCount(size);
+        auto putFiles = [&]() {
+            for (int pad = 0; pad <= width; ++pad) {
+                *out++ = ' ';
+            }
+            for (int x = 0; x < size; ++x) {
+                put("  ");
+                *out++ = static_cast<char>('A' + x);
+                *out++ = ' ';
+            }
+            *out++ = '\n';
+        };
+        putFiles();
+        const char* separator = out;
+        for (int pad = 0; pad <= width; ++pad) {
+            *out++ = ' ';
+        }
+        *out++ = '+';
+        for (int x = 0; x < size; ++x) {
+            put("---+");
+        }
+        *out++ = '\n';
+        std::string_view separatorLine(separator, static_cast<std::size_t>(out - separator));
+        for (int y = size - 1; y >= 0; --y) {
+            for (int pad = digitCount(y + 1); pad < width; ++pad) {
+                *out++ = ' ';
+            }
+            putNumber(y + 1);
+            put(" |");
+            for (int x = 0; x < size; ++x) {
+                *out++ = ' ';
+                *out++ = pieceAt(x, y, glyph, letter) ? letter : (x + y) % 2 == 0 ? '.' : ' ';
+                put(" |");
+            }
+            *out++ = ' ';
+            putNumber(y + 1);
+            *out++ = '\n';
+            put(separatorLine);
+        }
+        putFiles();
+        return std::string_view(buffer.data(), static_cast<std::size_t>(out - buffer.data()));
+    }
+
+    // Unicode, laid out as displayBoard always has been
+    auto putFiles = [&]() {
+        put("  ");
+        for (int x = 0; x < size; ++x) {
+            *out++ = ' ';
+            *out++ = static_cast<char>('A' + x);
+            put("  ");
+        }
+        *out++ = '\n';
+    };
+
+    *out++ = '\n';
+    putFiles();
+    // The separator line is written once and copied below every rank
+    const char* separator = out;
+    put("  +-");
+    for (int x = 0; x < size; ++x) {
+        put("----+");
+    }
+    *out++ = '\n';
+    std::string_view separatorLine(separator, static_cast<std::size_t>(out - separator));
+
+    for (int y = size - 1; y >= 0; --y) {
+        putNumber(y + 1);
+        put(" | ");
+        for (int x = 0; x < size; ++x) {
+            if (pieceAt(x, y, glyph, letter)) {
+                put(glyph.substr(0, kMaxGlyphBytes));
+            } else {
+                // Middle dot on light empty squares
+                put((x + y) % 2 == 0 ? "·" : " ");
+            }
+            put(" | ");
+        }
+        putNumber(y + 1);
+        *out++ = '\n';
+        put(separatorLine);
+    }
+    putFiles();
+    *out++ = '\n';
+    return std::string_view(buffer.data(), static_cast<std::size_t>(out - buffer.data()));
+}
+
+std::string_view BoardRenderer::render(const ChessBoard& board) {
+    return draw(board.getSize(), [&board](int x, int y, std::string_view& glyph, char& letter) {
+        const ChessPiece* piece = board.getPieceAt({x, y});
+        if (!piece) {
+            return false;
+        }
+        glyph = piece->getSymbol();
+        letter = piece->getLetter();
+        return true;
+    });
+}
+
+std::string_view BoardRenderer::render(const RuleSet& rules, const GameState& state) {
+    prepareSymbols(rules);
+    return draw(rules.boardSize, [this, &rules, &state](int x, int y, std::string_view& glyph, char& letter) {
+        std::uint8_t code = state.squares[rules.squareOf(x, y)];
+        if (code == kEmptySquare) {
+            return false;
+        }
+        glyph = glyphs[code];
+        letter = letters[code];
+        return true;
+    });
+}
+
+void BoardRenderer::prepareSymbols(const RuleSet& rules) {
+    // Standard pieces get their glyph, other kinds their letter
+    for (int kind = 0; kind < rules.kindCount; ++kind) {
+        const PieceRules& piece = rules.kinds[kind];
+        for (Color color : {Color::WHITE, Color::BLACK}) {
+            std::uint8_t code = makePieceCode(kind, color);
+            bool white = color == Color::WHITE;
+            char upper = piece.letter ? piece.letter : 'X';
+            letters[code] = white ? upper : static_cast<char>(upper - 'A' + 'a');
+            glyphs[code] = std::string_view(&letters[code], 1);
+            if (!piece.letter) {
+                glyphs[code] = white ? "◇" : "◆";
+            }
+            for (const StandardGlyph& standard : kStandardGlyphs) {
+                if (standard.type == piece.name) {
+                    glyphs[code] = white ? standard.white : standard.black;
+                }
+            }
+        }
+    }
+}
+
+void BoardRenderer::write(std::ostream& os, const ChessBoard& board) {
+    std::string_view text = render(board);
+    os.write(text.data(), static_cast<std::streamsize>(text.size()));
+}
+
+void BoardRenderer::write(std::ostream& os, const RuleSet& rules, const GameState& state) {
+    std::string_view text = render(rules, state);
+    os.write(text.data(), static_cast<std::streamsize>(text.size()));
+}
@@ -1,11 +1,12 @@
 #include "../include/ChessBoard.hpp"
+#include "../include/BoardRenderer.hpp"
 #include <iostream>
 #include <vector>
 #include <algorithm>
 
-ChessBoard::ChessBoard(int size) : size(size) {}
+ChessBoard::ChessBoard(int size) : board(static_cast<std::size_t>(size) * size), size(size) {}
 
-bool ChessBoard::placePiece(std::unique_ptr<ChessPiece> piece, const Position& pos) {
+bool ChessBoard::placePiece(PiecePtr piece, const Position& pos) {
     // Check if position is within bounds
     if (!isWithinBounds(pos)) {
         return false;
@@ -17,32 +18,33 @@ bool ChessBoard::placePiece(std::unique_ptr<ChessPiece> piece, const Position& p
     }
     
     // Place the piece
-    board[pos] = std::move(piece);
+    board[squareIndex(pos)] = std::move(piece);
     return true;
 }
 
-std::unique_ptr<ChessPiece> ChessBoard::removePiece(const Position& pos) {
+PiecePtr ChessBoard::removePiece(const Position& pos) {
     // Check if there's a piece at the position
-    auto it = board.find(pos);
-    if (it == board.end()) {
+    if (!isWithinBounds(pos)) {
         return nullptr;
     }
     
-    // Remove the piece and return it
-    std::unique_ptr<ChessPiece> piece = std::move(it->second);
-    board.erase(it);
-    return piece;
+    // Remove the piece and return it (null if the square was empty)
+    return std::move(board[squareIndex(pos)]);
 }
 
 const ChessPiece* ChessBoard::getPieceAt(const Position& pos) const {
-    auto it = board.find(pos);
-    return (it != board.end()) ? it->second.get() : nullptr;
+    return isWithinBounds(pos) ? board[squareIndex(pos)].get() : nullptr;
+}
+
+void ChessBoard::clear() {
+    for (auto& square : board) {
+        square.reset();
+    }
 }
 
 bool ChessBoard::movePiece(const Position& from, const Position& to) {
     // Check if there's a piece at the starting position
-    auto it = board.find(from);
-    if (it == board.end()) {
+    if (!getPieceAt(from)) {
         return false;
     }
     
@@ -51,17 +53,12 @@ bool ChessBoard::movePiece(const Position& from, const Position& to) {
         return false;
     }
     
-    // Remove any piece at the destination (capture)
-    if (!isPositionEmpty(to)) {
-        removePiece(to);
-    }
-    
-    // Move the piece
-    board[to] = std::move(it->second);
-    board.erase(it);
+    // Move the piece, destroying any piece at the destination (capture)
+    PiecePtr& target = board[squareIndex(to)];
+    target = std::move(board[squareIndex(from)]);
     
     // Mark the piece as moved
-    board[to]->setMoved();
+    target->setMoved();
     
     return true;
 }
@@ -89,7 +86,7 @@ bool ChessBoard::isMoveValid(const Position& from, const Position& to) const {
 }
 
 bool ChessBoard::isPositionEmpty(const Position& pos) const {
-    return board.find(pos) == board.end();
+    return getPieceAt(pos) == nullptr;
 }
 
 bool ChessBoard::isWithinBounds(const Position& pos) const {
@@ -99,19 +96,21 @@ bool ChessBoard::isWithinBounds(const Position& pos) const {
 std::vector<std::pair<Position, const ChessPiece*>> ChessBoard::getPiecesByColor(Color color) const {
     std::vector<std::pair<Position, const ChessPiece*>> pieces;
     
-    for (const auto& [pos, piece] : board) {
-        if (piece->getColor() == color) {
-            pieces.emplace_back(pos, piece.get());
+    for (int i = 0; i < static_cast<int>(board.size()); ++i) {
+        const ChessPiece* piece = board[i].get();
+        if (piece && piece->getColor() == color) {
+            pieces.emplace_back(Position(i % size, i / size), piece);
         }
     }
     
     return pieces;
 }
 
-std::optional<Position> ChessBoard::findPiece(const std::string& type, Color color) const {
-    for (const auto& [pos, piece] : board) {
-        if (piece->getType() == type && piece->getColor() == color) {
-            return pos;
+std::optional<Position> ChessBoard::findPiece(std::string_view type, Color color) const {
+    for (int i = 0; i < static_cast<int>(board.size()); ++i) {
+        const ChessPiece* piece = board[i].get();
+        if (piece && piece->getType() == type && piece->getColor() == color) {
+            return Position(i % size, i / size);
         }
     }
     
@@ -119,44 +118,9 @@ std::optional<Position> ChessBoard::findPiece(const std::string& type, Color col
 }
 
 void ChessBoard::displayBoard(std::ostream& os) const {
-    os << std::endl;
-    // Print column headers (A, B, C, ...)
-    os << "  "; // Indent for row numbers
-    for (int i = 0; i < size; ++i) {
-        os << " " << static_cast<char>('A' + i) << "  "; // Adjusted spacing slightly for Unicode symbols
-    }
-    os << std::endl;
-
-    os << "  +-"; // Top border start
-    for (int i = 0; i < size; ++i) {
-        os << "----+"; // Adjusted for potentially wider characters
-    }
-    os << std::endl;
-
-    for (int y = size - 1; y >= 0; --y) {
-        os << y + 1 << " | "; // Print row number (1-indexed)
-        for (int x = 0; x < size; ++x) {
-            const ChessPiece* piece = getPieceAt({x, y});
-            if (piece) {
-                os << piece->getSymbol() << " | "; // getSymbol() now returns std::string
-            } else {
-                // Using Unicode middle dot for light empty squares
-                os << ((x + y) % 2 == 0 ? "·" : " ") << " | "; // · vs space
-            }
-        }
-        os << y + 1 << std::endl; // Print row number again at the end
-
-        os << "  +-"; // Separator line start
-        for (int i = 0; i < size; ++i) {
-            os << "----+"; // Adjusted for potentially wider characters
-        }
-        os << std::endl;
-    }
-
-    // Print column headers again at the bottom
-    os << "  "; // Indent for row numbers
-    for (int i = 0; i < size; ++i) {
-        os << " " << static_cast<char>('A' + i) << "  "; // Adjusted spacing slightly
-    }
-    os << std::endl << std::endl;
+    // The whole board goes out in one write, from a buffer reused by every
+    // board this thread displays
+    thread_local BoardRenderer renderer;
+    renderer.setStyle(BoardStyle::Unicode);
+    renderer.write(os, *this);
 }
\ No newline at end of file
@@ -1,23 +1,89 @@
 #include "../include/ChessPiece.hpp"
 #include "../include/ChessBoard.hpp"
+#include <array>
 #include <cmath>
+#include <new>
+#include <tuple>
+
+void PieceDeleter::operator()(ChessPiece* piece) const {
+    piece->~ChessPiece();
+    resource->deallocate(piece, size, alignment);
+}
+
+namespace {
+    // Every ASCII character, so that one-letter symbols can be returned as
+    // views of static text
+    constexpr auto kAsciiCharacters = [] {
+        std::array<char, 128> characters{};
+        for (int i = 0; i < 128; ++i) {
+            characters[i] = static_cast<char>(i);
+        }
+        return characters;
+    }();
+
+    bool isSimpleType(std::string_view type) {
+        if (type.empty()) {
+            return false;
+        }
+        for (char c : type) {
+            if (static_cast<unsigned char>(c) > 127) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Set a key in a property table. Keys are built in place with the
+    // table's allocator so that pooled pieces never touch the heap.
+    void setProperty(PropertyMap& map, std::string_view key, int value) {
+        auto it = map.find(key);
+        if (it != map.end()) {
+            it->second = value;
+            return;
+        }
+        map.emplace(std::piecewise_construct, std::forward_as_tuple(key), std::forward_as_tuple(value));
+    }
+
+    // Construct a piece of type T inside the given resource
+    template <typename T, typename... Args>
+    PiecePtr makePiece(std::pmr::memory_resource* resource, Args&&... args) {
+        void* memory = resource->allocate(sizeof(T), alignof(T));
+        try {
+            T* piece = new (memory) T(std::forward<Args>(args)..., ChessPiece::allocator_type(resource));
+            return PiecePtr(piece, PieceDeleter{resource, sizeof(T), alignof(T)});
+        } catch (...) {
+            resource->deallocate(memory, sizeof(T), alignof(T));
+            throw;
+        }
+    }
+}
 
 // Base ChessPiece implementation
-ChessPiece::ChessPiece(Color color, const std::string& type)
-    : color(color), type(type), moved(false) {}
+ChessPiece::ChessPiece(Color color, std::string_view type, allocator_type alloc)
+    : color(color), type(type, alloc), moved(false),
+      specialAbilities(alloc), movementProperties(alloc) {}
 
-bool ChessPiece::hasSpecialAbility(const std::string& ability) const {
+bool ChessPiece::hasSpecialAbility(std::string_view ability) const {
     auto it = specialAbilities.find(ability);
     return it != specialAbilities.end() && it->second > 0;
 }
 
-int ChessPiece::getAbilityValue(const std::string& ability) const {
+int ChessPiece::getAbilityValue(std::string_view ability) const {
     auto it = specialAbilities.find(ability);
     return (it != specialAbilities.end()) ? it->second : 0;
 }
 
-void ChessPiece::setSpecialAbility(const std::string& ability, int value) {
-    specialAbilities[ability] = value;
+void ChessPiece::setSpecialAbility(std::string_view ability, int value) {
+    setProperty(specialAbilities, ability, value);
+}
+
+int ChessPiece::getMovementValue(std::string_view key) const {
+    auto it = movementProperties.find(key);
+    return (it != movementProperties.end()) ? it->second : 0;
+}
+
+void ChessPiece::setMovementProperty(std::string_view key, int value) {
+    setProperty(movementProperties, key, value);
 }
 
 // Movement validation helpers
@@ -30,12 +96,11 @@ bool ChessPiece::isValidForwardMove(const Position& from, const Position& to, co
     int distance = (to.y - from.y) * direction;
     
     // Check if the distance is valid based on movement properties
-    int maxDistance = movementProperties.find("forward") != movementProperties.end() 
-                     ? movementProperties.at("forward") : 0;
+    int maxDistance = getMovementValue("forward");
     
     // Special case for first move (e.g., pawns)
-    if (!moved && movementProperties.find("first_move_forward") != movementProperties.end()) {
-        maxDistance = std::max(maxDistance, movementProperties.at("first_move_forward"));
+    if (!moved) {
+        maxDistance = std::max(maxDistance, getMovementValue("first_move_forward"));
     }
     
     // Check if the distance is within range
@@ -53,8 +118,7 @@ bool ChessPiece::isValidSidewaysMove(const Position& from, const Position& to, c
     int distance = std::abs(to.x - from.x);
     
     // Check if the distance is valid based on movement properties
-    int maxDistance = movementProperties.find("sideways") != movementProperties.end() 
-                     ? movementProperties.at("sideways") : 0;
+    int maxDistance = getMovementValue("sideways");
     
     // Check if the distance is within range
     if (distance <= 0 || distance > maxDistance) return false;
@@ -74,15 +138,15 @@ bool ChessPiece::isValidDiagonalMove(const Position& from, const Position& to, c
     int distance = dx; // or dy, they're equal
     
     // Check if the distance is valid based on movement properties
-    int maxDistance = movementProperties.find("diagonal") != movementProperties.end() 
-                     ? movementProperties.at("diagonal") : 0;
+    int maxDistance = getMovementValue("diagonal");
     
     // Check if this is a diagonal capture (e.g., for pawns)
     bool isDiagonalCapture = false;
-    if (movementProperties.find("diagonal_capture") != movementProperties.end()) {
-        maxDistance = std::max(maxDistance, movementProperties.at("diagonal_capture"));
+    auto captureIt = movementProperties.find("diagonal_capture");
+    if (captureIt != movementProperties.end()) {
+        maxDistance = std::max(maxDistance, captureIt->second);
         // For diagonal captures, usually need a piece to capture
-        if (distance <= movementProperties.at("diagonal_capture")) {
+        if (distance <= captureIt->second) {
             isDiagonalCapture = true;
         }
     }
@@ -141,30 +205,31 @@ bool ChessPiece::isPathClear(const Position& from, const Position& to, const Che
 }
 
 // Factory method to create piece based on type
-std::unique_ptr<ChessPiece> ChessPiece::createPiece(
+PiecePtr ChessPiece::createPiece(
     const std::string& type, Color color,
     const std::unordered_map<std::string, int>& movement,
-    const std::unordered_map<std::string, int>& abilities) {
+    const std::unordered_map<std::string, int>& abilities,
+    std::pmr::memory_resource* resource) {
     
     // Standard pieces
-    if (type == "King") return std::make_unique<King>(color);
-    if (type == "Queen") return std::make_unique<Queen>(color);
-    if (type == "Rook") return std::make_unique<Rook>(color);
-    if (type == "Bishop") return std::make_unique<Bishop>(color);
-    if (type == "Knight") return std::make_unique<Knight>(color);
-    if (type == "Pawn") return std::make_unique<Pawn>(color);
+    if (type == "King") return makePiece<King>(resource, color);
+    if (type == "Queen") return makePiece<Queen>(resource, color);
+    if (type == "Rook") return makePiece<Rook>(resource, color);
+    if (type == "Bishop") return makePiece<Bishop>(resource, color);
+    if (type == "Knight") return makePiece<Knight>(resource, color);
+    if (type == "Pawn") return makePiece<Pawn>(resource, color);
     
     // Custom piece
-    return std::make_unique<CustomPiece>(color, type, movement, abilities);
+    return makePiece<CustomPiece>(resource, color, type, movement, abilities);
 }
 
 // Standard chess piece implementations
-King::King(Color color) : ChessPiece(color, "King") {
-    movementProperties["forward"] = 1;
-    movementProperties["sideways"] = 1;
-    movementProperties["diagonal"] = 1;
-    specialAbilities["royal"] = 1;
-    specialAbilities["castling"] = 1;
+King::King(Color color, allocator_type alloc) : ChessPiece(color, "King", alloc) {
+    setMovementProperty("forward", 1);
+    setMovementProperty("sideways", 1);
+    setMovementProperty("diagonal", 1);
+    setSpecialAbility("royal", 1);
+    setSpecialAbility("castling", 1);
 }
 
 bool King::canMoveTo(const Position& from, const Position& to, const ChessBoard& board) const {
@@ -184,14 +249,18 @@ bool King::canMoveTo(const Position& from, const Position& to, const ChessBoard&
     return false;
 }
 
-std::string King::getSymbol() const {
+std::string_view King::getSymbol() const {
     return (color == Color::WHITE) ? "♚" : "♔"; // ♔ vs ♚
 }
 
-Queen::Queen(Color color) : ChessPiece(color, "Queen") {
-    movementProperties["forward"] = 8;
-    movementProperties["sideways"] = 8;
-    movementProperties["diagonal"] = 8;
+char King::getLetter() const {
+    return (color == Color::WHITE) ? 'K' : 'k';
+}
+
+Queen::Queen(Color color, allocator_type alloc) : ChessPiece(color, "Queen", alloc) {
+    setMovementProperty("forward", 8);
+    setMovementProperty("sideways", 8);
+    setMovementProperty("diagonal", 8);
 }
 
 bool Queen::canMoveTo(const Position& from, const Position& to, const ChessBoard& board) const {
@@ -217,13 +286,17 @@ bool Queen::canMoveTo(const Position& from, const Position& to, const ChessBoard
     return false;
 }
 
-std::string Queen::getSymbol() const {
+std::string_view Queen::getSymbol() const {
     return (color == Color::WHITE) ? "♛" : "♕"; // ♕ vs ♛
 }
 
-Rook::Rook(Color color) : ChessPiece(color, "Rook") {
-    movementProperties["forward"] = 8;
-    movementProperties["sideways"] = 8;
+char Queen::getLetter() const {
+    return (color == Color::WHITE) ? 'Q' : 'q';
+}
+
+Rook::Rook(Color color, allocator_type alloc) : ChessPiece(color, "Rook", alloc) {
+    setMovementProperty("forward", 8);
+    setMovementProperty("sideways", 8);
 }
 
 bool Rook::canMoveTo(const Position& from, const Position& to, const ChessBoard& board) const {
@@ -244,12 +317,16 @@ bool Rook::canMoveTo(const Position& from, const Position& to, const ChessBoard&
     return false;
 }
 
-std::string Rook::getSymbol() const {
+std::string_view Rook::getSymbol() const {
     return (color == Color::WHITE) ? "♜" : "♖"; // ♖ vs ♜
 }
 
-Bishop::Bishop(Color color) : ChessPiece(color, "Bishop") {
-    movementProperties["diagonal"] = 8;
+char Rook::getLetter() const {
+    return (color == Color::WHITE) ? 'R' : 'r';
+}
+
+Bishop::Bishop(Color color, allocator_type alloc) : ChessPiece(color, "Bishop", alloc) {
+    setMovementProperty("diagonal", 8);
 }
 
 bool Bishop::canMoveTo(const Position& from, const Position& to, const ChessBoard& board) const {
@@ -265,12 +342,16 @@ bool Bishop::canMoveTo(const Position& from, const Position& to, const ChessBoar
     return false;
 }
 
-std::string Bishop::getSymbol() const {
+std::string_view Bishop::getSymbol() const {
     return (color == Color::WHITE) ? "♝" : "♗"; // ♗ vs ♝
 }
 
-Knight::Knight(Color color) : ChessPiece(color, "Knight") {
-    specialAbilities["jump_over"] = 1;
+char Bishop::getLetter() const {
+    return (color == Color::WHITE) ? 'B' : 'b';
+}
+
+Knight::Knight(Color color, allocator_type alloc) : ChessPiece(color, "Knight", alloc) {
+    setSpecialAbility("jump_over", 1);
 }
 
 bool Knight::canMoveTo(const Position& from, const Position& to, const ChessBoard& board) const {
@@ -284,16 +365,20 @@ bool Knight::canMoveTo(const Position& from, const Position& to, const ChessBoar
     return false;
 }
 
-std::string Knight::getSymbol() const {
+std::string_view Knight::getSymbol() const {
     return (color == Color::WHITE) ? "♞" : "♘"; // ♘ vs ♞
 }
 
-Pawn::Pawn(Color color) : ChessPiece(color, "Pawn") {
-    movementProperties["forward"] = 1;
-    movementProperties["first_move_forward"] = 2;
-    movementProperties["diagonal_capture"] = 1;
-    specialAbilities["promotion"] = 1;
-    specialAbilities["en_passant"] = 1;
+char Knight::getLetter() const {
+    return (color == Color::WHITE) ? 'N' : 'n';
+}
+
+Pawn::Pawn(Color color, allocator_type alloc) : ChessPiece(color, "Pawn", alloc) {
+    setMovementProperty("forward", 1);
+    setMovementProperty("first_move_forward", 2);
+    setMovementProperty("diagonal_capture", 1);
+    setSpecialAbility("promotion", 1);
+    setSpecialAbility("en_passant", 1);
 }
 
 bool Pawn::canMoveTo(const Position& from, const Position& to, const ChessBoard& board) const {
@@ -336,24 +421,29 @@ bool Pawn::canMoveTo(const Position& from, const Position& to, const ChessBoard&
     return false;
 }
 
-std::string Pawn::getSymbol() const {
+std::string_view Pawn::getSymbol() const {
     return (color == Color::WHITE) ? "♟" : "♙"; // ♙ vs ♟
 }
 
+char Pawn::getLetter() const {
+    return (color == Color::WHITE) ? 'P' : 'p';
+}
+
 // Custom piece implementation
 CustomPiece::CustomPiece(Color color, const std::string& type, 
                          const std::unordered_map<std::string, int>& movement,
-                         const std::unordered_map<std::string, int>& abilities)
-    : ChessPiece(color, type) {
+                         const std::unordered_map<std::string, int>& abilities,
+                         allocator_type alloc)
+    : ChessPiece(color, type, alloc) {
     
     // Copy movement properties
     for (const auto& [key, value] : movement) {
-        movementProperties[key] = value;
+        setMovementProperty(key, value);
     }
     
     // Copy special abilities
     for (const auto& [key, value] : abilities) {
-        specialAbilities[key] = value;
+        setSpecialAbility(key, value);
     }
 }
 
@@ -362,25 +452,19 @@ bool CustomPiece::canMoveTo(const Position& from, const Position& to, const Ches
     int dy = std::abs(to.y - from.y);
     
     // L-shaped move
-    if (movementProperties.find("l_shape") != movementProperties.end() && 
-        movementProperties.at("l_shape") > 0 && 
-        isValidLShapeMove(from, to)) {
+    if (getMovementValue("l_shape") > 0 && isValidLShapeMove(from, to)) {
         // Knights can jump over pieces
         const ChessPiece* targetPiece = board.getPieceAt(to);
         return !targetPiece || targetPiece->getColor() != color;
     }
     
     // Diagonal move
-    if (dx == dy && dx > 0 && 
-        movementProperties.find("diagonal") != movementProperties.end() && 
-        dx <= movementProperties.at("diagonal")) {
+    if (dx == dy && dx > 0 && dx <= getMovementValue("diagonal")) {
         return isValidDiagonalMove(from, to, board);
     }
     
     // Horizontal move
-    if (dy == 0 && dx > 0 && 
-        movementProperties.find("sideways") != movementProperties.end() && 
-        dx <= movementProperties.at("sideways")) {
+    if (dy == 0 && dx > 0 && dx <= getMovementValue("sideways")) {
         return isValidSidewaysMove(from, to, board);
     }
     
@@ -394,8 +478,7 @@ bool CustomPiece::canMoveTo(const Position& from, const Position& to, const Ches
             return false;
         }
         
-        if (movementProperties.find("forward") != movementProperties.end() && 
-            moveDistance <= movementProperties.at("forward")) {
+        if (moveDistance <= getMovementValue("forward")) {
             return isValidForwardMove(from, to, board);
         }
     }
@@ -403,23 +486,17 @@ bool CustomPiece::canMoveTo(const Position& from, const Position& to, const Ches
     return false;
 }
 
-std::string CustomPiece::getSymbol() const {
-    // For custom pieces, use a generic Unicode symbol or first letter if type is simple ASCII
-    if (!type.empty()) {
-        // Basic check if type is simple ASCII, otherwise use default symbols
-        // A more robust check might be needed for complex types.
-        bool simple_type = true;
-        for(char c : type) {
-            if (static_cast<unsigned char>(c) > 127) {
-                simple_type = false;
-                break;
-            }
-        }
-        if (simple_type) {
-             return (color == Color::WHITE) ? 
-                    std::string(1, toupper(type[0])) : 
-                    std::string(1, tolower(type[0]));
-        }
+std::string_view CustomPiece::getSymbol() const {
+    // For custom pieces, use the first letter if the type is simple ASCII,
+    // otherwise a generic Unicode symbol
+    if (isSimpleType(type)) {
+        unsigned char letter = static_cast<unsigned char>(getLetter());
+        return std::string_view(&kAsciiCharacters[letter], 1);
     }
     return (color == Color::WHITE) ? "◇" : "◆"; // ◇ vs ◆
-}
\ No newline at end of file
+}
+
+char CustomPiece::getLetter() const {
+    char letter = isSimpleType(type) ? type[0] : 'X';
+    return static_cast<char>((color == Color::WHITE) ? toupper(letter) : tolower(letter));
+}
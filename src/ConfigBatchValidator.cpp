@@ -0,0 +1,55 @@
+#include "../include/ConfigBatchValidator.hpp"
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+
+ConfigBatchValidator::ConfigBatchValidator(unsigned threads) : pool(threads) {
+    for (unsigned i = 0; i < pool.getThreadCount(); ++i) {
+        auto worker = std::make_unique<Worker>();
+        worker->reader.setErrorStream(worker->errors);
+        workers.push_back(std::move(worker));
+    }
+}
+
+ConfigBatchReport ConfigBatchValidator::validateFiles(const std::vector<std::string>& paths) {
+    ConfigBatchReport report;
+    report.results.resize(paths.size());
+
+    auto start = std::chrono::steady_clock::now();
+    pool.parallelFor(paths.size(), [&](unsigned workerIndex, std::size_t index) {
+        Worker& worker = *workers[workerIndex];
+        ConfigCheckResult& result = report.results[index];
+        result.path = paths[index];
+
+        std::error_code error;
+        auto size = std::filesystem::file_size(result.path, error);
+        result.bytes = error ? 0 : size;
+
+        worker.errors.str(std::string());
+        result.valid = worker.reader.loadFromFileStreaming(result.path);
+        result.errors = worker.errors.str();
+    });
+    report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    for (const auto& result : report.results) {
+        (result.valid ? report.validCount : report.invalidCount)++;
+        report.totalBytes += result.bytes;
+    }
+    return report;
+}
+
+ConfigBatchReport ConfigBatchValidator::validateDirectory(const std::string& directory) {
+    std::vector<std::string> paths;
+    std::error_code error;
+    for (const auto& entry : std::filesystem::directory_iterator(directory, error)) {
+        if (entry.is_regular_file() && entry.path().extension() == ".json") {
+            paths.push_back(entry.path().string());
+        }
+    }
+    if (error) {
+        std::cerr << "Failed to read directory " << directory << ": " << error.message() << std::endl;
+    }
+    std::sort(paths.begin(), paths.end());
+    return validateFiles(paths);
+}
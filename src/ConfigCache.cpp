@@ -0,0 +1,138 @@
+#include "../include/ConfigCache.hpp"
+#include "../include/ContentHash.hpp"
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+namespace {
+    std::size_t stringBytes(const std::string& text) {
+        return sizeof(std::string) + (text.capacity() > 15 ? text.capacity() + 1 : 0);
+    }
+
+    std::size_t pieceBytes(const PieceConfig& piece) {
+        std::size_t total = sizeof(PieceConfig) + stringBytes(piece.type);
+        for (const auto& [color, positions] : piece.positions) {
+            total += 64 + stringBytes(color) + positions.capacity() * sizeof(Position);
+        }
+        for (const auto& ability : piece.special_abilities.custom_abilities) {
+            total += 48 + stringBytes(ability.first);
+        }
+        return total;
+    }
+
+    // Rough heap footprint of a config: containers plus node overheads
+    std::size_t configBytes(const GameConfig& config) {
+        std::size_t total = sizeof(GameConfig) + stringBytes(config.game_settings.name);
+        for (const auto& piece : config.pieces) total += pieceBytes(piece);
+        for (const auto& piece : config.custom_pieces) total += pieceBytes(piece);
+        for (const auto& portal : config.portals) {
+            total += sizeof(PortalConfig) + stringBytes(portal.type) + stringBytes(portal.id);
+            for (const auto& color : portal.properties.allowed_colors) total += stringBytes(color);
+        }
+        return total;
+    }
+}
+
+ConfigCache::ConfigCache(std::size_t capacityBytes) : capacity(capacityBytes) {}
+
+ConfigCache& ConfigCache::instance() {
+    static ConfigCache cache;
+    return cache;
+}
+
+ConfigCache::Entry ConfigCache::compile(std::string_view json, std::uint64_t contentHash) {
+    ConfigReader reader;
+    if (!reader.loadFromString(std::string(json))) {
+        return nullptr;
+    }
+    auto entry = std::make_shared<CompiledConfig>();
+    entry->contentHash = contentHash;
+    entry->source = json;
+    entry->config = reader.getConfig();
+    entry->rules = RuleSet::compile(entry->config);
+    entry->bytes = sizeof(CompiledConfig) + stringBytes(entry->source) + configBytes(entry->config) +
+                   (entry->rules ? sizeof(RuleSet) : 0);
+    return entry;
+}
+
+std::shared_ptr<const CompiledConfig> ConfigCache::get(std::string_view json) {
+    std::uint64_t contentHash = hashBytes(json.data(), json.size());
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = index.find(contentHash);
+        if (it != index.end() && (*it->second)->source == json) {
+            ++hits;
+            lru.splice(lru.begin(), lru, it->second);
+            return *it->second;
+        }
+        ++misses;
+    }
+
+    Entry entry = compile(json, contentHash);
+    if (!entry) {
+        return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = index.find(contentHash);
+    if (it != index.end()) {
+        if ((*it->second)->source != json) {
+            // A different text with the same hash: the cached entry stays
+            return entry;
+        }
+        // Another thread compiled the same text meanwhile; keep one copy
+        lru.splice(lru.begin(), lru, it->second);
+        return *it->second;
+    }
+    lru.push_front(entry);
+    index.emplace(contentHash, lru.begin());
+    bytes += entry->bytes;
+    evictLocked();
+    return entry;
+}
+
+std::shared_ptr<const CompiledConfig> ConfigCache::getFile(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        std::cerr << "Failed to open config file: " << path << std::endl;
+        return nullptr;
+    }
+    std::string json((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    return get(json);
+}
+
+void ConfigCache::evictLocked() {
+    // The newest entry always stays, even if it alone exceeds the capacity
+    while (bytes > capacity && lru.size() > 1) {
+        const Entry& victim = lru.back();
+        bytes -= victim->bytes;
+        index.erase(victim->contentHash);
+        lru.pop_back();
+        ++evictions;
+    }
+}
+
+ConfigCache::Stats ConfigCache::getStats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    Stats stats;
+    stats.hits = hits;
+    stats.misses = misses;
+    stats.evictions = evictions;
+    stats.entries = lru.size();
+    stats.bytes = bytes;
+    stats.capacityBytes = capacity;
+    return stats;
+}
+
+void ConfigCache::setCapacity(std::size_t capacityBytes) {
+    std::lock_guard<std::mutex> lock(mutex);
+    capacity = capacityBytes;
+    evictLocked();
+}
+
+void ConfigCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+    lru.clear();
+    index.clear();
+    bytes = 0;
+}
@@ -0,0 +1,406 @@
+#include "../include/ConfigImage.hpp"
+#include "../include/ContentHash.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <iostream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <type_traits>
+#include <unistd.h>
+#include <vector>
+
+static_assert(std::is_trivially_copyable_v<RuleSet>, "RuleSet is stored in images byte for byte");
+
+namespace {
+    constexpr std::uint32_t kByteOrderMark = 0x01020304;
+    constexpr std::size_t kRuleSetAlignment = 64;
+
+    // Strings live in one blob at the end of the image
+    struct StringRef {
+        std::uint32_t offset;
+        std::uint32_t length;
+    };
+
+    struct ImageHeader {
+        char magic[8];
+        std::uint32_t version;
+        std::uint32_t byteOrder;
+        std::uint64_t fileSize;
+        std::uint64_t checksum;       // Of every byte after the header
+        std::uint32_t headerSize;
+        std::uint32_t ruleSetSize;
+
+        std::int32_t boardSize;
+        std::int32_t turnLimit;
+        StringRef name;
+
+        std::uint32_t pieceCount;     // Standard pieces, then custom pieces
+        std::uint32_t customPieceCount;
+        std::uint32_t positionCount;
+        std::uint32_t abilityCount;
+        std::uint32_t portalCount;
+        std::uint32_t colorCount;
+        std::uint32_t stringBytes;
+        std::uint32_t reserved;
+
+        std::uint64_t ruleSetOffset;
+        std::uint64_t pieceOffset;
+        std::uint64_t positionOffset;
+        std::uint64_t abilityOffset;
+        std::uint64_t portalOffset;
+        std::uint64_t colorOffset;
+        std::uint64_t stringOffset;
+    };
+
+    struct ImagePiece {
+        StringRef type;
+        std::int32_t count;
+        std::int32_t forward;
+        std::int32_t sideways;
+        std::int32_t diagonal;
+        std::int32_t lShape;
+        std::int32_t diagonalCapture;
+        std::int32_t firstMoveForward;
+        std::uint32_t abilities;      // kAbility* bits
+        std::uint32_t firstPosition;  // White positions, then black
+        std::uint32_t whiteCount;
+        std::uint32_t blackCount;
+        std::uint32_t firstAbility;   // Custom abilities
+        std::uint32_t abilityCount;
+    };
+
+    constexpr std::uint32_t kAbilityCastling = 1;
+    constexpr std::uint32_t kAbilityRoyal = 2;
+    constexpr std::uint32_t kAbilityJumpOver = 4;
+    constexpr std::uint32_t kAbilityPromotion = 8;
+    constexpr std::uint32_t kAbilityEnPassant = 16;
+
+    struct ImagePosition {
+        std::int32_t x;
+        std::int32_t y;
+    };
+
+    struct ImageAbility {
+        StringRef name;
+        std::uint32_t value;
+    };
+
+    struct ImagePortal {
+        StringRef type;
+        StringRef id;
+        ImagePosition entry;
+        ImagePosition exit;
+        std::int32_t cooldown;
+        std::uint32_t preserveDirection;
+        std::uint32_t firstColor;
+        std::uint32_t colorCount;
+    };
+
+    // Builds the image in memory before it is written out
+    class ImageWriter {
+    public:
+        std::vector<ImagePiece> pieces;
+        std::vector<ImagePosition> positions;
+        std::vector<ImageAbility> abilities;
+        std::vector<ImagePortal> portals;
+        std::vector<StringRef> colors;
+        std::string strings;
+
+        StringRef addString(const std::string& text) {
+            StringRef ref{static_cast<std::uint32_t>(strings.size()), static_cast<std::uint32_t>(text.size())};
+            strings += text;
+            return ref;
+        }
+
+        void addPiece(const PieceConfig& piece) {
+            ImagePiece record{};
+            record.type = addString(piece.type);
+            record.count = piece.count;
+            record.forward = piece.movement.forward;
+            record.sideways = piece.movement.sideways;
+            record.diagonal = piece.movement.diagonal;
+            record.lShape = piece.movement.l_shape;
+            record.diagonalCapture = piece.movement.diagonal_capture;
+            record.firstMoveForward = piece.movement.first_move_forward;
+
+            const SpecialAbilities& special = piece.special_abilities;
+            record.abilities = (special.castling ? kAbilityCastling : 0) | (special.royal ? kAbilityRoyal : 0) |
+                               (special.jump_over ? kAbilityJumpOver : 0) |
+                               (special.promotion ? kAbilityPromotion : 0) |
+                               (special.en_passant ? kAbilityEnPassant : 0);
+            record.firstAbility = static_cast<std::uint32_t>(abilities.size());
+            for (const auto& [name, value] : special.custom_abilities) {
+                abilities.push_back({addString(name), value ? 1u : 0u});
+            }
+            record.abilityCount = static_cast<std::uint32_t>(abilities.size()) - record.firstAbility;
+
+            record.firstPosition = static_cast<std::uint32_t>(positions.size());
+            record.whiteCount = addPositions(piece, "white");
+            record.blackCount = addPositions(piece, "black");
+            pieces.push_back(record);
+        }
+
+        void addPortal(const PortalConfig& portal) {
+            ImagePortal record{};
+            record.type = addString(portal.type);
+            record.id = addString(portal.id);
+            record.entry = {portal.positions.entry.x, portal.positions.entry.y};
+            record.exit = {portal.positions.exit.x, portal.positions.exit.y};
+            record.cooldown = portal.properties.cooldown;
+            record.preserveDirection = portal.properties.preserve_direction ? 1 : 0;
+            record.firstColor = static_cast<std::uint32_t>(colors.size());
+            for (const auto& color : portal.properties.allowed_colors) {
+                colors.push_back(addString(color));
+            }
+            record.colorCount = static_cast<std::uint32_t>(portal.properties.allowed_colors.size());
+            portals.push_back(record);
+        }
+
+    private:
+        std::uint32_t addPositions(const PieceConfig& piece, const char* color) {
+            auto it = piece.positions.find(color);
+            if (it == piece.positions.end()) {
+                return 0;
+            }
+            for (const Position& pos : it->second) {
+                positions.push_back({pos.x, pos.y});
+            }
+            return static_cast<std::uint32_t>(it->second.size());
+        }
+    };
+
+    // Append an array to the image, aligned for its element type
+    template <typename T>
+    std::uint64_t appendArray(std::vector<std::uint8_t>& image, const T* items, std::size_t count,
+                              std::size_t alignment = alignof(T)) {
+        std::size_t offset = (image.size() + alignment - 1) / alignment * alignment;
+        image.resize(offset + count * sizeof(T));
+        if (count > 0) {
+            std::memcpy(image.data() + offset, items, count * sizeof(T));
+        }
+        return offset;
+    }
+
+    bool inBounds(const ImageHeader& header, std::uint64_t offset, std::uint64_t count, std::size_t itemSize,
+                  std::size_t alignment) {
+        return offset % alignment == 0 && offset <= header.fileSize &&
+               count <= (header.fileSize - offset) / itemSize;
+    }
+}
+
+ConfigImage::ConfigImage(const std::uint8_t* data, std::size_t size) : data(data), size(size), rules(nullptr) {}
+
+ConfigImage::~ConfigImage() {
+    munmap(const_cast<std::uint8_t*>(data), size);
+}
+
+bool ConfigImage::write(const std::string& path, const GameConfig& config, const RuleSet& rules) {
+    ImageWriter writer;
+    for (const auto& piece : config.pieces) {
+        writer.addPiece(piece);
+    }
+    for (const auto& piece : config.custom_pieces) {
+        writer.addPiece(piece);
+    }
+    for (const auto& portal : config.portals) {
+        writer.addPortal(portal);
+    }
+
+    ImageHeader header{};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kVersion;
+    header.byteOrder = kByteOrderMark;
+    header.headerSize = sizeof(ImageHeader);
+    header.ruleSetSize = sizeof(RuleSet);
+    header.boardSize = config.game_settings.board_size;
+    header.turnLimit = config.game_settings.turn_limit;
+    header.name = writer.addString(config.game_settings.name);
+    header.pieceCount = static_cast<std::uint32_t>(writer.pieces.size());
+    header.customPieceCount = static_cast<std::uint32_t>(config.custom_pieces.size());
+    header.positionCount = static_cast<std::uint32_t>(writer.positions.size());
+    header.abilityCount = static_cast<std::uint32_t>(writer.abilities.size());
+    header.portalCount = static_cast<std::uint32_t>(writer.portals.size());
+    header.colorCount = static_cast<std::uint32_t>(writer.colors.size());
+    header.stringBytes = static_cast<std::uint32_t>(writer.strings.size());
+
+    std::vector<std::uint8_t> image(sizeof(ImageHeader));
+    header.ruleSetOffset = appendArray(image, &rules, 1, kRuleSetAlignment);
+    header.pieceOffset = appendArray(image, writer.pieces.data(), writer.pieces.size());
+    header.positionOffset = appendArray(image, writer.positions.data(), writer.positions.size());
+    header.abilityOffset = appendArray(image, writer.abilities.data(), writer.abilities.size());
+    header.portalOffset = appendArray(image, writer.portals.data(), writer.portals.size());
+    header.colorOffset = appendArray(image, writer.colors.data(), writer.colors.size());
+    header.stringOffset = appendArray(image, writer.strings.data(), writer.strings.size());
+    header.fileSize = image.size();
+    header.checksum = hashBytes(image.data() + sizeof(ImageHeader), image.size() - sizeof(ImageHeader));
+    std::memcpy(image.data(), &header, sizeof(header));
+
+    std::string tempPath = path + ".tmp";
+    {
+        std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            std::cerr << "Failed to create config image: " << tempPath << std::endl;
+            return false;
+        }
+        file.write(reinterpret_cast<const char*>(image.data()), static_cast<std::streamsize>(image.size()));
+        if (!file.flush()) {
+            std::cerr << "Failed to write config image: " << tempPath << std::endl;
+            std::remove(tempPath.c_str());
+            return false;
+        }
+    }
+    if (std::rename(tempPath.c_str(), path.c_str()) != 0) {
+        std::cerr << "Failed to move config image into place: " << path << std::endl;
+        std::remove(tempPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+std::shared_ptr<const ConfigImage> ConfigImage::open(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        std::cerr << "Failed to open config image: " << path << std::endl;
+        return nullptr;
+    }
+    struct stat info {};
+    if (fstat(fd, &info) != 0 || static_cast<std::size_t>(info.st_size) < sizeof(ImageHeader)) {
+        std::cerr << "Config image is truncated: " << path << std::endl;
+        ::close(fd);
+        return nullptr;
+    }
+    std::size_t size = static_cast<std::size_t>(info.st_size);
+    void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        std::cerr << "Failed to map config image: " << path << std::endl;
+        return nullptr;
+    }
+
+    // Owns the mapping from here on, so every early return unmaps it
+    std::unique_ptr<ConfigImage> image(new ConfigImage(static_cast<const std::uint8_t*>(mapping), size));
+    const auto* bytes = static_cast<const std::uint8_t*>(mapping);
+    const auto& header = *reinterpret_cast<const ImageHeader*>(bytes);
+
+    if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0) {
+        std::cerr << "Not a config image: " << path << std::endl;
+        return nullptr;
+    }
+    if (header.version != kVersion || header.byteOrder != kByteOrderMark ||
+        header.headerSize != sizeof(ImageHeader) || header.ruleSetSize != sizeof(RuleSet)) {
+        std::cerr << "Config image was built by another version, recompile it: " << path << std::endl;
+        return nullptr;
+    }
+    if (header.fileSize != size ||
+        !inBounds(header, header.ruleSetOffset, 1, sizeof(RuleSet), kRuleSetAlignment) ||
+        !inBounds(header, header.pieceOffset, header.pieceCount, sizeof(ImagePiece), alignof(ImagePiece)) ||
+        !inBounds(header, header.positionOffset, header.positionCount, sizeof(ImagePosition),
+                  alignof(ImagePosition)) ||
+        !inBounds(header, header.abilityOffset, header.abilityCount, sizeof(ImageAbility), alignof(ImageAbility)) ||
+        !inBounds(header, header.portalOffset, header.portalCount, sizeof(ImagePortal), alignof(ImagePortal)) ||
+        !inBounds(header, header.colorOffset, header.colorCount, sizeof(StringRef), alignof(StringRef)) ||
+        !inBounds(header, header.stringOffset, header.stringBytes, 1, 1)) {
+        std::cerr << "Config image is truncated: " << path << std::endl;
+        return nullptr;
+    }
+    if (hashBytes(bytes + sizeof(ImageHeader), size - sizeof(ImageHeader)) != header.checksum) {
+        std::cerr << "Config image checksum mismatch: " << path << std::endl;
+        return nullptr;
+    }
+    image->rules = reinterpret_cast<const RuleSet*>(bytes + header.ruleSetOffset);
+    return image;
+}
+
+bool ConfigImage::isImageFile(const std::string& path) {
+    char magic[sizeof(kMagic)] = {};
+    std::ifstream file(path, std::ios::binary);
+    return file.read(magic, sizeof(magic)) && std::memcmp(magic, kMagic, sizeof(kMagic)) == 0;
+}
+
+GameConfig ConfigImage::toConfig() const {
+    const auto& header = *reinterpret_cast<const ImageHeader*>(data);
+    const auto* pieces = reinterpret_cast<const ImagePiece*>(data + header.pieceOffset);
+    const auto* positions = reinterpret_cast<const ImagePosition*>(data + header.positionOffset);
+    const auto* abilities = reinterpret_cast<const ImageAbility*>(data + header.abilityOffset);
+    const auto* portals = reinterpret_cast<const ImagePortal*>(data + header.portalOffset);
+    const auto* colors = reinterpret_cast<const StringRef*>(data + header.colorOffset);
+    const char* strings = reinterpret_cast<const char*>(data + header.stringOffset);
+
+    // Offsets were checked against the file size on open; string and record
+    // references are clamped here
+    auto text = [&](StringRef ref) {
+        if (ref.offset > header.stringBytes || ref.length > header.stringBytes - ref.offset) {
+            return std::string();
+        }
+        return std::string(strings + ref.offset, ref.length);
+    };
+    auto range = [](std::uint32_t first, std::uint32_t count, std::uint32_t total) {
+        return first <= total && count <= total - first;
+    };
+
+    GameConfig config;
+    config.game_settings.name = text(header.name);
+    config.game_settings.board_size = header.boardSize;
+    config.game_settings.turn_limit = header.turnLimit;
+
+    std::uint32_t standardCount = header.pieceCount - std::min(header.customPieceCount, header.pieceCount);
+    for (std::uint32_t i = 0; i < header.pieceCount; ++i) {
+        const ImagePiece& record = pieces[i];
+        PieceConfig piece;
+        piece.type = text(record.type);
+        piece.count = record.count;
+        piece.movement.forward = record.forward;
+        piece.movement.sideways = record.sideways;
+        piece.movement.diagonal = record.diagonal;
+        piece.movement.l_shape = record.lShape != 0;
+        piece.movement.diagonal_capture = record.diagonalCapture;
+        piece.movement.first_move_forward = record.firstMoveForward;
+
+        SpecialAbilities& special = piece.special_abilities;
+        special.castling = record.abilities & kAbilityCastling;
+        special.royal = record.abilities & kAbilityRoyal;
+        special.jump_over = record.abilities & kAbilityJumpOver;
+        special.promotion = record.abilities & kAbilityPromotion;
+        special.en_passant = record.abilities & kAbilityEnPassant;
+        if (range(record.firstAbility, record.abilityCount, header.abilityCount)) {
+            for (std::uint32_t a = 0; a < record.abilityCount; ++a) {
+                const ImageAbility& ability = abilities[record.firstAbility + a];
+                special.custom_abilities[text(ability.name)] = ability.value != 0;
+            }
+        }
+
+        if (range(record.firstPosition, record.whiteCount, header.positionCount) &&
+            range(record.firstPosition + record.whiteCount, record.blackCount, header.positionCount)) {
+            const ImagePosition* pos = positions + record.firstPosition;
+            for (std::uint32_t p = 0; p < record.whiteCount; ++p, ++pos) {
+                piece.positions["white"].emplace_back(pos->x, pos->y);
+            }
+            for (std::uint32_t p = 0; p < record.blackCount; ++p, ++pos) {
+                piece.positions["black"].emplace_back(pos->x, pos->y);
+            }
+        }
+
+        (i < standardCount ? config.pieces : config.custom_pieces).push_back(std::move(piece));
+    }
+
+    for (std::uint32_t i = 0; i < header.portalCount; ++i) {
+        const ImagePortal& record = portals[i];
+        PortalConfig portal;
+        portal.type = text(record.type);
+        portal.id = text(record.id);
+        portal.positions.entry = Position(record.entry.x, record.entry.y);
+        portal.positions.exit = Position(record.exit.x, record.exit.y);
+        portal.properties.cooldown = record.cooldown;
+        portal.properties.preserve_direction = record.preserveDirection != 0;
+        if (range(record.firstColor, record.colorCount, header.colorCount)) {
+            for (std::uint32_t c = 0; c < record.colorCount; ++c) {
+                portal.properties.allowed_colors.push_back(text(colors[record.firstColor + c]));
+            }
+        }
+        config.portals.push_back(std::move(portal));
+    }
+    return config;
+}
@@ -1,28 +1,27 @@
 #include "../include/ConfigReader.hpp"
+#include "../include/ConfigImage.hpp"
+#include "../include/ConfigSaxHandler.hpp"
 #include <fstream>
 #include <iostream>
 
-ConfigReader::ConfigReader() {}
+ConfigReader::ConfigReader() : m_errors(&std::cerr) {}
+
+void ConfigReader::setErrorStream(std::ostream &errors) { m_errors = &errors; }
 
 bool ConfigReader::loadFromFile(const std::string &filePath) {
   try {
     std::ifstream file(filePath);
     if (!file.is_open()) {
-      std::cerr << "Failed to open config file: " << filePath << std::endl;
+      *m_errors << "Failed to open config file: " << filePath << std::endl;
       return false;
     }
 
     nlohmann::json jsonData;
     file >> jsonData;
 
-    parseGameSettings(jsonData);
-    parsePieces(jsonData);
-    parseCustomPieces(jsonData);
-    parsePortals(jsonData);
-
-    return validateConfig();
+    return loadFromJson(jsonData);
   } catch (const std::exception &e) {
-    std::cerr << "Error parsing config file: " << e.what() << std::endl;
+    *m_errors << "Error parsing config file: " << e.what() << std::endl;
     return false;
   }
 }
@@ -31,6 +30,19 @@ bool ConfigReader::loadFromString(const std::string &jsonString) {
   try {
     nlohmann::json jsonData = nlohmann::json::parse(jsonString);
 
+    return loadFromJson(jsonData);
+  } catch (const std::exception &e) {
+    *m_errors << "Error parsing config string: " << e.what() << std::endl;
+    return false;
+  }
+}
+
+bool ConfigReader::loadFromJson(const nlohmann::json &jsonData) {
+  try {
+    // Start from scratch so repeated loads do not accumulate pieces
+    m_config = GameConfig{};
+    m_image.reset();
+
     parseGameSettings(jsonData);
     parsePieces(jsonData);
     parseCustomPieces(jsonData);
@@ -38,44 +50,117 @@ bool ConfigReader::loadFromString(const std::string &jsonString) {
 
     return validateConfig();
   } catch (const std::exception &e) {
-    std::cerr << "Error parsing config string: " << e.what() << std::endl;
+    *m_errors << "Error reading config: " << e.what() << std::endl;
+    return false;
+  }
+}
+
+bool ConfigReader::streamFile(const std::string &filePath, bool catalog,
+                              std::function<bool(GameConfig &)> onVariant) {
+  // A larger buffer than the default cuts read calls on big catalogs
+  if (m_readBuffer.empty()) {
+    m_readBuffer.resize(1 << 20);
+  }
+  std::ifstream file;
+  file.rdbuf()->pubsetbuf(m_readBuffer.data(), m_readBuffer.size());
+  file.open(filePath, std::ios::binary);
+  if (!file.is_open()) {
+    *m_errors << "Failed to open config file: " << filePath << std::endl;
+    return false;
+  }
+
+  m_image.reset();
+  // A single config ignores text after its object, as loadFromFile does; a
+  // catalog must end with its array
+  ConfigSaxHandler handler(m_config, catalog, std::move(onVariant));
+  if (!nlohmann::json::sax_parse(file, &handler,
+                                 nlohmann::json::input_format_t::json,
+                                 catalog)) {
+    // A rejected variant has already been reported by the callback
+    if (!handler.getError().empty()) {
+      *m_errors << "Error parsing config file: " << handler.getError()
+                << std::endl;
+    }
+    return false;
+  }
+  return true;
+}
+
+bool ConfigReader::loadFromFileStreaming(const std::string &filePath) {
+  bool valid = false;
+  bool parsed = streamFile(filePath, false, [&](GameConfig &) {
+    valid = validateConfig();
+    return valid;
+  });
+  return parsed && valid;
+}
+
+bool ConfigReader::loadCatalogFromFile(
+    const std::string &filePath,
+    const std::function<void(const GameConfig &)> &onVariant) {
+  std::size_t index = 0;
+  return streamFile(filePath, true, [&](GameConfig &config) {
+    if (!validateConfig()) {
+      *m_errors << "Catalog variant " << index << " is invalid" << std::endl;
+      return false;
+    }
+    onVariant(config);
+    ++index;
+    return true;
+  });
+}
+
+bool ConfigReader::loadFromImage(const std::string &filePath) {
+  auto image = ConfigImage::open(filePath);
+  if (!image) {
     return false;
   }
+  m_config = image->toConfig();
+  m_image = std::move(image);
+  return validateConfig();
 }
 
 const GameConfig &ConfigReader::getConfig() const { return m_config; }
 
+std::shared_ptr<const RuleSet> ConfigReader::getRuleSet() const {
+  if (!m_image) {
+    return nullptr;
+  }
+  // Shares ownership of the mapping the rules live in
+  return std::shared_ptr<const RuleSet>(m_image, &m_image->getRules());
+}
+
 bool ConfigReader::validateConfig() {
   // Basic validation
   if (m_config.game_settings.name.empty()) {
-    std::cerr << "Game name is missing" << std::endl;
+    *m_errors << "Game name is missing" << std::endl;
     return false;
   }
 
   if (m_config.game_settings.board_size <= 0) {
-    std::cerr << "Invalid board size" << std::endl;
+    *m_errors << "Invalid board size" << std::endl;
     return false;
   }
 
   if (m_config.game_settings.turn_limit <= 0) {
-    std::cerr << "Invalid turn limit" << std::endl;
+    *m_errors << "Invalid turn limit" << std::endl;
     return false;
   }
 
   if (m_config.pieces.empty()) {
-    std::cerr << "No pieces defined" << std::endl;
+    *m_errors << "No pieces defined" << std::endl;
     return false;
   }
 
   // Check that each piece has a valid type and position
   for (const auto &piece : m_config.pieces) {
     if (piece.type.empty()) {
-      std::cerr << "Piece is missing type" << std::endl;
+      *m_errors << "Piece is missing type" << std::endl;
       return false;
     }
 
     if (piece.positions.empty()) {
-      std::cerr << "Piece " << piece.type << " has no positions" << std::endl;
+      *m_errors << "Piece " << piece.type << " has no positions" << std::endl;
       return false;
     }
   }
@@ -83,12 +168,12 @@ bool ConfigReader::validateConfig() {
   // Validate custom pieces if any exist
   for (const auto &piece : m_config.custom_pieces) {
     if (piece.type.empty()) {
-      std::cerr << "Custom piece is missing type" << std::endl;
+      *m_errors << "Custom piece is missing type" << std::endl;
       return false;
     }
 
     if (piece.positions.empty()) {
-      std::cerr << "Custom piece " << piece.type << " has no positions"
+      *m_errors << "Custom piece " << piece.type << " has no positions"
                 << std::endl;
       return false;
     }
@@ -97,7 +182,7 @@ bool ConfigReader::validateConfig() {
   // Validate portal positions are within board bounds
   for (const auto &portal : m_config.portals) {
     if (portal.id.empty()) {
-      std::cerr << "Portal is missing ID" << std::endl;
+      *m_errors << "Portal is missing ID" << std::endl;
       return false;
     }
 
@@ -105,7 +190,7 @@ bool ConfigReader::validateConfig() {
         portal.positions.entry.x >= m_config.game_settings.board_size ||
         portal.positions.entry.y < 0 ||
         portal.positions.entry.y >= m_config.game_settings.board_size) {
-      std::cerr << "Portal " << portal.id
+      *m_errors << "Portal " << portal.id
                 << " entry position is outside board bounds" << std::endl;
       return false;
     }
@@ -114,13 +199,117 @@ bool ConfigReader::validateConfig() {
         portal.positions.exit.x >= m_config.game_settings.board_size ||
         portal.positions.exit.y < 0 ||
         portal.positions.exit.y >= m_config.game_settings.board_size) {
-      std::cerr << "Portal " << portal.id
+      *m_errors << "Portal " << portal.id
                 << " exit position is outside board bounds" << std::endl;
       return false;
     }
   }
 
-  return true;
+  return validatePlacement();
+}
+
+bool ConfigReader::validatePlacement() {
+  const int size = m_config.game_settings.board_size;
+  if (size > kMaxConfigBoardSize) {
+    *m_errors << "Board size " << size << " exceeds the maximum of "
+              << kMaxConfigBoardSize << std::endl;
+    return false;
+  }
+
+  // One bit per square, reused between validations
+  const std::size_t words =
+      (static_cast<std::size_t>(size) * size + 63) / 64;
+  m_pieceSquares.assign(words, 0);
+  m_portalSquares.assign(words, 0);
+  auto testAndSet = [size](std::vector<std::uint64_t> &bits,
+                           const Position &pos) {
+    std::size_t square = static_cast<std::size_t>(pos.y) * size + pos.x;
+    std::uint64_t mask = std::uint64_t{1} << (square & 63);
+    bool wasSet = (bits[square >> 6] & mask) != 0;
+    bits[square >> 6] |= mask;
+    return wasSet;
+  };
+  auto isSet = [size](const std::vector<std::uint64_t> &bits,
+                      const Position &pos) {
+    std::size_t square = static_cast<std::size_t>(pos.y) * size + pos.x;
+    return (bits[square >> 6] >> (square & 63) & 1) != 0;
+  };
+  auto inside = [size](const Position &pos) {
+    return pos.x >= 0 && pos.x < size && pos.y >= 0 && pos.y < size;
+  };
+
+  std::size_t conflicts = 0;
+  auto checkPieces = [&](const std::vector<PieceConfig> &pieces) {
+    for (const auto &piece : pieces) {
+      for (const char *color : {"white", "black"}) {
+        auto it = piece.positions.find(color);
+        if (it == piece.positions.end()) {
+          continue;
+        }
+        for (const auto &pos : it->second) {
+          if (!inside(pos)) {
+            *m_errors << "Piece " << piece.type << " (" << color << ") at ("
+                      << pos.toString() << ") is outside the board"
+                      << std::endl;
+            ++conflicts;
+          } else if (testAndSet(m_pieceSquares, pos)) {
+            *m_errors << "Piece " << piece.type << " (" << color << ") at ("
+                      << pos.toString() << ") overlaps "
+                      << describeOccupant(pos) << std::endl;
+            ++conflicts;
+          }
+        }
+      }
+    }
+  };
+  checkPieces(m_config.pieces);
+  checkPieces(m_config.custom_pieces);
+
+  // Portal bounds were checked above. Entries are only tested against the
+  // pieces, so that a shared entry is reported once, as shared.
+  for (std::size_t i = 0; i < m_config.portals.size(); ++i) {
+    const auto &portal = m_config.portals[i];
+    const Position &entry = portal.positions.entry;
+    if (isSet(m_pieceSquares, entry)) {
+      *m_errors << "Portal " << portal.id << " entry (" << entry.toString()
+                << ") is occupied by " << describeOccupant(entry)
+                << std::endl;
+      ++conflicts;
+    }
+    if (testAndSet(m_portalSquares, entry)) {
+      for (std::size_t j = 0; j < i; ++j) {
+        if (m_config.portals[j].positions.entry == entry) {
+          *m_errors << "Portal " << portal.id << " entry ("
+                    << entry.toString() << ") is also the entry of portal "
+                    << m_config.portals[j].id << std::endl;
+          break;
+        }
+      }
+      ++conflicts;
+    }
+  }
+
+  return conflicts == 0;
+}
+
+std::string ConfigReader::describeOccupant(const Position &pos) const {
+  // Only called on a conflict, so a rescan is fine
+  for (const auto *pieces : {&m_config.pieces, &m_config.custom_pieces}) {
+    for (const auto &piece : *pieces) {
+      for (const char *color : {"white", "black"}) {
+        auto it = piece.positions.find(color);
+        if (it == piece.positions.end()) {
+          continue;
+        }
+        for (const auto &other : it->second) {
+          if (other == pos) {
+            return piece.type + " (" + color + ")";
+          }
+        }
+      }
+    }
+  }
+  return "another piece";
 }
 
 void ConfigReader::parseGameSettings(const nlohmann::json &json) {
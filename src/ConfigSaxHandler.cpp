@@ -0,0 +1,507 @@
+#include "../include/ConfigSaxHandler.hpp"
+#include <utility>
+
+ConfigSaxHandler::ConfigSaxHandler(GameConfig &config, bool catalog,
+                                   VariantCallback onVariant)
+    : m_config(config), m_catalog(catalog), m_onVariant(std::move(onVariant)) {
+  m_stack.reserve(16);
+  m_stack.push_back(Context::Document);
+}
+
+void ConfigSaxHandler::defaultSettings() {
+  m_config.game_settings.name = "Custom Chess";
+  m_config.game_settings.board_size = 8;
+  m_config.game_settings.turn_limit = 100;
+}
+
+void ConfigSaxHandler::beginConfig() {
+  // Clear rather than reassign so catalog variants reuse the vectors
+  defaultSettings();
+  m_config.pieces.clear();
+  m_config.custom_pieces.clear();
+  m_config.portals.clear();
+}
+
+ConfigSaxHandler::Field ConfigSaxHandler::currentField() {
+  Field field;
+  const std::string &key = m_key;
+
+  switch (m_stack.back()) {
+  case Context::Document:
+  case Context::Catalog:
+    field.kind = Kind::Object;
+    break;
+
+  case Context::Config:
+    if (key == "game_settings") {
+      field.kind = Kind::Object;
+      field.opens = Context::Settings;
+    } else if (key == "pieces") {
+      field.kind = Kind::OptionalArray;
+      field.opens = Context::PieceList;
+      m_pieceList = &m_config.pieces;
+    } else if (key == "custom_pieces") {
+      field.kind = Kind::OptionalArray;
+      field.opens = Context::PieceList;
+      m_pieceList = &m_config.custom_pieces;
+    } else if (key == "portals") {
+      field.kind = Kind::OptionalArray;
+      field.opens = Context::PortalList;
+    }
+    break;
+
+  case Context::Settings:
+    if (key == "name") {
+      field.kind = Kind::String;
+      field.text = &m_config.game_settings.name;
+    } else if (key == "board_size") {
+      field.kind = Kind::Int;
+      field.number = &m_config.game_settings.board_size;
+    } else if (key == "turn_limit") {
+      field.kind = Kind::Int;
+      field.number = &m_config.game_settings.turn_limit;
+    }
+    break;
+
+  case Context::PieceList:
+    field.kind = Kind::Object;
+    field.opens = Context::Piece;
+    break;
+
+  case Context::Piece:
+    if (key == "type") {
+      field.kind = Kind::String;
+      field.text = &m_piece->type;
+    } else if (key == "count") {
+      field.kind = Kind::Int;
+      field.number = &m_piece->count;
+    } else if (key == "positions") {
+      field.kind = Kind::OptionalObject;
+      field.opens = Context::PiecePositions;
+    } else if (key == "movement") {
+      field.kind = Kind::Object;
+      field.opens = Context::Movement;
+    } else if (key == "special_abilities") {
+      field.kind = Kind::OptionalObject;
+      field.opens = Context::Abilities;
+    }
+    break;
+
+  case Context::PiecePositions:
+    if (key == "white" || key == "black") {
+      field.kind = Kind::OptionalArray;
+      field.opens = Context::PositionList;
+    }
+    break;
+
+  case Context::PositionList:
+    field.kind = Kind::Object;
+    field.opens = Context::Point;
+    break;
+
+  case Context::Point:
+    if (key == "x") {
+      field.kind = Kind::Int;
+      field.number = &m_point->x;
+    } else if (key == "y") {
+      field.kind = Kind::Int;
+      field.number = &m_point->y;
+    }
+    break;
+
+  case Context::Movement: {
+    Movement &movement = m_piece->movement;
+    field.kind = Kind::Int;
+    if (key == "forward") {
+      field.number = &movement.forward;
+    } else if (key == "sideways") {
+      field.number = &movement.sideways;
+    } else if (key == "diagonal") {
+      field.number = &movement.diagonal;
+    } else if (key == "diagonal_capture") {
+      field.number = &movement.diagonal_capture;
+    } else if (key == "first_move_forward") {
+      field.number = &movement.first_move_forward;
+    } else if (key == "l_shape") {
+      field.kind = Kind::Bool;
+      field.flag = &movement.l_shape;
+    } else {
+      field.kind = Kind::Unknown;
+    }
+    break;
+  }
+
+  case Context::Abilities: {
+    SpecialAbilities &abilities = m_piece->special_abilities;
+    field.kind = Kind::Bool;
+    if (key == "castling") {
+      field.flag = &abilities.castling;
+    } else if (key == "royal") {
+      field.flag = &abilities.royal;
+    } else if (key == "jump_over") {
+      field.flag = &abilities.jump_over;
+    } else if (key == "promotion") {
+      field.flag = &abilities.promotion;
+    } else if (key == "en_passant") {
+      field.flag = &abilities.en_passant;
+    } else {
+      field.kind = Kind::CustomAbility;
+    }
+    break;
+  }
+
+  case Context::PortalList:
+    field.kind = Kind::Object;
+    field.opens = Context::Portal;
+    break;
+
+  case Context::Portal:
+    if (key == "type") {
+      field.kind = Kind::String;
+      field.text = &m_portal->type;
+    } else if (key == "id") {
+      field.kind = Kind::String;
+      field.text = &m_portal->id;
+    } else if (key == "positions") {
+      field.kind = Kind::OptionalObject;
+      field.opens = Context::PortalPositions;
+    } else if (key == "properties") {
+      field.kind = Kind::Object;
+      field.opens = Context::PortalProperties;
+    }
+    break;
+
+  case Context::PortalPositions:
+    if (key == "entry") {
+      field.kind = Kind::Object;
+      field.opens = Context::Point;
+      m_point = &m_portal->positions.entry;
+    } else if (key == "exit") {
+      field.kind = Kind::Object;
+      field.opens = Context::Point;
+      m_point = &m_portal->positions.exit;
+    }
+    break;
+
+  case Context::PortalProperties:
+    if (key == "preserve_direction") {
+      field.kind = Kind::Bool;
+      field.flag = &m_portal->properties.preserve_direction;
+    } else if (key == "cooldown") {
+      field.kind = Kind::Int;
+      field.number = &m_portal->properties.cooldown;
+    } else if (key == "allowed_colors") {
+      field.kind = Kind::OptionalArray;
+      field.opens = Context::ColorList;
+    }
+    break;
+
+  case Context::ColorList:
+    field.kind = Kind::String;
+    break;
+
+  default:
+    break;
+  }
+  return field;
+}
+
+bool ConfigSaxHandler::typeError(const char *found) {
+  m_error = "Unexpected " + std::string(found);
+  if (!m_key.empty()) {
+    m_error += " for \"" + m_key + "\"";
+  }
+  return false;
+}
+
+bool ConfigSaxHandler::openContainer(bool isObject) {
+  const char *found = isObject ? "object" : "array";
+  Context parent = m_stack.back();
+
+  // The document itself
+  if (parent == Context::Document || parent == Context::Catalog) {
+    bool wantObject = !m_catalog || parent == Context::Catalog;
+    if (isObject != wantObject) {
+      return typeError(found);
+    }
+    if (isObject) {
+      beginConfig();
+      m_stack.push_back(Context::Config);
+    } else {
+      m_stack.push_back(Context::Catalog);
+    }
+    m_key.clear();
+    return true;
+  }
+
+  if (parent == Context::Skip) {
+    m_stack.push_back(Context::Skip);
+    return true;
+  }
+
+  Field field = currentField();
+  switch (field.kind) {
+  case Kind::Unknown:
+  case Kind::CustomAbility:
+    m_stack.push_back(Context::Skip);
+    return true;
+  case Kind::Object:
+  case Kind::OptionalObject:
+    if (!isObject) {
+      if (field.kind == Kind::Object) {
+        return typeError(found);
+      }
+      m_stack.push_back(Context::Skip);
+      return true;
+    }
+    break;
+  case Kind::OptionalArray:
+    if (isObject) {
+      m_stack.push_back(Context::Skip);
+      return true;
+    }
+    break;
+  default:
+    return typeError(found);
+  }
+
+  // Start filling whatever the container holds
+  switch (field.opens) {
+  case Context::Piece: {
+    PieceConfig &piece = m_pieceList->emplace_back();
+    piece.count = 0;
+    m_piece = &piece;
+    break;
+  }
+  case Context::Portal:
+    m_portal = &m_config.portals.emplace_back();
+    m_portal->type = "Portal";
+    break;
+  case Context::PositionList:
+    // Only created once the list has an entry, as in the DOM path
+    m_positionColor = m_key;
+    m_positionList = nullptr;
+    break;
+  case Context::Point:
+    if (parent == Context::PositionList) {
+      if (m_positionList == nullptr) {
+        m_positionList = &m_piece->positions[m_positionColor];
+      }
+      Position &pos = m_positionList->emplace_back();
+      pos.x = 0;
+      pos.y = 0;
+      m_point = &pos;
+    }
+    break;
+  case Context::PortalProperties:
+    m_sawAllowedColors = false;
+    break;
+  case Context::ColorList:
+    m_sawAllowedColors = true;
+    break;
+  default:
+    break;
+  }
+
+  m_stack.push_back(field.opens);
+  m_key.clear();
+  return true;
+}
+
+bool ConfigSaxHandler::start_object(std::size_t) { return openContainer(true); }
+
+bool ConfigSaxHandler::start_array(std::size_t) { return openContainer(false); }
+
+bool ConfigSaxHandler::end_object() {
+  Context closed = m_stack.back();
+  m_stack.pop_back();
+  m_key.clear();
+
+  if (closed == Context::PortalProperties && !m_sawAllowedColors) {
+    // Default to allowing both colors if not specified
+    m_portal->properties.allowed_colors = {"white", "black"};
+  } else if (closed == Context::Config) {
+    ++m_variants;
+    if (m_onVariant && !m_onVariant(m_config)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool ConfigSaxHandler::end_array() {
+  m_stack.pop_back();
+  m_key.clear();
+  return true;
+}
+
+// The DOM keeps only the last value of a repeated key, so whatever a key
+// fills starts again from its default before the value arrives
+void ConfigSaxHandler::resetField() {
+  const std::string &key = m_key;
+
+  switch (m_stack.back()) {
+  case Context::Config:
+    if (key == "game_settings") {
+      defaultSettings();
+    } else if (key == "pieces") {
+      m_config.pieces.clear();
+    } else if (key == "custom_pieces") {
+      m_config.custom_pieces.clear();
+    } else if (key == "portals") {
+      m_config.portals.clear();
+    }
+    break;
+
+  case Context::Piece:
+    if (key == "positions") {
+      m_piece->positions.clear();
+    } else if (key == "movement") {
+      m_piece->movement = Movement{};
+    } else if (key == "special_abilities") {
+      m_piece->special_abilities = SpecialAbilities{};
+    }
+    break;
+
+  case Context::PiecePositions:
+    m_piece->positions.erase(key);
+    break;
+
+  case Context::Abilities:
+    m_piece->special_abilities.custom_abilities.erase(key);
+    break;
+
+  case Context::Portal:
+    if (key == "positions") {
+      m_portal->positions.entry = Position();
+      m_portal->positions.exit = Position();
+    } else if (key == "properties") {
+      m_portal->properties = PortalProperties{};
+    }
+    break;
+
+  case Context::PortalPositions:
+    if (key == "entry") {
+      m_portal->positions.entry = Position();
+    } else if (key == "exit") {
+      m_portal->positions.exit = Position();
+    }
+    break;
+
+  case Context::PortalProperties:
+    if (key == "allowed_colors") {
+      m_portal->properties.allowed_colors.clear();
+      m_sawAllowedColors = false;
+    }
+    break;
+
+  default:
+    break;
+  }
+}
+
+bool ConfigSaxHandler::key(std::string &val) {
+  m_key.swap(val);
+  if (m_stack.back() != Context::Skip) {
+    resetField();
+  }
+  return true;
+}
+
+bool ConfigSaxHandler::null() {
+  if (m_stack.back() == Context::Skip) {
+    return true;
+  }
+  Kind kind = currentField().kind;
+  if (kind == Kind::String || kind == Kind::Int || kind == Kind::Bool ||
+      kind == Kind::Object) {
+    return typeError("null");
+  }
+  return true;
+}
+
+bool ConfigSaxHandler::boolean(bool val) {
+  if (m_stack.back() == Context::Skip) {
+    return true;
+  }
+  Field field = currentField();
+  switch (field.kind) {
+  case Kind::Bool:
+    *field.flag = val;
+    return true;
+  case Kind::Int:
+    *field.number = val ? 1 : 0;
+    return true;
+  case Kind::CustomAbility:
+    m_piece->special_abilities.custom_abilities[m_key] = val;
+    return true;
+  case Kind::String:
+  case Kind::Object:
+    return typeError("boolean");
+  default:
+    return true;
+  }
+}
+
+bool ConfigSaxHandler::storeInt(std::int64_t val) {
+  if (m_stack.back() == Context::Skip) {
+    return true;
+  }
+  Field field = currentField();
+  switch (field.kind) {
+  case Kind::Int:
+    *field.number = static_cast<int>(val);
+    return true;
+  case Kind::String:
+  case Kind::Bool:
+  case Kind::Object:
+    return typeError("number");
+  default:
+    return true;
+  }
+}
+
+bool ConfigSaxHandler::number_integer(std::int64_t val) {
+  return storeInt(val);
+}
+
+bool ConfigSaxHandler::number_unsigned(std::uint64_t val) {
+  return storeInt(static_cast<std::int64_t>(val));
+}
+
+bool ConfigSaxHandler::number_float(double val, const std::string &) {
+  return storeInt(static_cast<std::int64_t>(val));
+}
+
+bool ConfigSaxHandler::string(std::string &val) {
+  if (m_stack.back() == Context::Skip) {
+    return true;
+  }
+  Field field = currentField();
+  switch (field.kind) {
+  case Kind::String:
+    if (field.text != nullptr) {
+      field.text->swap(val);
+    } else {
+      m_portal->properties.allowed_colors.push_back(std::move(val));
+    }
+    return true;
+  case Kind::Int:
+  case Kind::Bool:
+  case Kind::Object:
+    return typeError("string");
+  default:
+    return true;
+  }
+}
+
+bool ConfigSaxHandler::binary(nlohmann::json::binary_t &) {
+  // Never produced by the text parser
+  return true;
+}
+
+bool ConfigSaxHandler::parse_error(std::size_t, const std::string &,
+                                   const nlohmann::detail::exception &ex) {
+  m_error = ex.what();
+  return false;
+}
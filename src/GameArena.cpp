@@ -0,0 +1,44 @@
+#include "../include/GameArena.hpp"
+
+void* CountingResource::do_allocate(std::size_t bytes, std::size_t alignment) {
+    void* p = upstream->allocate(bytes, alignment);
+    allocations++;
+    bytesAllocated += bytes;
+    return p;
+}
+
+void CountingResource::do_deallocate(void* p, std::size_t bytes, std::size_t alignment) {
+    deallocations++;
+    upstream->deallocate(p, bytes, alignment);
+}
+
+bool CountingResource::do_is_equal(const std::pmr::memory_resource& other) const noexcept {
+    return this == &other;
+}
+
+GameArena::GameArena(std::size_t initialBytes)
+    : buffer(std::make_unique<std::byte[]>(initialBytes)), bufferSize(initialBytes) {
+    arena.emplace(buffer.get(), bufferSize, &upstream);
+}
+
+void GameArena::release() {
+    // Bytes that did not fit in the buffer during this game
+    std::size_t overflow = upstream.getBytesAllocated() - bytesAtLastRelease;
+
+    arena->release();
+    releases++;
+
+    if (overflow > 0) {
+        // Grow once so the next game fits without touching the heap
+        arena.reset();
+        bufferSize += overflow;
+        buffer = std::make_unique<std::byte[]>(bufferSize);
+        arena.emplace(buffer.get(), bufferSize, &upstream);
+    }
+
+    bytesAtLastRelease = upstream.getBytesAllocated();
+}
+
+GameArena::Stats GameArena::getStats() const {
+    return Stats{upstream.getAllocations(), upstream.getBytesAllocated(), bufferSize, releases};
+}
@@ -0,0 +1,329 @@
+#include "../include/GameImport.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+namespace {
+    bool isSpace(char c) { return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f' || c == '\v'; }
+    bool isDelimiter(char c) { return isSpace(c) || c == '{' || c == '}' || c == '(' || c == ')' || c == '[' ||
+                                      c == ']' || c == ';'; }
+
+    // Position just past the variation starting at `pos`, nested variations
+    // and comments included
+    std::size_t skipVariation(std::string_view text, std::size_t pos) {
+        std::size_t size = text.size();
+        int depth = 0;
+        while (pos < size) {
+            char c = text[pos];
+            if (c == '{') {
+                std::size_t end = text.find('}', pos);
+                pos = end == std::string_view::npos ? size : end;
+            } else if (c == '(') {
+                depth++;
+            } else if (c == ')' && --depth == 0) {
+                return pos + 1;
+            }
+            pos++;
+        }
+        return size;
+    }
+
+    bool isResult(std::string_view token) {
+        return token == "1-0" || token == "0-1" || token == "1/2-1/2" || token == "*";
+    }
+
+    // Start of the last game that follows another: just past a termination
+    // marker, or a tag section after movetext. The text is read the way
+    // parseChunk reads it, so that a marker or '[' inside a comment, a
+    // variation or a tag value is never taken for one. 0 if there is none.
+    // `text` must start outside any comment, as every chunk does.
+    std::size_t findGameStart(std::string_view text) {
+        std::size_t size = text.size();
+        std::size_t start = 0;
+        bool movetext = false;
+        std::size_t pos = 0;
+        while (pos < size) {
+            char c = text[pos];
+            if (isSpace(c)) {
+                pos++;
+            } else if (c == '[') {
+                if (movetext) {
+                    start = pos;
+                    movetext = false;
+                }
+                std::size_t end = text.find('\n', pos);
+                pos = end == std::string_view::npos ? size : end;
+            } else if (c == '{') {
+                std::size_t end = text.find('}', pos);
+                pos = end == std::string_view::npos ? size : end + 1;
+            } else if (c == ';' || (c == '%' && (pos == 0 || text[pos - 1] == '\n'))) {
+                std::size_t end = text.find('\n', pos);
+                pos = end == std::string_view::npos ? size : end;
+            } else if (c == '(') {
+                pos = skipVariation(text, pos);
+            } else if (c == '$' || c == ')' || c == ']' || c == '}') {
+                pos++;
+                while (pos < size && !isDelimiter(text[pos])) pos++;
+            } else {
+                std::size_t tokenStart = pos;
+                while (pos < size && !isDelimiter(text[pos])) pos++;
+                movetext = true;
+                if (isResult(text.substr(tokenStart, pos - tokenStart))) {
+                    start = pos;
+                    movetext = false;
+                }
+            }
+        }
+        return start;
+    }
+
+    // Fill `text` with the carried-over start of the next chunk and at least
+    // `chunkSize` bytes more of the file (unless it ends), then move what
+    // follows the last game boundary back into `carry`
+    bool readChunk(std::FILE* file, std::size_t chunkSize, std::string& carry, std::string& text, bool& eof) {
+        text.assign(carry);
+        carry.clear();
+        std::size_t target = std::max(chunkSize, text.size() + 1);
+        while (true) {
+            std::size_t have = text.size();
+            if (!eof && have < target) {
+                text.resize(target);
+                std::size_t read = std::fread(text.data() + have, 1, target - have, file);
+                text.resize(have + read);
+                if (read < target - have) {
+                    if (std::ferror(file)) {
+                        return false;
+                    }
+                    eof = true;
+                }
+            }
+            if (eof) {
+                return true;
+            }
+            std::size_t cut = findGameStart(text);
+            if (cut > 0) {
+                carry.assign(text, cut, std::string::npos);
+                text.resize(cut);
+                return true;
+            }
+            // One game longer than a chunk
+            target *= 2;
+        }
+    }
+
+    const char* describe(SanStatus status) {
+        switch (status) {
+        case SanStatus::Malformed:
+            return "unreadable move";
+        case SanStatus::NoMove:
+            return "no legal move matches";
+        default:
+            return "ambiguous move";
+        }
+    }
+}
+
+GameImporter::GameImporter(const RuleSet& rules, unsigned threads, std::size_t chunkSize)
+    : rules(rules), chunkSize(std::max<std::size_t>(chunkSize, 1)), pool(threads) {
+    for (unsigned i = 0; i < pool.getThreadCount(); ++i) {
+        workers.push_back(std::make_unique<Worker>(rules));
+    }
+    // Two chunks per thread, so that one slow chunk does not idle the rest
+    chunks.resize(pool.getThreadCount() * 2);
+    startState.reset(rules);
+}
+
+bool GameImporter::import(const std::string& path, GameRecordWriter& archive, GameImportStats& stats) {
+    std::FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file) {
+        std::cerr << "Failed to open game file: " << path << std::endl;
+        return false;
+    }
+    auto start = std::chrono::steady_clock::now();
+    std::string carry;
+    bool eof = false;
+    bool ok = true;
+    std::size_t firstLine = 1;
+    std::uint64_t skipped = 0;
+    int reported = 0;
+    while (ok && !(eof && carry.empty())) {
+        std::size_t count = 0;
+        while (count < chunks.size() && !(eof && carry.empty())) {
+            if (!readChunk(file, chunkSize, carry, chunks[count].text, eof)) {
+                std::cerr << "Failed to read game file: " << path << std::endl;
+                ok = false;
+                break;
+            }
+            stats.bytes += chunks[count].text.size();
+            count++;
+        }
+        pool.parallelFor(count, [this](unsigned worker, std::size_t index) {
+            parseChunk(*workers[worker], chunks[index]);
+        });
+
+        // In file order
+        for (std::size_t i = 0; i < count; ++i) {
+            const Chunk& chunk = chunks[i];
+            for (const ImportError& error : chunk.errors) {
+                if (reported++ < kMaxReported) {
+                    const char* text = chunk.text.data();
+                    auto line = firstLine + static_cast<std::size_t>(std::count(text, text + error.offset, '\n'));
+                    std::cerr << path << ":" << line << ": " << error.message << std::endl;
+                }
+            }
+            for (const ParsedGame& game : chunk.games) {
+                if (!archive.writeIndices(game.result, chunk.indices.data() + game.first, game.plies)) {
+                    std::cerr << "Game archive is not open for writing" << std::endl;
+                    ok = false;
+                    break;
+                }
+                stats.games++;
+                stats.moves += game.plies;
+            }
+            skipped += chunk.skipped;
+            firstLine += chunk.lines;
+        }
+    }
+    std::fclose(file);
+    if (skipped > static_cast<std::uint64_t>(std::min(reported, kMaxReported))) {
+        std::cerr << path << ": " << skipped << " games skipped in all" << std::endl;
+    }
+    stats.skipped += skipped;
+    stats.seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return ok;
+}
+
+void GameImporter::parseChunk(Worker& worker, Chunk& chunk) const {
+    chunk.indices.clear();
+    chunk.games.clear();
+    chunk.errors.clear();
+    chunk.skipped = 0;
+    const std::string& text = chunk.text;
+    chunk.lines = static_cast<std::size_t>(std::count(text.begin(), text.end(), '\n'));
+
+    // The game being read
+    bool inGame = false;
+    bool inMovetext = false;
+    bool failed = false;
+    std::size_t first = 0;
+    auto beginGame = [&]() {
+        worker.state.reset(rules);
+        worker.attacks.build(worker.state);
+        inGame = true;
+        inMovetext = false;
+        failed = false;
+        first = chunk.indices.size();
+    };
+    auto fail = [&](std::size_t offset, std::string message) {
+        if (failed) return;
+        failed = true;
+        if (chunk.errors.size() < static_cast<std::size_t>(kMaxReported)) {
+            chunk.errors.push_back(ImportError{offset, std::move(message)});
+        }
+    };
+    auto finishGame = [&](GameResult result) {
+        if (failed) {
+            chunk.skipped++;
+            chunk.indices.resize(first);
+        } else {
+            chunk.games.push_back(ParsedGame{result, first, chunk.indices.size() - first});
+        }
+        inGame = false;
+    };
+
+    std::size_t size = text.size();
+    std::size_t pos = 0;
+    while (pos < size) {
+        char c = text[pos];
+        if (isSpace(c)) {
+            pos++;
+        } else if (c == '[') {
+            // Tag pair; tags after movetext start the next game
+            if (inGame && inMovetext) {
+                finishGame(GameResult::Unknown);
+            }
+            if (!inGame) {
+                beginGame();
+            }
+            std::size_t lineEnd = text.find('\n', pos);
+            lineEnd = lineEnd == std::string::npos ? size : lineEnd;
+            std::string_view tag(text.data() + pos + 1, lineEnd - pos - 1);
+            std::size_t open = tag.find('"');
+            std::size_t close = open == std::string_view::npos ? open : tag.find('"', open + 1);
+            if (tag.substr(0, 4) == "FEN " && close != std::string_view::npos) {
+                // Same pieces, rights, side, en-passant square and cooldowns
+                // (all in the hash) as the start; the move number does not
+                // matter
+                GameState& fen = worker.tagState;
+                if (!fen.readFen(rules, tag.substr(open + 1, close - open - 1))) {
+                    fail(pos, "skipped game: unreadable FEN tag");
+                } else if (fen.hash != startState.hash ||
+                           std::memcmp(fen.squares, startState.squares, sizeof(fen.squares)) != 0) {
+                    fail(pos, "skipped game: it does not start from the start position");
+                }
+            }
+            pos = lineEnd;
+        } else if (c == '{') {
+            std::size_t end = text.find('}', pos);
+            pos = end == std::string::npos ? size : end + 1;
+        } else if (c == ';' || (c == '%' && (pos == 0 || text[pos - 1] == '\n'))) {
+            std::size_t end = text.find('\n', pos);
+            pos = end == std::string::npos ? size : end;
+        } else if (c == '(') {
+            // Variation, possibly nested and with comments
+            pos = skipVariation(text, pos);
+        } else if (c == '$' || c == ')' || c == ']' || c == '}') {
+            pos++;
+            while (pos < size && !isDelimiter(text[pos])) pos++;
+        } else {
+            std::size_t tokenStart = pos;
+            while (pos < size && !isDelimiter(text[pos])) pos++;
+            std::string_view token(text.data() + tokenStart, pos - tokenStart);
+            if (!inGame) {
+                beginGame();
+            }
+            inMovetext = true;
+            if (isResult(token)) {
+                finishGame(token == "1-0" ? GameResult::WhiteWin
+                                          : token == "0-1" ? GameResult::BlackWin
+                                                           : token == "*" ? GameResult::Unknown : GameResult::Draw);
+                continue;
+            }
+
+            // Move number ("12." or "12...") and the move written against it
+            std::size_t skip = 0;
+            if (token.substr(0, 3) != "0-0") {
+                while (skip < token.size() && token[skip] >= '0' && token[skip] <= '9') skip++;
+                if (skip == token.size() || token[skip] == '.') {
+                    while (skip < token.size() && token[skip] == '.') skip++;
+                } else {
+                    skip = 0;
+                }
+            }
+            token.remove_prefix(skip);
+            if (token.empty() || failed) {
+                continue;
+            }
+            EngineMove move;
+            int index = 0;
+            SanStatus status = worker.san.parse(worker.state, worker.attacks, token, move, index);
+            if (status != SanStatus::Ok) {
+                fail(tokenStart, std::string("skipped game: ") + describe(status) + " '" + std::string(token) +
+                                     "' at ply " + std::to_string(chunk.indices.size() - first + 1));
+                continue;
+            }
+            chunk.indices.push_back(static_cast<std::uint32_t>(index));
+            int changed[4];
+            int changedCount = worker.generator.getChangedSquares(move, changed);
+            worker.generator.makeMove(worker.state, move);
+            worker.attacks.update(worker.state, changed, changedCount);
+        }
+    }
+
+    // A game cut off by the end of the file
+    if (inGame && inMovetext) {
+        finishGame(GameResult::Unknown);
+    }
+}
@@ -1,9 +1,41 @@
 #include "../include/GameManager.hpp"
+#include <algorithm>
 #include <iostream> // For std::cout, std::cerr
+#include <string>
 
-GameManager::GameManager(const GameConfig& config)
-    : gameConfig_(config), board_(config.game_settings.board_size) {
-    // Constructor can be simple, initialization happens in initializeGame()
+namespace {
+    const char *colorName(Color color) {
+        return color == Color::WHITE ? "White" : "Black";
+    }
+}
+
+GameManager::GameManager(const GameConfig& config, std::shared_ptr<const RuleSet> rules)
+    : gameConfig_(config), board_(config.game_settings.board_size),
+      portals_(config.game_settings.board_size),
+      rules_(rules ? std::move(rules) : std::shared_ptr<const RuleSet>(RuleSet::compile(config))), state_() {
+    // Piece setup is prepared once here, initialization happens in initializeGame()
+    preparePieceSetup();
+    preparePortals();
+    if (rules_ && !resolvePieceKinds()) {
+        rules_.reset();
+    }
+
+    // The move history is sized for a full game up front so that playing
+    // moves does not allocate. Every cooldown that expires was started by a
+    // move or by the loaded position, so the expiries fit in as much again
+    // plus one per portal.
+    if (rules_) {
+        generator_.emplace(*rules_);
+        attacks_ = std::make_unique<AttackMap>(*rules_);
+        std::size_t turns = static_cast<std::size_t>(std::clamp(rules_->turnLimit, 0, 4096));
+        history_.reserve(turns);
+        cooldownUndo_.reserve(turns + static_cast<std::size_t>(portals_.getPortalCount()));
+    }
+}
+
+GameManager::GameManager(std::shared_ptr<const CompiledConfig> compiled)
+    : GameManager(compiled->config, compiled->rules) {
+    compiled_ = std::move(compiled);
 }
 
 // Helper to convert config structs to maps needed for piece creation
@@ -29,57 +61,356 @@ GameManager::convertConfigMapsForPieceCreation(const Movement& m_conf, const Spe
     return std::make_pair(movement_map, abilities_map);
 }
 
-void GameManager::initializeGame() {
-    // Populate the board with standard pieces
-    for (const auto &piece_config : gameConfig_.pieces) {
-        auto [movement_map, abilities_map] = convertConfigMapsForPieceCreation(piece_config.movement, piece_config.special_abilities);
+void GameManager::preparePieceSetup() {
+    auto addPieces = [this](const PieceConfig& piece_config, bool custom) {
+        pieceProperties_.push_back(convertConfigMapsForPieceCreation(piece_config.movement, piece_config.special_abilities));
+        std::size_t propertiesIndex = pieceProperties_.size() - 1;
         if (piece_config.positions.count("white")) {
             for (const auto &pos : piece_config.positions.at("white")) {
-                auto piece = ChessPiece::createPiece(piece_config.type, Color::WHITE, movement_map, abilities_map);
-                if (piece) {
-                    board_.placePiece(std::move(piece), {pos.x, pos.y});
-                } else {
-                    std::cerr << "Failed to create piece: " << piece_config.type << std::endl;
-                }
+                pieceSetup_.push_back({piece_config.type, Color::WHITE, pos, propertiesIndex, custom});
             }
         }
         if (piece_config.positions.count("black")) {
             for (const auto &pos : piece_config.positions.at("black")) {
-                auto piece = ChessPiece::createPiece(piece_config.type, Color::BLACK, movement_map, abilities_map);
-                if (piece) {
-                    board_.placePiece(std::move(piece), {pos.x, pos.y});
-                } else {
-                    std::cerr << "Failed to create piece: " << piece_config.type << std::endl;
-                }
+                pieceSetup_.push_back({piece_config.type, Color::BLACK, pos, propertiesIndex, custom});
             }
         }
-    }
+    };
 
-    // Populate the board with custom pieces (if any)
+    // Standard pieces first, then custom pieces (if any)
+    for (const auto &piece_config : gameConfig_.pieces) {
+        addPieces(piece_config, false);
+    }
     for (const auto &piece_config : gameConfig_.custom_pieces) {
-        auto [movement_map, abilities_map] = convertConfigMapsForPieceCreation(piece_config.movement, piece_config.special_abilities);
-        if (piece_config.positions.count("white")) {
-            for (const auto &pos : piece_config.positions.at("white")) {
-                auto piece = ChessPiece::createPiece(piece_config.type, Color::WHITE, movement_map, abilities_map);
-                if (piece) {
-                    board_.placePiece(std::move(piece), {pos.x, pos.y});
-                } else {
-                    std::cerr << "Failed to create custom piece: " << piece_config.type << std::endl;
-                }
+        addPieces(piece_config, true);
+    }
+}
+
+void GameManager::initializeGame() {
+    // Drop the previous game's pieces, then hand their memory back in one go
+    board_.clear();
+    arena_.release();
+
+    // Populate the board from the prepared setup
+    for (const auto &setup : pieceSetup_) {
+        const auto &[movement_map, abilities_map] = pieceProperties_[setup.propertiesIndex];
+        auto piece = ChessPiece::createPiece(setup.type, setup.color, movement_map, abilities_map, arena_.resource());
+        if (piece) {
+            board_.placePiece(std::move(piece), setup.position);
+        } else {
+            std::cerr << (setup.custom ? "Failed to create custom piece: " : "Failed to create piece: ")
+                      << setup.type << std::endl;
+        }
+    }
+
+    // Portals start open; the compact position mirrors the board
+    portals_.resetCooldowns();
+    if (rules_) {
+        state_.reset(*rules_);
+        startFromState();
+    }
+}
+
+bool GameManager::captureState(Color sideToMove) {
+    std::uint16_t ply = state_.ply;
+    if (!rules_ || !state_.loadFromBoard(*rules_, board_, sideToMove, &portals_)) {
+        return false;
+    }
+    state_.ply = ply;
+    startFromState();
+    return true;
+}
+
+bool GameManager::restoreState(const GameState& state) {
+    if (!rules_) {
+        return false;
+    }
+
+    // Pieces are recreated with the properties of the first setup entry of
+    // their type; the arena is emptied with the board, as in initializeGame()
+    board_.clear();
+    arena_.release();
+    bool complete = state.storeToBoard(*rules_, board_,
+                                       [this](std::string_view type, Color color) { return createPiece(type, color); },
+                                       &portals_);
+    state_ = state;
+    startFromState();
+    return complete;
+}
+
+// Match every compiled piece kind to its config entry, so that a promotion
+// or a taken-back capture can always create the piece, even of a kind that
+// has no starting squares. Kinds are compiled from the same entries, in the
+// order of pieceProperties_.
+bool GameManager::resolvePieceKinds() {
+    kindSetup_.assign(static_cast<std::size_t>(rules_->kindCount), KindSetup{nullptr, 0});
+    std::size_t propertiesIndex = 0;
+    for (const auto *pieces : {&gameConfig_.pieces, &gameConfig_.custom_pieces}) {
+        for (const auto &piece_config : *pieces) {
+            int kind = rules_->findKind(piece_config.type);
+            if (kind >= 0 && !kindSetup_[kind].type) {
+                kindSetup_[kind] = KindSetup{&piece_config.type, propertiesIndex};
             }
+            ++propertiesIndex;
         }
-        if (piece_config.positions.count("black")) {
-            for (const auto &pos : piece_config.positions.at("black")) {
-                auto piece = ChessPiece::createPiece(piece_config.type, Color::BLACK, movement_map, abilities_map);
-                if (piece) {
-                    board_.placePiece(std::move(piece), {pos.x, pos.y});
-                } else {
-                    std::cerr << "Failed to create custom piece: " << piece_config.type << std::endl;
-                }
+    }
+    for (int kind = 0; kind < rules_->kindCount; ++kind) {
+        if (!kindSetup_[kind].type) {
+            std::cerr << "Piece type " << rules_->kinds[kind].name << " of the rules is not in the config"
+                      << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+PiecePtr GameManager::createPiece(int kind, Color color) {
+    const KindSetup &setup = kindSetup_[kind];
+    const auto &[movement_map, abilities_map] = pieceProperties_[setup.propertiesIndex];
+    return ChessPiece::createPiece(*setup.type, color, movement_map, abilities_map, arena_.resource());
+}
+
+PiecePtr GameManager::createPiece(std::string_view type, Color color) {
+    int kind = rules_->findKind(type);
+    return kind >= 0 ? createPiece(kind, color) : nullptr;
+}
+
+// A new position: earlier moves can no longer be taken back
+void GameManager::startFromState() {
+    history_.clear();
+    cooldownUndo_.clear();
+    attacks_->build(state_);
+    updateStatus();
+}
+
+bool GameManager::processMove(const Position& from, const Position& to) {
+    return processMove(Move(from, to));
+}
+
+bool GameManager::processMove(const Move& move) {
+    EngineMove engineMove;
+    if (!generator_ || isGameOver() || !generator_->fromMove(state_, move, engineMove) ||
+        !generator_->isLegal(state_, *attacks_, engineMove)) {
+        return false;
+    }
+    playMove(engineMove);
+    return true;
+}
+
+bool GameManager::playEngineMove(const SearchLimits& limits, bool* fromBook) {
+    if (!generator_ || isGameOver()) {
+        return false;
+    }
+    EngineMove engineMove{};
+    bool bookMove = book_ && book_->probe(state_, *attacks_, *generator_, engineMove, random_());
+    if (!bookMove) {
+        if (!search_) {
+            search_ = std::make_unique<Search>(*rules_);
+        }
+        engineMove = search_->think(state_, *attacks_, limits).move;
+        if (engineMove.pack() == 0) {
+            return false;
+        }
+    }
+    if (fromBook) {
+        *fromBook = bookMove;
+    }
+    playMove(engineMove);
+    return true;
+}
+
+// Play a legal move
+void GameManager::playMove(const EngineMove &engineMove) {
+    // The board is updated from the position before the move
+    applyToBoard(engineMove);
+
+    HistoryEntry &entry = history_.emplace_back();
+    entry.move = engineMove;
+    int changed[4];
+    int changedCount = generator_->getChangedSquares(engineMove, changed);
+    generator_->makeMove(state_, engineMove, entry.undo);
+    attacks_->update(state_, changed, changedCount);
+
+    // Same turn order as the generator: cooldowns tick, then the portal used
+    // starts its own
+    portals_.processCooldowns(&cooldownUndo_);
+    entry.portalUndo = PortalCooldownUndo{-1, 0};
+    if (engineMove.portal != kNoPortal) {
+        entry.portalUndo = portals_.usePortal(engineMove.portal);
+    }
+
+    updateStatus();
+}
+
+bool GameManager::undoMove() {
+    if (history_.empty()) {
+        return false;
+    }
+    const HistoryEntry &entry = history_.back();
+    int changed[4];
+    int changedCount = generator_->getChangedSquares(entry.move, changed);
+    generator_->unmakeMove(state_, entry.move, entry.undo);
+    attacks_->update(state_, changed, changedCount);
+    if (entry.portalUndo.portalIndex >= 0) {
+        portals_.undoUsePortal(entry.portalUndo);
+    }
+    portals_.undoProcessCooldowns(cooldownUndo_);
+    undoOnBoard(entry.move, entry.undo);
+    history_.pop_back();
+    updateStatus();
+    return true;
+}
+
+void GameManager::getLegalMoves(MoveList &moves) {
+    moves.count = 0;
+    if (generator_) {
+        generator_->generateLegal(state_, *attacks_, moves);
+    }
+}
+
+void GameManager::applyToBoard(const EngineMove &move) {
+    auto positionOf = [this](int square) { return Position(rules_->fileOf(square), rules_->rankOf(square)); };
+    Position from = positionOf(move.from);
+    PiecePtr piece = board_.removePiece(from);
+    if (!piece) {
+        return;
+    }
+    piece->setMoved();
+
+    if (move.special() == EngineMove::kCastle) {
+        int direction = move.to > move.from ? 1 : -1;
+        PiecePtr partner = board_.removePiece(positionOf(move.to));
+        board_.placePiece(std::move(piece), positionOf(move.from + 2 * direction));
+        if (partner) {
+            partner->setMoved();
+            board_.placePiece(std::move(partner), positionOf(move.from + direction));
+        }
+        return;
+    }
+
+    board_.removePiece(positionOf(generator_->getCapturedSquare(move)));
+    if (move.isPromotion()) {
+        piece = createPiece(move.promotionKind(), piece->getColor());
+        piece->setMoved();
+    }
+    board_.placePiece(std::move(piece), positionOf(move.to));
+}
+
+// Inverse of applyToBoard: the pieces that moved go back, and only a captured
+// piece or a promoted pawn is created again
+void GameManager::undoOnBoard(const EngineMove &move, const UndoInfo &undo) {
+    auto positionOf = [this](int square) { return Position(rules_->fileOf(square), rules_->rankOf(square)); };
+    Position from = positionOf(move.from);
+
+    if (move.special() == EngineMove::kCastle) {
+        // Both pieces were unmoved: castling needs that
+        int direction = move.to > move.from ? 1 : -1;
+        PiecePtr piece = board_.removePiece(positionOf(move.from + 2 * direction));
+        PiecePtr partner = board_.removePiece(positionOf(move.from + direction));
+        if (piece) {
+            piece->setMoved(false);
+            board_.placePiece(std::move(piece), from);
+        }
+        if (partner) {
+            partner->setMoved(false);
+            board_.placePiece(std::move(partner), positionOf(move.to));
+        }
+        return;
+    }
+
+    PiecePtr piece = board_.removePiece(positionOf(move.to));
+    if (move.isPromotion()) {
+        piece = createPiece(pieceKind(undo.piece), pieceColor(undo.piece));
+    }
+    if (piece) {
+        piece->setMoved(!undo.fromUnmoved);
+        board_.placePiece(std::move(piece), from);
+    }
+    if (undo.captured != kEmptySquare) {
+        PiecePtr captured = createPiece(pieceKind(undo.captured), pieceColor(undo.captured));
+        captured->setMoved(!undo.capturedUnmoved);
+        board_.placePiece(std::move(captured), positionOf(generator_->getCapturedSquare(move)));
+    }
+}
+
+void GameManager::updateStatus() {
+    Color player = state_.sideToMove;
+    if (!generator_->hasLegalMove(state_, *attacks_)) {
+        status_ = attacks_->isInCheck(player) ? GameStatus::Checkmate : GameStatus::Stalemate;
+    } else if (rules_->turnLimit > 0 && state_.ply >= rules_->turnLimit) {
+        status_ = GameStatus::TurnLimit;
+    } else {
+        status_ = GameStatus::Ongoing;
+    }
+}
+
+void GameManager::runGame(std::istream &in, std::ostream &out) {
+    if (!generator_) {
+        out << "This variant exceeds the move generator's limits; it cannot be played" << std::endl;
+        return;
+    }
+
+    std::string line;
+    while (!isGameOver()) {
+        out << "\n==== Current Board State ====" << std::endl;
+        board_.displayBoard(out);
+        out << colorName(getCurrentPlayer()) << " to move: " << std::flush;
+        if (!std::getline(in, line)) {
+            out << std::endl;
+            return;
+        }
+
+        std::size_t pos = 0;
+        Position from;
+        Position to;
+        if (line == "go") {
+            Color player = getCurrentPlayer();
+            bool fromBook = false;
+            if (playEngineMove(SearchLimits{}, &fromBook)) {
+                const Move played = generator_->toMove(history_.back().move);
+                out << colorName(player) << " plays " << played.from.toChessNotation() << " "
+                    << played.to.toChessNotation() << (fromBook ? " (book)" : "") << std::endl;
+            }
+        } else if (!Position::parseNotation(line, pos, from) || !Position::parseNotation(line, pos, to)) {
+            out << "Enter a move as two squares, e.g. e2 e4" << std::endl;
+        } else if (!processMove(from, to)) {
+            out << "Illegal move" << std::endl;
+        }
+    }
+
+    board_.displayBoard(out);
+    switch (status_) {
+    case GameStatus::Checkmate:
+        out << "Checkmate, " << colorName(getCurrentPlayer() == Color::WHITE ? Color::BLACK : Color::WHITE)
+            << " wins" << std::endl;
+        break;
+    case GameStatus::Stalemate:
+        out << "Stalemate" << std::endl;
+        break;
+    case GameStatus::TurnLimit:
+        out << "Turn limit of " << rules_->turnLimit << " reached, the game is drawn" << std::endl;
+        break;
+    case GameStatus::Ongoing:
+        break;
+    }
+}
+
+void GameManager::preparePortals() {
+    for (const auto &portal_config : gameConfig_.portals) {
+        auto portal = std::make_unique<Portal>(portal_config.id,
+                                               portal_config.positions.entry,
+                                               portal_config.positions.exit,
+                                               portal_config.properties.preserve_direction,
+                                               portal_config.properties.cooldown);
+        if (!portal_config.properties.allowed_colors.empty()) {
+            portal->clearAllowedColors();
+            for (const auto &color : portal_config.properties.allowed_colors) {
+                if (color == "white") portal->addAllowedColor(Color::WHITE);
+                if (color == "black") portal->addAllowedColor(Color::BLACK);
             }
         }
+        portals_.addPortal(std::move(portal));
     }
-    // TODO: Initialize portals on the board if PortalSystem is part of GameManager or ChessBoard
 }
 
 void GameManager::displayBoard() const {
@@ -0,0 +1,263 @@
+#include "../include/GameRecord.hpp"
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+    constexpr std::uint32_t kByteOrderMark = 0x01020304;
+    constexpr long kCountOffset = 24;
+
+    struct GameRecordHeader {
+        char magic[8];
+        std::uint32_t version;
+        std::uint32_t byteOrder;
+        std::uint64_t configHash;
+        std::uint64_t gameCount;
+    };
+
+    void putVarint(std::vector<std::uint8_t>& out, std::uint64_t value) {
+        while (value >= 0x80) {
+            out.push_back(static_cast<std::uint8_t>(value | 0x80));
+            value >>= 7;
+        }
+        out.push_back(static_cast<std::uint8_t>(value));
+    }
+
+    bool getVarint(const std::uint8_t*& cursor, const std::uint8_t* end, std::uint64_t& value) {
+        value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            if (cursor == end) {
+                return false;
+            }
+            std::uint8_t byte = *cursor++;
+            value |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+            if (byte < 0x80) {
+                return true;
+            }
+        }
+        return false;
+    }
+}
+
+GameRecordWriter::GameRecordWriter(const RuleSet& rules)
+    : rules(rules), generator(rules), attacks(rules), moves(std::make_unique<MoveList>()) {
+    buffer.reserve(kBufferSize);
+}
+
+GameRecordWriter::~GameRecordWriter() {
+    close();
+}
+
+bool GameRecordWriter::open(const std::string& path, std::uint64_t configHash) {
+    close();
+    std::lock_guard<std::mutex> lock(mutex);
+    GameRecordHeader header{};
+    file = std::fopen(path.c_str(), "r+b");
+    if (file && std::fread(&header, sizeof(header), 1, file) == 1) {
+        if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 || header.version != kVersion ||
+            header.byteOrder != kByteOrderMark) {
+            std::cerr << "Not a game archive of this version, not appending to it: " << path << std::endl;
+        } else if (header.configHash != configHash) {
+            std::cerr << "Game archive was written for another config: " << path << std::endl;
+        } else if (std::fseek(file, 0, SEEK_END) == 0) {
+            count = header.gameCount;
+            failed = false;
+            return true;
+        }
+        std::fclose(file);
+        file = nullptr;
+        return false;
+    }
+
+    // Missing or empty: start a new archive
+    if (file) {
+        std::fclose(file);
+    }
+    file = std::fopen(path.c_str(), "wb");
+    if (!file) {
+        std::cerr << "Failed to create game archive: " << path << std::endl;
+        return false;
+    }
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kVersion;
+    header.byteOrder = kByteOrderMark;
+    header.configHash = configHash;
+    header.gameCount = 0;
+    count = 0;
+    failed = std::fwrite(&header, sizeof(header), 1, file) != 1;
+    return !failed;
+}
+
+bool GameRecordWriter::write(GameResult result, const std::uint32_t* played, std::size_t plies) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!file) {
+        return false;
+    }
+    record.clear();
+    record.push_back(static_cast<std::uint8_t>(result));
+    putVarint(record, plies);
+    state.reset(rules);
+    attacks.build(state);
+    for (std::size_t ply = 0; ply < plies; ++ply) {
+        EngineMove move = EngineMove::unpack(played[ply]);
+        generator.generate(state, *moves);
+        const EngineMove* found = std::find(moves->begin(), moves->end(), move);
+        if (found == moves->end() || !generator.isLegal(state, attacks, move)) {
+            std::cerr << "Game has an illegal move at ply " << ply + 1 << "; not archived" << std::endl;
+            return false;
+        }
+        putVarint(record, static_cast<std::uint64_t>(found - moves->begin()));
+        int changed[4];
+        int changedCount = generator.getChangedSquares(move, changed);
+        generator.makeMove(state, move);
+        attacks.update(state, changed, changedCount);
+    }
+
+    appendRecord();
+    return true;
+}
+
+bool GameRecordWriter::writeIndices(GameResult result, const std::uint32_t* indices, std::size_t plies) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!file) {
+        return false;
+    }
+    record.clear();
+    record.push_back(static_cast<std::uint8_t>(result));
+    putVarint(record, plies);
+    for (std::size_t ply = 0; ply < plies; ++ply) {
+        putVarint(record, indices[ply]);
+    }
+    appendRecord();
+    return true;
+}
+
+void GameRecordWriter::appendRecord() {
+    putVarint(buffer, record.size());
+    buffer.insert(buffer.end(), record.begin(), record.end());
+    count++;
+    if (buffer.size() >= kBufferSize) {
+        flush();
+    }
+}
+
+bool GameRecordWriter::flush() {
+    if (!buffer.empty() && std::fwrite(buffer.data(), 1, buffer.size(), file) != buffer.size()) {
+        failed = true;
+    }
+    buffer.clear();
+    return !failed;
+}
+
+bool GameRecordWriter::close() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!file) {
+        return !failed;
+    }
+    bool ok = flush() && std::fseek(file, kCountOffset, SEEK_SET) == 0 &&
+              std::fwrite(&count, sizeof(count), 1, file) == 1;
+    ok = std::fclose(file) == 0 && ok;
+    file = nullptr;
+    failed = !ok;
+    return ok;
+}
+
+GameRecordReader::~GameRecordReader() {
+    if (data) {
+        munmap(const_cast<std::uint8_t*>(data), size);
+    }
+}
+
+std::shared_ptr<const GameRecordReader> GameRecordReader::open(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        std::cerr << "Failed to open game archive: " << path << std::endl;
+        return nullptr;
+    }
+    struct stat info {};
+    if (fstat(fd, &info) != 0 || static_cast<std::size_t>(info.st_size) < sizeof(GameRecordHeader)) {
+        std::cerr << "Game archive is truncated: " << path << std::endl;
+        ::close(fd);
+        return nullptr;
+    }
+    std::size_t size = static_cast<std::size_t>(info.st_size);
+    void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        std::cerr << "Failed to map game archive: " << path << std::endl;
+        return nullptr;
+    }
+    // Records are read front to back
+    madvise(mapping, size, MADV_SEQUENTIAL);
+
+    // Owns the mapping from here on, so every early return unmaps it
+    const auto* bytes = static_cast<const std::uint8_t*>(mapping);
+    std::unique_ptr<GameRecordReader> reader(new GameRecordReader(bytes, size));
+    const auto& header = *reinterpret_cast<const GameRecordHeader*>(bytes);
+    if (std::memcmp(header.magic, GameRecordWriter::kMagic, sizeof(header.magic)) != 0) {
+        std::cerr << "Not a game archive: " << path << std::endl;
+        return nullptr;
+    }
+    if (header.version != GameRecordWriter::kVersion || header.byteOrder != kByteOrderMark) {
+        std::cerr << "Game archive was written by another version: " << path << std::endl;
+        return nullptr;
+    }
+    reader->records = bytes + sizeof(GameRecordHeader);
+    reader->recordBytes = size - sizeof(GameRecordHeader);
+    reader->configHash = header.configHash;
+    reader->gameCount = header.gameCount;
+    return reader;
+}
+
+bool GameRecordReader::next(std::size_t& offset, GameRecordView& game) const {
+    if (offset >= recordBytes) {
+        return false;
+    }
+    const std::uint8_t* cursor = records + offset;
+    const std::uint8_t* end = records + recordBytes;
+    std::uint64_t length = 0;
+    if (!getVarint(cursor, end, length) || length < 2 || length > static_cast<std::uint64_t>(end - cursor)) {
+        return false;
+    }
+    end = cursor + length;
+    std::uint64_t plies = 0;
+    game.result = static_cast<GameResult>(*cursor++);
+    if (game.result > GameResult::Unknown || !getVarint(cursor, end, plies) || plies > UINT32_MAX) {
+        return false;
+    }
+    game.plies = static_cast<std::uint32_t>(plies);
+    game.moves = cursor;
+    game.end = end;
+    offset = static_cast<std::size_t>(end - records);
+    return true;
+}
+
+GameReplayer::GameReplayer(const RuleSet& rules)
+    : rules(rules), generator(rules), moves(std::make_unique<MoveList>()) {}
+
+void GameReplayer::start(const GameRecordView& game) {
+    state.reset(rules);
+    cursor = game.moves;
+    end = game.end;
+    remaining = game.plies;
+}
+
+bool GameReplayer::next(EngineMove& move) {
+    std::uint64_t index = 0;
+    if (remaining == 0 || !getVarint(cursor, end, index)) {
+        return false;
+    }
+    generator.generate(state, *moves);
+    if (index >= static_cast<std::uint64_t>(moves->count)) {
+        remaining = 0;
+        return false;
+    }
+    move = moves->moves[index];
+    generator.makeMove(state, move);
+    remaining--;
+    return true;
+}
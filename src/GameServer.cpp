@@ -0,0 +1,479 @@
+#include "../include/GameServer.hpp"
+#include "../include/GameManager.hpp"
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cerrno>
+#include <charconv>
+#include <cstring>
+#include <iostream>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <optional>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+    constexpr std::size_t kShardQueueCapacity = 16 * 1024;
+    constexpr std::size_t kResponseQueueCapacity = 64 * 1024;
+    constexpr std::size_t kMaxLineLength = 4096;
+    // Replies waiting for a client before its requests stop being read, and
+    // before it is dropped as one that does not read them at all
+    constexpr std::size_t kOutputHighWater = 256 * 1024;
+    constexpr std::size_t kMaxPendingOutput = 16 * 1024 * 1024;
+
+    const char* statusName(GameStatus status) {
+        switch (status) {
+        case GameStatus::Ongoing: return "ongoing";
+        case GameStatus::Checkmate: return "checkmate";
+        case GameStatus::Stalemate: return "stalemate";
+        case GameStatus::TurnLimit: return "turn_limit";
+        }
+        return "ongoing";
+    }
+
+    // Next space-separated word of `line` from `pos`
+    std::string_view nextWord(std::string_view line, std::size_t& pos) {
+        while (pos < line.size() && line[pos] == ' ') ++pos;
+        std::size_t start = pos;
+        while (pos < line.size() && line[pos] != ' ') ++pos;
+        return line.substr(start, pos - start);
+    }
+
+    bool parseId(std::string_view word, std::uint64_t& id) {
+        auto result = std::from_chars(word.data(), word.data() + word.size(), id);
+        return result.ec == std::errc() && result.ptr == word.data() + word.size() && !word.empty();
+    }
+}
+
+struct GameServer::Shard {
+    MpscQueue<ServerRequest> inbox{kShardQueueCapacity};
+    std::atomic<std::uint32_t> signal{0}; // Bumped after every push, waited on when idle
+    std::atomic<bool> stopping{false};
+    std::unordered_map<std::uint64_t, std::unique_ptr<GameManager>> games;
+    std::optional<MoveGenerator> generator;
+    std::unique_ptr<MoveList> moves = std::make_unique<MoveList>();
+    std::thread thread;
+
+    void wake() {
+        signal.fetch_add(1, std::memory_order_release);
+        signal.notify_one();
+    }
+};
+
+struct GameServer::Connection {
+    int fd = -1;
+    std::string input;
+    std::string output;
+    bool closing = false; // QUIT received: close once the output is written
+};
+
+GameServer::GameServer(std::shared_ptr<const CompiledConfig> variant, unsigned shardCount)
+    : variant(std::move(variant)), responses(kResponseQueueCapacity) {
+    wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (shardCount == 0) {
+        shardCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+    for (unsigned i = 0; i < shardCount; ++i) {
+        auto shard = std::make_unique<Shard>();
+        if (this->variant->rules) {
+            shard->generator.emplace(*this->variant->rules);
+        }
+        shards.push_back(std::move(shard));
+    }
+    for (auto& shard : shards) {
+        shard->thread = std::thread([this, &shard = *shard] { shardLoop(shard); });
+    }
+}
+
+GameServer::~GameServer() {
+    for (auto& shard : shards) {
+        shard->stopping.store(true);
+        shard->wake();
+        shard->thread.join();
+    }
+    for (auto& [id, connection] : connections) {
+        close(connection->fd);
+    }
+    for (int listener : listeners) {
+        close(listener);
+    }
+    if (!unixPath.empty()) {
+        unlink(unixPath.c_str());
+    }
+    if (wakeFd >= 0) {
+        close(wakeFd);
+    }
+}
+
+bool GameServer::listenUnix(const std::string& path) {
+    sockaddr_un address{};
+    if (path.size() >= sizeof(address.sun_path)) {
+        std::cerr << "Socket path too long: " << path << std::endl;
+        return false;
+    }
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    address.sun_family = AF_UNIX;
+    std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+    unlink(path.c_str());
+    if (fd < 0 || bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+        listen(fd, SOMAXCONN) != 0) {
+        std::cerr << "Cannot listen on " << path << ": " << std::strerror(errno) << std::endl;
+        if (fd >= 0) close(fd);
+        return false;
+    }
+    listeners.push_back(fd);
+    unixPath = path;
+    return true;
+}
+
+bool GameServer::listenTcp(int port) {
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    int reuse = 1;
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(static_cast<std::uint16_t>(port));
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (fd < 0 || setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse)) != 0 ||
+        bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || listen(fd, SOMAXCONN) != 0) {
+        std::cerr << "Cannot listen on port " << port << ": " << std::strerror(errno) << std::endl;
+        if (fd >= 0) close(fd);
+        return false;
+    }
+    listeners.push_back(fd);
+    return true;
+}
+
+void GameServer::stop() {
+    stopping.store(true);
+    std::uint64_t one = 1;
+    ssize_t written = write(wakeFd, &one, sizeof(one));
+    (void)written;
+}
+
+void GameServer::run() {
+    std::vector<pollfd> fds;
+    std::vector<std::uint32_t> ids;
+    while (!stopping.load()) {
+        fds.clear();
+        ids.clear();
+        fds.push_back({wakeFd, POLLIN, 0});
+        for (int listener : listeners) {
+            fds.push_back({listener, POLLIN, 0});
+        }
+        for (auto& [id, connection] : connections) {
+            // A client with too many unread replies is not read from until
+            // it catches up
+            short events = static_cast<short>((connection->output.size() < kOutputHighWater ? POLLIN : 0) |
+                                              (connection->output.empty() ? 0 : POLLOUT));
+            fds.push_back({connection->fd, events, 0});
+            ids.push_back(id);
+        }
+
+        if (poll(fds.data(), fds.size(), -1) < 0) {
+            if (errno == EINTR) continue;
+            std::cerr << "poll failed: " << std::strerror(errno) << std::endl;
+            return;
+        }
+
+        if (fds[0].revents & POLLIN) {
+            std::uint64_t count;
+            ssize_t bytes = read(wakeFd, &count, sizeof(count));
+            (void)bytes;
+            wakePending.store(false);
+            drainResponses();
+        }
+        for (std::size_t i = 0; i < listeners.size(); ++i) {
+            if (fds[1 + i].revents & POLLIN) {
+                acceptConnections(listeners[i]);
+            }
+        }
+        std::size_t first = 1 + listeners.size();
+        for (std::size_t i = 0; i < ids.size(); ++i) {
+            short events = fds[first + i].revents;
+            auto it = connections.find(ids[i]);
+            if (events == 0 || it == connections.end()) {
+                continue;
+            }
+            Connection& connection = *it->second;
+            bool open = true;
+            if (events & (POLLIN | POLLHUP | POLLERR)) {
+                open = readConnection(ids[i], connection);
+            }
+            if (open && (events & POLLOUT)) {
+                open = flushConnection(connection);
+            }
+            if (!open || connection.output.size() > kMaxPendingOutput ||
+                (connection.closing && connection.output.empty())) {
+                close(connection.fd);
+                connections.erase(it);
+            }
+        }
+    }
+}
+
+void GameServer::acceptConnections(int listener) {
+    for (;;) {
+        int fd = accept4(listener, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            return;
+        }
+        // Replies are single short lines: send them at once
+        int noDelay = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+        auto connection = std::make_unique<Connection>();
+        connection->fd = fd;
+        connections.emplace(nextConnection++, std::move(connection));
+    }
+}
+
+bool GameServer::readConnection(std::uint32_t id, Connection& connection) {
+    // One buffer per wakeup, so that a flooding client gets no more turns
+    // than the others and its replies are checked against the limits
+    // between reads
+    char buffer[16 * 1024];
+    ssize_t bytes;
+    do {
+        bytes = recv(connection.fd, buffer, sizeof(buffer), 0);
+    } while (bytes < 0 && errno == EINTR);
+    if (bytes == 0 || (bytes < 0 && errno != EAGAIN && errno != EWOULDBLOCK)) {
+        return false;
+    }
+    if (bytes > 0) {
+        connection.input.append(buffer, static_cast<std::size_t>(bytes));
+    }
+
+    std::size_t start = 0;
+    for (std::size_t end; (end = connection.input.find('\n', start)) != std::string::npos; start = end + 1) {
+        std::string_view line(connection.input.data() + start, end - start);
+        if (!line.empty() && line.back() == '\r') {
+            line.remove_suffix(1);
+        }
+        if (!connection.closing) {
+            handleLine(id, line);
+        }
+    }
+    connection.input.erase(0, start);
+    if (connection.input.size() > kMaxLineLength) {
+        return false;
+    }
+    return flushConnection(connection);
+}
+
+void GameServer::handleLine(std::uint32_t connection, std::string_view line) {
+    std::size_t pos = 0;
+    std::string_view command = nextWord(line, pos);
+    if (command.empty()) {
+        return;
+    }
+    if (command == "NEW") {
+        ServerRequest request;
+        request.kind = ServerRequest::Kind::New;
+        request.connection = connection;
+        request.game = nextGame++;
+        if (!dispatch(std::move(request))) {
+            sendReply(connection, "ERR busy");
+        }
+        return;
+    }
+    if (command == "STATS") {
+        sendReply(connection, "OK games " + std::to_string(getGameCount()) + " shards " +
+                                  std::to_string(shards.size()) + " connections " +
+                                  std::to_string(connections.size()));
+        return;
+    }
+    if (command == "QUIT") {
+        connections[connection]->closing = true;
+        return;
+    }
+
+    ServerRequest request;
+    request.connection = connection;
+    if (command == "MOVE") {
+        request.kind = ServerRequest::Kind::Move;
+    } else if (command == "MOVES") {
+        request.kind = ServerRequest::Kind::Moves;
+    } else if (command == "UNDO") {
+        request.kind = ServerRequest::Kind::Undo;
+    } else if (command == "STATUS") {
+        request.kind = ServerRequest::Kind::Status;
+    } else if (command == "END") {
+        request.kind = ServerRequest::Kind::End;
+    } else {
+        sendReply(connection, "ERR unknown command " + std::string(command));
+        return;
+    }
+
+    std::string_view id = nextWord(line, pos);
+    if (!parseId(id, request.game)) {
+        sendReply(connection, "ERR missing or bad game id");
+        return;
+    }
+    if (request.kind == ServerRequest::Kind::Move &&
+        (!Position::parseNotation(line, pos, request.from) || !Position::parseNotation(line, pos, request.to))) {
+        sendReply(connection, "ERR " + std::string(id) + " expected MOVE <id> <from> <to>");
+        return;
+    }
+    if (!dispatch(std::move(request))) {
+        sendReply(connection, "ERR " + std::string(id) + " busy");
+    }
+}
+
+bool GameServer::dispatch(ServerRequest&& request) {
+    // Every request in flight has room for its reply in the response queue,
+    // so shards never wait on it; past that, or with the shard's inbox full,
+    // the client is told to retry instead of the I/O thread waiting
+    if (inFlight >= responses.getCapacity()) {
+        return false;
+    }
+    Shard& shard = *shards[request.game % shards.size()];
+    if (!shard.inbox.tryPush(std::move(request))) {
+        return false;
+    }
+    inFlight++;
+    shard.wake();
+    return true;
+}
+
+void GameServer::drainResponses() {
+    ServerResponse response;
+    while (responses.tryPop(response)) {
+        inFlight--;
+        auto it = connections.find(response.connection);
+        if (it == connections.end()) {
+            continue; // Closed while its request was in flight
+        }
+        it->second->output += response.text;
+        it->second->output += '\n';
+        flushConnection(*it->second);
+    }
+}
+
+void GameServer::sendReply(std::uint32_t connection, std::string text) {
+    auto it = connections.find(connection);
+    if (it != connections.end()) {
+        it->second->output += text;
+        it->second->output += '\n';
+    }
+}
+
+bool GameServer::flushConnection(Connection& connection) {
+    std::size_t sent = 0;
+    while (sent < connection.output.size()) {
+        ssize_t bytes = send(connection.fd, connection.output.data() + sent, connection.output.size() - sent,
+                             MSG_NOSIGNAL);
+        if (bytes < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+            return false;
+        }
+        sent += static_cast<std::size_t>(bytes);
+    }
+    connection.output.erase(0, sent);
+    return true;
+}
+
+void GameServer::shardLoop(Shard& shard) {
+    ServerRequest request;
+    ServerResponse response;
+    for (;;) {
+        std::uint32_t seen = shard.signal.load(std::memory_order_acquire);
+        bool worked = false;
+        while (shard.inbox.tryPop(request)) {
+            handleRequest(shard, request, response);
+            respond(std::move(response));
+            worked = true;
+        }
+        if (shard.stopping.load()) {
+            return;
+        }
+        if (!worked) {
+            shard.signal.wait(seen, std::memory_order_acquire);
+        }
+    }
+}
+
+void GameServer::respond(ServerResponse&& response) {
+    // Cannot fail: dispatch keeps no more requests in flight than the queue
+    // holds replies
+    responses.tryPush(std::move(response));
+    if (!wakePending.exchange(true)) {
+        std::uint64_t one = 1;
+        ssize_t written = write(wakeFd, &one, sizeof(one));
+        (void)written;
+    }
+}
+
+void GameServer::handleRequest(Shard& shard, ServerRequest& request, ServerResponse& response) {
+    response.connection = request.connection;
+    std::string& out = response.text;
+    out = "OK ";
+    out += std::to_string(request.game);
+
+    if (request.kind == ServerRequest::Kind::New) {
+        auto game = std::make_unique<GameManager>(variant);
+        game->initializeGame();
+        shard.games[request.game] = std::move(game);
+        gameCount.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    auto it = shard.games.find(request.game);
+    if (it == shard.games.end()) {
+        out = "ERR " + std::to_string(request.game) + " no such game";
+        return;
+    }
+    GameManager& game = *it->second;
+
+    switch (request.kind) {
+    case ServerRequest::Kind::Move:
+        if (game.isGameOver()) {
+            out = "ERR " + std::to_string(request.game) + " game over";
+        } else if (!game.processMove(request.from, request.to)) {
+            out = "ERR " + std::to_string(request.game) + " illegal move";
+        } else {
+            out += ' ';
+            out += statusName(game.getStatus());
+        }
+        break;
+    case ServerRequest::Kind::Moves: {
+        // One entry per from/to pair (promotion choices are not listed)
+        game.getLegalMoves(*shard.moves);
+        const EngineMove* previous = nullptr;
+        for (const EngineMove& move : *shard.moves) {
+            if (previous && previous->from == move.from && previous->to == move.to &&
+                previous->portal == move.portal) {
+                continue;
+            }
+            previous = &move;
+            Move described = shard.generator->toMove(move);
+            out += ' ';
+            out += described.from.toChessNotation();
+            out += described.to.toChessNotation();
+        }
+        break;
+    }
+    case ServerRequest::Kind::Undo:
+        if (!game.undoMove()) {
+            out = "ERR " + std::to_string(request.game) + " nothing to undo";
+        } else {
+            out += ' ';
+            out += statusName(game.getStatus());
+        }
+        break;
+    case ServerRequest::Kind::Status:
+        out += game.getCurrentPlayer() == Color::WHITE ? " white " : " black ";
+        out += std::to_string(game.getTurnCount());
+        out += ' ';
+        out += statusName(game.getStatus());
+        break;
+    case ServerRequest::Kind::End:
+        shard.games.erase(it);
+        gameCount.fetch_sub(1, std::memory_order_relaxed);
+        break;
+    case ServerRequest::Kind::New:
+        break;
+    }
+}
@@ -0,0 +1,463 @@
+#include "../include/GameState.hpp"
+#include "../include/ChessBoard.hpp"
+#include "../include/PortalSystem.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <iostream>
+
+namespace {
+    // Appends to a fixed buffer; once full, further output is dropped
+    struct FenWriter {
+        char* out;
+        std::size_t capacity;
+        std::size_t length = 0;
+        bool overflow = false;
+
+        void put(char c) {
+            if (length < capacity) {
+                out[length++] = c;
+            } else {
+                overflow = true;
+            }
+        }
+        void putNumber(unsigned value) {
+            char digits[10];
+            int count = 0;
+            do {
+                digits[count++] = static_cast<char>('0' + value % 10);
+                value /= 10;
+            } while (value > 0);
+            while (count > 0) {
+                put(digits[--count]);
+            }
+        }
+        void putSquare(const RuleSet& rules, int square) {
+            put(static_cast<char>('a' + rules.fileOf(square)));
+            putNumber(static_cast<unsigned>(rules.rankOf(square) + 1));
+        }
+    };
+
+    struct FenReader {
+        std::string_view text;
+        std::size_t pos = 0;
+
+        bool atEnd() const { return pos >= text.size(); }
+        bool atFieldEnd() const { return atEnd() || text[pos] == ' '; }
+        char peek() const { return atEnd() ? '\0' : text[pos]; }
+        bool isDigit() const { return std::isdigit(static_cast<unsigned char>(peek())) != 0; }
+        bool expect(char c) {
+            if (peek() != c) {
+                return false;
+            }
+            ++pos;
+            return true;
+        }
+
+        // Move to the next field; false if there is none
+        bool nextField() {
+            if (peek() != ' ') {
+                return false;
+            }
+            while (peek() == ' ') {
+                ++pos;
+            }
+            return !atEnd();
+        }
+        bool readNumber(unsigned& value) {
+            if (!isDigit()) {
+                return false;
+            }
+            value = 0;
+            while (isDigit() && value < 100000) {
+                value = value * 10 + static_cast<unsigned>(text[pos++] - '0');
+            }
+            return true;
+        }
+        bool readSquare(const RuleSet& rules, int& square) {
+            char file = peek();
+            if (file < 'a' || file >= 'a' + rules.boardSize) {
+                return false;
+            }
+            ++pos;
+            unsigned rank = 0;
+            if (!readNumber(rank) || rank < 1 || rank > static_cast<unsigned>(rules.boardSize)) {
+                return false;
+            }
+            square = rules.squareOf(file - 'a', static_cast<int>(rank) - 1);
+            return true;
+        }
+    };
+
+    bool startsUnmoved(const RuleSet& rules, const std::uint8_t* squares, int square) {
+        return squares[square] != kEmptySquare && squares[square] == rules.initialSquares[square];
+    }
+
+    // Kings and rooks: their unmoved state is what the castling field holds
+    bool hasCastlingRole(const RuleSet& rules, std::uint8_t code) {
+        return code != kEmptySquare && rules.kinds[pieceKind(code)].has(PieceRules::kCastling);
+    }
+
+    bool isCastlingPartner(const RuleSet& rules, std::uint8_t code, Color color) {
+        return hasCastlingRole(rules, code) && pieceColor(code) == color &&
+               !rules.kinds[pieceKind(code)].has(PieceRules::kRoyal);
+    }
+
+    // The castling royal piece of `color` on its starting square, or -1
+    int castlingKing(const RuleSet& rules, const std::uint8_t* squares, Color color) {
+        for (int square = 0; square < rules.squareCount; ++square) {
+            std::uint8_t code = squares[square];
+            if (hasCastlingRole(rules, code) && pieceColor(code) == color &&
+                rules.kinds[pieceKind(code)].has(PieceRules::kRoyal) && startsUnmoved(rules, squares, square)) {
+                return square;
+            }
+        }
+        return -1;
+    }
+
+    // The castling partner farthest from the king on one side of it, which
+    // 'K' (dx = 1) and 'Q' (dx = -1) name; -1 if there is none
+    int outermostPartner(const RuleSet& rules, const std::uint8_t* squares, int king, int dx) {
+        int kingFile = rules.fileOf(king);
+        int rank = rules.rankOf(king);
+        Color color = pieceColor(squares[king]);
+        for (int file = dx > 0 ? rules.boardSize - 1 : 0; file != kingFile; file -= dx) {
+            int square = rules.squareOf(file, rank);
+            if (isCastlingPartner(rules, squares[square], color)) {
+                return square;
+            }
+        }
+        return -1;
+    }
+}
+
+void GameState::reset(const RuleSet& rules) {
+    std::memcpy(squares, rules.initialSquares, sizeof(squares));
+    std::memset(unmoved, 0, sizeof(unmoved));
+    std::memset(cooldowns, 0, sizeof(cooldowns));
+    for (int square = 0; square < rules.squareCount; ++square) {
+        if (squares[square] != kEmptySquare) {
+            setUnmoved(square);
+        }
+    }
+    ply = 0;
+    sideToMove = Color::WHITE;
+    epSquare = kNoSquare;
+    hash = computeHash(rules);
+}
+
+bool GameState::loadFromBoard(const RuleSet& rules, const ChessBoard& board, Color toMove,
+                              const PortalSystem* portals) {
+    if (board.getSize() != rules.boardSize) {
+        return false;
+    }
+    std::memset(squares, kEmptySquare, sizeof(squares));
+    std::memset(unmoved, 0, sizeof(unmoved));
+    std::memset(cooldowns, 0, sizeof(cooldowns));
+
+    for (int square = 0; square < rules.squareCount; ++square) {
+        const ChessPiece* piece = board.getPieceAt(Position(rules.fileOf(square), rules.rankOf(square)));
+        if (piece == nullptr) {
+            continue;
+        }
+        int kind = rules.findKind(piece->getType());
+        if (kind < 0) {
+            return false;
+        }
+        squares[square] = makePieceCode(kind, piece->getColor());
+        if (!piece->hasMoved()) {
+            setUnmoved(square);
+        }
+    }
+
+    if (portals != nullptr) {
+        int count = std::min(portals->getPortalCount(), rules.portalCount);
+        for (int portal = 0; portal < count; ++portal) {
+            cooldowns[portal] = static_cast<std::uint8_t>(std::min(portals->getRemainingCooldown(portal),
+                                                                   static_cast<int>(rules.portals[portal].cooldown)));
+        }
+    }
+
+    ply = 0;
+    sideToMove = toMove;
+    epSquare = kNoSquare;
+    hash = computeHash(rules);
+    return true;
+}
+
+bool GameState::storeToBoard(const RuleSet& rules, ChessBoard& board, const PieceFactory& createPiece,
+                             PortalSystem* portals) const {
+    board.clear();
+    bool complete = true;
+    for (int square = 0; square < rules.squareCount; ++square) {
+        std::uint8_t code = squares[square];
+        if (code == kEmptySquare) {
+            continue;
+        }
+        PiecePtr piece = createPiece(rules.kinds[pieceKind(code)].name, pieceColor(code));
+        if (!piece) {
+            complete = false;
+            continue;
+        }
+        if (!isUnmoved(square)) {
+            piece->setMoved();
+        }
+        board.placePiece(std::move(piece), Position(rules.fileOf(square), rules.rankOf(square)));
+    }
+
+    if (portals != nullptr) {
+        portals->resetCooldowns();
+        int count = std::min(portals->getPortalCount(), rules.portalCount);
+        for (int portal = 0; portal < count; ++portal) {
+            portals->setRemainingCooldown(portal, cooldowns[portal]);
+        }
+    }
+    return complete;
+}
+
+std::size_t GameState::writeFen(const RuleSet& rules, char* out, std::size_t capacity) const {
+    FenWriter writer{out, capacity};
+    for (int rank = rules.boardSize - 1; rank >= 0; --rank) {
+        int empty = 0;
+        for (int file = 0; file < rules.boardSize; ++file) {
+            std::uint8_t code = squares[rules.squareOf(file, rank)];
+            if (code == kEmptySquare) {
+                ++empty;
+                continue;
+            }
+            if (empty > 0) {
+                writer.putNumber(static_cast<unsigned>(empty));
+                empty = 0;
+            }
+            char letter = rules.kinds[pieceKind(code)].letter;
+            if (letter == 0) {
+                return 0;
+            }
+            bool black = pieceColor(code) == Color::BLACK;
+            writer.put(black ? static_cast<char>(std::tolower(static_cast<unsigned char>(letter))) : letter);
+        }
+        if (empty > 0) {
+            writer.putNumber(static_cast<unsigned>(empty));
+        }
+        if (rank > 0) {
+            writer.put('/');
+        }
+    }
+
+    writer.put(' ');
+    writer.put(sideToMove == Color::WHITE ? 'w' : 'b');
+
+    writer.put(' ');
+    std::size_t before = writer.length;
+    for (Color color : {Color::WHITE, Color::BLACK}) {
+        int king = castlingKing(rules, squares, color);
+        if (king < 0 || !isUnmoved(king)) {
+            continue;
+        }
+        auto cased = [color](char letter) {
+            return color == Color::WHITE ? letter : static_cast<char>(std::tolower(static_cast<unsigned char>(letter)));
+        };
+        int outer[2] = {outermostPartner(rules, squares, king, 1), outermostPartner(rules, squares, king, -1)};
+        for (int side = 0; side < 2; ++side) {
+            if (outer[side] >= 0 && isUnmoved(outer[side])) {
+                writer.put(cased(side == 0 ? 'K' : 'Q'));
+            }
+        }
+        // Inner partners by file letter (X-FEN); 'K' would read as the
+        // outermost one
+        int rank = rules.rankOf(king);
+        for (int file = 0; file < rules.boardSize; ++file) {
+            int square = rules.squareOf(file, rank);
+            if (square != outer[0] && square != outer[1] && isCastlingPartner(rules, squares[square], color) &&
+                isUnmoved(square)) {
+                if ('A' + file == 'K') {
+                    return 0;
+                }
+                writer.put(cased(static_cast<char>('A' + file)));
+            }
+        }
+    }
+    if (writer.length == before && !writer.overflow) {
+        writer.put('-');
+    }
+
+    writer.put(' ');
+    if (epSquare == kNoSquare) {
+        writer.put('-');
+    } else {
+        writer.putSquare(rules, epSquare);
+    }
+
+    // Halfmove clock (not tracked) and fullmove number
+    writer.put(' ');
+    writer.put('0');
+    writer.put(' ');
+    writer.putNumber(static_cast<unsigned>(ply / 2 + 1));
+
+    bool cooling = std::any_of(cooldowns, cooldowns + rules.portalCount, [](std::uint8_t value) { return value > 0; });
+    for (int portal = 0; cooling && portal < rules.portalCount; ++portal) {
+        writer.put(portal > 0 ? ',' : ' ');
+        writer.putNumber(cooldowns[portal]);
+    }
+    return writer.overflow ? 0 : writer.length;
+}
+
+std::string GameState::toFen(const RuleSet& rules) const {
+    std::string text(kMaxFenLength, '\0');
+    text.resize(writeFen(rules, text.data(), text.size()));
+    return text;
+}
+
+bool GameState::readFen(const RuleSet& rules, std::string_view text) {
+    FenReader reader{text};
+    auto fail = [&text](const char* reason) {
+        std::cerr << "Bad FEN (" << reason << "): " << text << std::endl;
+        return false;
+    };
+
+    std::memset(squares, kEmptySquare, sizeof(squares));
+    std::memset(unmoved, 0, sizeof(unmoved));
+    std::memset(cooldowns, 0, sizeof(cooldowns));
+    for (int rank = rules.boardSize - 1; rank >= 0; --rank) {
+        int file = 0;
+        while (file < rules.boardSize) {
+            unsigned empty = 0;
+            if (reader.readNumber(empty)) {
+                if (empty == 0 || empty > static_cast<unsigned>(rules.boardSize - file)) {
+                    return fail("rank too long");
+                }
+                file += static_cast<int>(empty);
+                continue;
+            }
+            char letter = reader.peek();
+            char upper = static_cast<char>(std::toupper(static_cast<unsigned char>(letter)));
+            int kind = 0;
+            while (kind < rules.kindCount && rules.kinds[kind].letter != upper) {
+                ++kind;
+            }
+            if (upper < 'A' || upper > 'Z' || kind == rules.kindCount) {
+                return fail("unknown piece letter");
+            }
+            ++reader.pos;
+            Color color = letter == upper ? Color::WHITE : Color::BLACK;
+            squares[rules.squareOf(file++, rank)] = makePieceCode(kind, color);
+        }
+        if (rank > 0 && !reader.expect('/')) {
+            return fail("expected '/' after a rank");
+        }
+    }
+    for (int square = 0; square < rules.squareCount; ++square) {
+        if (startsUnmoved(rules, squares, square) && !hasCastlingRole(rules, squares[square])) {
+            setUnmoved(square);
+        }
+    }
+
+    if (!reader.nextField() || (reader.peek() != 'w' && reader.peek() != 'b')) {
+        return fail("side to move");
+    }
+    sideToMove = reader.peek() == 'w' ? Color::WHITE : Color::BLACK;
+    ++reader.pos;
+    if (!reader.atFieldEnd()) {
+        return fail("side to move");
+    }
+
+    if (!reader.nextField()) {
+        return fail("missing castling rights");
+    }
+    if (!reader.expect('-')) {
+        while (!reader.atFieldEnd()) {
+            char letter = reader.peek();
+            char upper = static_cast<char>(std::toupper(static_cast<unsigned char>(letter)));
+            Color color = letter == upper ? Color::WHITE : Color::BLACK;
+            int king = castlingKing(rules, squares, color);
+            int partner = -1;
+            if (king >= 0 && (upper == 'K' || upper == 'Q')) {
+                partner = outermostPartner(rules, squares, king, upper == 'K' ? 1 : -1);
+            } else if (king >= 0 && upper >= 'A' && upper < 'A' + rules.boardSize) {
+                partner = rules.squareOf(upper - 'A', rules.rankOf(king));
+            }
+            if (partner < 0 || !isCastlingPartner(rules, squares[partner], color)) {
+                return fail("castling rights");
+            }
+            if (isUnmoved(partner)) {
+                return fail("castling right listed twice");
+            }
+            setUnmoved(partner);
+            setUnmoved(king);
+            ++reader.pos;
+        }
+    }
+    if (!reader.atFieldEnd()) {
+        return fail("castling rights");
+    }
+
+    if (!reader.nextField()) {
+        return fail("missing en-passant square");
+    }
+    int ep = 0;
+    if (reader.expect('-')) {
+        epSquare = kNoSquare;
+    } else if (reader.readSquare(rules, ep)) {
+        epSquare = static_cast<std::uint8_t>(ep);
+    } else {
+        return fail("en-passant square");
+    }
+
+    // Halfmove clock (read and dropped) and fullmove number, both optional
+    ply = sideToMove == Color::BLACK ? 1 : 0;
+    if (reader.nextField()) {
+        unsigned clock = 0;
+        if (!reader.readNumber(clock) || !reader.atFieldEnd()) {
+            return fail("halfmove clock");
+        }
+        if (reader.nextField()) {
+            unsigned fullmove = 0;
+            if (!reader.readNumber(fullmove) || !reader.atFieldEnd() || fullmove == 0 || fullmove > UINT16_MAX / 2) {
+                return fail("fullmove number");
+            }
+            ply = static_cast<std::uint16_t>((fullmove - 1) * 2 + ply);
+        }
+    }
+
+    // Portal cooldowns, optional as well
+    if (reader.nextField() && !reader.expect('-')) {
+        for (int portal = 0; portal < rules.portalCount; ++portal) {
+            unsigned value = 0;
+            if ((portal > 0 && !reader.expect(',')) || !reader.readNumber(value) ||
+                value > rules.portals[portal].cooldown) {
+                return fail("portal cooldowns");
+            }
+            cooldowns[portal] = static_cast<std::uint8_t>(value);
+        }
+    }
+    while (reader.peek() == ' ') {
+        ++reader.pos;
+    }
+    if (!reader.atEnd()) {
+        return fail("unexpected text at the end");
+    }
+    hash = computeHash(rules);
+    return true;
+}
+
+std::uint64_t GameState::computeHash(const RuleSet& rules) const {
+    std::uint64_t result = 0;
+    for (int square = 0; square < rules.squareCount; ++square) {
+        if (squares[square] != kEmptySquare) {
+            result ^= rules.pieceKeys[square][squares[square]];
+            if (isUnmoved(square)) {
+                result ^= rules.unmovedKeys[square];
+            }
+        }
+    }
+    for (int portal = 0; portal < rules.portalCount; ++portal) {
+        result ^= rules.cooldownKeys[portal][cooldowns[portal]];
+    }
+    if (sideToMove == Color::BLACK) {
+        result ^= rules.sideKey;
+    }
+    if (epSquare != kNoSquare) {
+        result ^= rules.epKeys[epSquare];
+    }
+    return result;
+}
@@ -0,0 +1,232 @@
+#include "../include/Mcts.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <thread>
+
+Mcts::Mcts(const RuleSet& rules, unsigned threads, std::size_t nodeCapacity)
+    : rules(rules), generator(rules), nodes(std::make_unique<Node[]>(std::max<std::size_t>(nodeCapacity, 1))),
+      capacity(std::max<std::size_t>(nodeCapacity, 1)) {
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    for (unsigned i = 0; i < threads; ++i) {
+        workers.push_back(std::make_unique<Worker>(rules));
+    }
+    if (threads > 1) {
+        pool = std::make_unique<ThreadPool>(threads);
+    }
+    seed(0x9E3779B97F4A7C15ULL);
+}
+
+void Mcts::seed(std::uint64_t value) {
+    for (std::size_t i = 0; i < workers.size(); ++i) {
+        workers[i]->rng.seed(value + i);
+    }
+}
+
+MctsResult Mcts::think(const GameState& state, const MctsLimits& limits) {
+    Node& root = nodes[0];
+    root.visits.store(0, std::memory_order_relaxed);
+    root.virtualLoss.store(0, std::memory_order_relaxed);
+    root.score.store(0, std::memory_order_relaxed);
+    root.expansion.store(kUnexpanded, std::memory_order_relaxed);
+    nodeCount.store(1, std::memory_order_relaxed);
+    playoutsStarted.store(0, std::memory_order_relaxed);
+    for (auto& worker : workers) {
+        worker->state = state;
+        worker->attacks.build(state);
+    }
+
+    if (pool) {
+        pool->parallelFor(workers.size(), [&](unsigned worker, std::size_t) { playouts(*workers[worker], limits); });
+    } else {
+        playouts(*workers[0], limits);
+    }
+
+    MctsResult result;
+    result.playouts = std::min(playoutsStarted.load(), limits.playouts);
+    result.nodes = std::min(nodeCount.load(), capacity);
+    if (root.expansion.load(std::memory_order_acquire) == kExpanded) {
+        // The most visited move is the most reliable one
+        for (std::uint32_t i = 0; i < root.childCount; ++i) {
+            const Node& child = nodes[root.firstChild + i];
+            std::uint32_t visits = child.visits.load(std::memory_order_relaxed);
+            if (i == 0 || visits > result.visits) {
+                result.move = EngineMove::unpack(child.move);
+                result.visits = visits;
+                result.winRate = visits > 0 ? child.score.load(std::memory_order_relaxed) / (2.0 * visits) : 0;
+            }
+        }
+    } else {
+        // No playout ran (or the arena cannot hold the root's children)
+        Worker& worker = *workers[0];
+        generator.generateLegal(worker.state, worker.attacks, worker.moves);
+        if (worker.moves.count > 0) {
+            result.move = worker.moves.moves[0];
+        }
+    }
+    return result;
+}
+
+void Mcts::playouts(Worker& worker, const MctsLimits& limits) {
+    while (playoutsStarted.fetch_add(1, std::memory_order_relaxed) < limits.playouts) {
+        playout(worker, limits);
+    }
+}
+
+void Mcts::playout(Worker& worker, const MctsLimits& limits) {
+    // Selection and expansion
+    int depth = 0;
+    std::uint32_t index = 0;
+    for (;;) {
+        Node& node = nodes[index];
+        std::uint8_t expansion = node.expansion.load(std::memory_order_acquire);
+        if (expansion == kUnexpanded && (index == 0 || node.visits.load(std::memory_order_relaxed) > 0)) {
+            expansion = expand(worker, index);
+        }
+        if (expansion != kExpanded || node.childCount == 0 || depth >= kMaxPath / 2 ||
+            (rules.turnLimit > 0 && worker.state.ply >= rules.turnLimit)) {
+            break;
+        }
+        index = select(node, limits.exploration);
+        Node& child = nodes[index];
+        child.virtualLoss.fetch_add(1, std::memory_order_relaxed);
+        PathEntry& entry = worker.path[depth++];
+        entry.node = index;
+        entry.move = EngineMove::unpack(child.move);
+        play(worker, entry);
+    }
+
+    int result = rollout(worker, depth, limits);
+
+    // Backup, each node scored for the side that moved into it
+    for (int i = depth - 1; i >= 0; --i) {
+        const PathEntry& entry = worker.path[i];
+        Node& node = nodes[entry.node];
+        node.score.fetch_add(entry.mover == Color::WHITE ? result : 2 - result, std::memory_order_relaxed);
+        node.visits.fetch_add(1, std::memory_order_relaxed);
+        node.virtualLoss.fetch_sub(1, std::memory_order_relaxed);
+    }
+    nodes[0].visits.fetch_add(1, std::memory_order_relaxed);
+    unplay(worker, 0, depth);
+}
+
+std::uint8_t Mcts::expand(Worker& worker, std::uint32_t index) {
+    Node& node = nodes[index];
+    std::uint8_t expected = kUnexpanded;
+    if (!node.expansion.compare_exchange_strong(expected, kExpanding, std::memory_order_acq_rel)) {
+        return expected;
+    }
+
+    MoveList& moves = worker.moves;
+    generator.generateLegal(worker.state, worker.attacks, moves);
+    std::size_t first = nodeCount.fetch_add(static_cast<std::size_t>(moves.count), std::memory_order_relaxed);
+    if (first + moves.count > capacity) {
+        node.expansion.store(kLeaf, std::memory_order_release);
+        return kLeaf;
+    }
+    for (int i = 0; i < moves.count; ++i) {
+        Node& child = nodes[first + i];
+        child.visits.store(0, std::memory_order_relaxed);
+        child.virtualLoss.store(0, std::memory_order_relaxed);
+        child.score.store(0, std::memory_order_relaxed);
+        child.childCount = 0;
+        child.expansion.store(kUnexpanded, std::memory_order_relaxed);
+        child.move = moves.moves[i].pack();
+    }
+    node.firstChild = static_cast<std::uint32_t>(first);
+    node.childCount = static_cast<std::uint16_t>(moves.count);
+    node.expansion.store(kExpanded, std::memory_order_release);
+    return kExpanded;
+}
+
+// UCT; virtual losses count as visits that scored nothing. Unvisited
+// children are tried first.
+std::uint32_t Mcts::select(const Node& parent, double exploration) const {
+    double logVisits = std::log(std::max(1u, parent.visits.load(std::memory_order_relaxed) +
+                                                 parent.virtualLoss.load(std::memory_order_relaxed)));
+    std::uint32_t best = parent.firstChild;
+    double bestValue = -std::numeric_limits<double>::infinity();
+    for (std::uint32_t i = parent.firstChild; i < parent.firstChild + parent.childCount; ++i) {
+        const Node& child = nodes[i];
+        std::uint32_t visits = child.visits.load(std::memory_order_relaxed) +
+                               child.virtualLoss.load(std::memory_order_relaxed);
+        if (visits == 0) {
+            return i;
+        }
+        double value = child.score.load(std::memory_order_relaxed) / (2.0 * visits) +
+                       exploration * std::sqrt(logVisits / visits);
+        if (value > bestValue) {
+            bestValue = value;
+            best = i;
+        }
+    }
+    return best;
+}
+
+int Mcts::rollout(Worker& worker, int depth, const MctsLimits& limits) {
+    int start = depth;
+    int result = 1;
+    for (;;) {
+        if (depth - start >= limits.rolloutPlies || depth >= kMaxPath ||
+            (rules.turnLimit > 0 && worker.state.ply >= rules.turnLimit)) {
+            break;
+        }
+        if (!playRandomMove(worker, depth)) {
+            result = scoreTerminal(worker);
+            break;
+        }
+        ++depth;
+    }
+    unplay(worker, start, depth);
+    return result;
+}
+
+// Uniform over the legal moves: pseudo-legal moves are drawn at random and
+// dropped until one turns out legal
+bool Mcts::playRandomMove(Worker& worker, int depth) {
+    MoveList& moves = worker.moves;
+    generator.generate(worker.state, moves);
+    PathEntry& entry = worker.path[depth];
+    while (moves.count > 0) {
+        int pick = static_cast<int>(worker.rng() % static_cast<std::uint64_t>(moves.count));
+        entry.move = moves.moves[pick];
+        moves.moves[pick] = moves.moves[--moves.count];
+        if (entry.move.special() == EngineMove::kCastle && !generator.isLegal(worker.state, worker.attacks, entry.move)) {
+            continue;
+        }
+        play(worker, entry);
+        if (!worker.attacks.isInCheck(entry.mover)) {
+            return true;
+        }
+        unplay(worker, depth, depth + 1);
+    }
+    return false;
+}
+
+void Mcts::play(Worker& worker, PathEntry& entry) {
+    entry.mover = worker.state.sideToMove;
+    int changed[4];
+    int changedCount = generator.getChangedSquares(entry.move, changed);
+    generator.makeMove(worker.state, entry.move, entry.undo);
+    worker.attacks.update(worker.state, changed, changedCount);
+}
+
+void Mcts::unplay(Worker& worker, int from, int to) {
+    for (int i = to - 1; i >= from; --i) {
+        const PathEntry& entry = worker.path[i];
+        int changed[4];
+        int changedCount = generator.getChangedSquares(entry.move, changed);
+        generator.unmakeMove(worker.state, entry.move, entry.undo);
+        worker.attacks.update(worker.state, changed, changedCount);
+    }
+}
+
+// Half points for white in a position without legal moves
+int Mcts::scoreTerminal(const Worker& worker) const {
+    if (!worker.attacks.isInCheck(worker.state.sideToMove)) {
+        return 1;
+    }
+    return worker.state.sideToMove == Color::WHITE ? 0 : 2;
+}
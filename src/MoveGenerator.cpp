@@ -0,0 +1,482 @@
+#include "../include/MoveGenerator.hpp"
+#include <cstdlib>
+#include <cstring>
+
+void MoveGenerator::generate(const GameState& state, MoveList& moves) const {
+    moves.count = 0;
+    for (int square = 0; square < rules.squareCount; ++square) {
+        std::uint8_t code = state.squares[square];
+        if (code != kEmptySquare && pieceColor(code) == state.sideToMove) {
+            generatePieceMoves(state, square, moves);
+        }
+    }
+}
+
+void MoveGenerator::generatePieceMoves(const GameState& state, int from, MoveList& moves) const {
+    std::uint8_t code = state.squares[from];
+    const PieceRules& kind = rules.kinds[pieceKind(code)];
+    Color color = pieceColor(code);
+    int forward = (color == Color::WHITE) ? 1 : -1;
+    bool unmoved = state.isUnmoved(from);
+    int size = rules.boardSize;
+    int fromX = rules.fileOf(from);
+    int fromY = rules.rankOf(from);
+
+    bool enPassant = kind.has(PieceRules::kEnPassant);
+
+    for (int r = 0; r < kind.rayCount; ++r) {
+        const MoveRay& ray = kind.rays[r];
+        int range = unmoved ? ray.firstRange : ray.range;
+        int dx = ray.dx;
+        int dy = ray.dy * forward;
+        int x = fromX;
+        int y = fromY;
+
+        for (int step = 1; step <= range; ++step) {
+            x += dx;
+            y += dy;
+            if (x < 0 || x >= size || y < 0 || y >= size) {
+                break;
+            }
+
+            int to = rules.squareOf(x, y);
+            std::uint8_t target = state.squares[to];
+            if (target == kEmptySquare) {
+                if (ray.flags & MoveRay::kMove) {
+                    bool doubleStep = enPassant && step >= 2 && ray.dx == 0 && ray.dy > 0;
+                    addMove(kind, color, from, to, kNoPortal, doubleStep ? EngineMove::kDoubleStep : 0, moves);
+                    if (rules.portalAt[to] != kNoPortal) {
+                        generatePortalMoves(state, from, kind, color, ray, to, range - step, moves);
+                    }
+                } else if (to == state.epSquare && enPassant && step == 1 && dy == forward &&
+                           (ray.flags & MoveRay::kCapture)) {
+                    addMove(kind, color, from, to, kNoPortal, EngineMove::kEnPassant, moves);
+                }
+                continue;
+            }
+
+            if (pieceColor(target) != color && (ray.flags & MoveRay::kCapture)) {
+                addMove(kind, color, from, to, kNoPortal, 0, moves);
+            }
+            if (!(ray.flags & MoveRay::kJump)) {
+                break;
+            }
+        }
+    }
+
+    if (unmoved && kind.has(PieceRules::kRoyal) && kind.has(PieceRules::kCastling)) {
+        generateCastling(state, from, color, moves);
+    }
+}
+
+void MoveGenerator::addMove(const PieceRules& kind, Color color, int from, int to, std::uint8_t portal,
+                            std::uint8_t flags, MoveList& moves) const {
+    if (kind.has(PieceRules::kPromotion) && rules.promotionCount > 0 &&
+        rules.rankOf(to) == rules.promotionRank(color)) {
+        for (int i = 0; i < rules.promotionCount; ++i) {
+            moves.add(from, to, portal, flags | EngineMove::promotionFlags(rules.promotionKinds[i]));
+        }
+        return;
+    }
+    moves.add(from, to, portal, flags);
+}
+
+void MoveGenerator::generateCastling(const GameState& state, int from, Color color, MoveList& moves) const {
+    int fromX = rules.fileOf(from);
+    int rank = rules.rankOf(from);
+    for (int dx : {1, -1}) {
+        // The partner is the first piece along the rank
+        int x = fromX + dx;
+        while (x >= 0 && x < rules.boardSize && state.squares[rules.squareOf(x, rank)] == kEmptySquare) {
+            x += dx;
+        }
+        if (x < 0 || x >= rules.boardSize || std::abs(x - fromX) < 3) {
+            continue;
+        }
+
+        int partner = rules.squareOf(x, rank);
+        std::uint8_t code = state.squares[partner];
+        const PieceRules& kind = rules.kinds[pieceKind(code)];
+        if (pieceColor(code) == color && state.isUnmoved(partner) && kind.has(PieceRules::kCastling) &&
+            !kind.has(PieceRules::kRoyal)) {
+            moves.add(from, partner, kNoPortal, EngineMove::kCastle);
+        }
+    }
+}
+
+void MoveGenerator::generatePortalMoves(const GameState& state, int from, const PieceRules& kind, Color color,
+                                        const MoveRay& ray, int entry, int remaining, MoveList& moves) const {
+    std::uint8_t portalIndex = rules.portalAt[entry];
+    const PortalRules& portal = rules.portals[portalIndex];
+
+    if (!kind.has(PieceRules::kPortalMaster) &&
+        (state.cooldowns[portalIndex] > 0 || !portal.allows(color))) {
+        return;
+    }
+
+    // The moving piece has left its square, so it never blocks itself (but
+    // travelling back to where it started is not a move)
+    auto occupant = [&](int square) -> std::uint8_t {
+        return square == from ? kEmptySquare : state.squares[square];
+    };
+    auto add = [&](int to) {
+        if (to != from) {
+            addMove(kind, color, from, to, portalIndex, 0, moves);
+        }
+    };
+
+    int exit = portal.exit;
+    std::uint8_t target = occupant(exit);
+    if (target != kEmptySquare) {
+        if (pieceColor(target) != color && (ray.flags & MoveRay::kCapture)) {
+            add(exit);
+        }
+        return;
+    }
+    add(exit);
+
+    // Keep travelling in the same direction from the exit
+    int direction = ray.direction[colorIndex(color)];
+    if (!portal.preserveDirection || direction < 0) {
+        return;
+    }
+    int length = portal.exitRayLength[direction];
+    for (int step = 0; step < remaining && step < length; ++step) {
+        int to = portal.exitRay[direction][step];
+        target = occupant(to);
+        if (target == kEmptySquare) {
+            add(to);
+            continue;
+        }
+        if (pieceColor(target) != color && (ray.flags & MoveRay::kCapture)) {
+            add(to);
+        }
+        if (!(ray.flags & MoveRay::kJump)) {
+            break;
+        }
+    }
+}
+
+void MoveGenerator::setCooldown(GameState& state, int portal, int value) const {
+    state.hash ^= rules.cooldownKeys[portal][state.cooldowns[portal]] ^ rules.cooldownKeys[portal][value];
+    state.cooldowns[portal] = static_cast<std::uint8_t>(value);
+}
+
+void MoveGenerator::placePiece(GameState& state, int square, std::uint8_t code) const {
+    state.squares[square] = code;
+    state.hash ^= rules.pieceKeys[square][code];
+}
+
+std::uint8_t MoveGenerator::removePiece(GameState& state, int square) const {
+    std::uint8_t code = state.squares[square];
+    state.hash ^= rules.pieceKeys[square][code];
+    if (state.isUnmoved(square)) {
+        state.hash ^= rules.unmovedKeys[square];
+        state.clearUnmoved(square);
+    }
+    state.squares[square] = kEmptySquare;
+    return code;
+}
+
+int MoveGenerator::getCapturedSquare(const EngineMove& move) const {
+    // The en-passant victim stands beside the capturing piece, one rank
+    // behind the square it captures onto
+    if (move.special() == EngineMove::kEnPassant) {
+        return move.to > move.from ? move.to - rules.boardSize : move.to + rules.boardSize;
+    }
+    return move.to;
+}
+
+int MoveGenerator::getChangedSquares(const EngineMove& move, int (&squares)[4]) const {
+    squares[0] = move.from;
+    squares[1] = move.to;
+    switch (move.special()) {
+    case EngineMove::kCastle: {
+        int direction = move.to > move.from ? 1 : -1;
+        squares[2] = move.from + 2 * direction;
+        squares[3] = move.from + direction;
+        return 4;
+    }
+    case EngineMove::kEnPassant:
+        squares[2] = getCapturedSquare(move);
+        return 3;
+    default:
+        return 2;
+    }
+}
+
+Move MoveGenerator::toMove(const EngineMove& move) const {
+    int to = move.to;
+    if (move.special() == EngineMove::kCastle) {
+        to = move.to > move.from ? move.from + 2 : move.from - 2;
+    }
+    Move result(Position(rules.fileOf(move.from), rules.rankOf(move.from)),
+                Position(rules.fileOf(to), rules.rankOf(to)));
+    if (move.portal != kNoPortal) {
+        result.usedPortal = true;
+        result.portalId = rules.portals[move.portal].id;
+    }
+    return result;
+}
+
+MoveRecord MoveGenerator::toMoveRecord(const GameState& before, const EngineMove& move) const {
+    if (move.special() != EngineMove::kCastle) {
+        std::uint8_t captured = before.squares[getCapturedSquare(move)];
+        if (captured != kEmptySquare) {
+            return MoveRecord(toMove(move), rules.kinds[pieceKind(captured)].name, pieceColor(captured));
+        }
+    }
+    return MoveRecord(toMove(move));
+}
+
+bool MoveGenerator::fromMove(const GameState& state, const Move& move, EngineMove& result, int promotionKind) const {
+    if (move.from.x < 0 || move.from.x >= rules.boardSize || move.from.y < 0 || move.from.y >= rules.boardSize) {
+        return false;
+    }
+    if (promotionKind < 0 && rules.promotionCount > 0) {
+        promotionKind = rules.promotionKinds[0];
+    }
+
+    MoveList moves;
+    moves.count = 0;
+    int from = rules.squareOf(move.from.x, move.from.y);
+    if (state.squares[from] == kEmptySquare || pieceColor(state.squares[from]) != state.sideToMove) {
+        return false;
+    }
+    generatePieceMoves(state, from, moves);
+    bool found = false;
+    for (const EngineMove& candidate : moves) {
+        int to = candidate.to;
+        if (candidate.special() == EngineMove::kCastle) {
+            to = candidate.to > candidate.from ? candidate.from + 2 : candidate.from - 2;
+        }
+        if (rules.fileOf(to) != move.to.x || rules.rankOf(to) != move.to.y ||
+            (candidate.isPromotion() && candidate.promotionKind() != promotionKind)) {
+            continue;
+        }
+        if (candidate.portal == kNoPortal ? !move.usedPortal
+                                          : move.usedPortal && move.portalId == rules.portals[candidate.portal].id) {
+            result = candidate;
+            return true;
+        }
+        // A Move without a portal may still only be possible through one
+        if (!move.usedPortal && !found) {
+            result = candidate;
+            found = true;
+        }
+    }
+    return found;
+}
+
+void MoveGenerator::makeMove(GameState& state, const EngineMove& move, UndoInfo& undo) const {
+    undo.hash = state.hash;
+    undo.piece = state.squares[move.from];
+    undo.epSquare = state.epSquare;
+    undo.fromUnmoved = state.isUnmoved(move.from);
+    if (move.special() == EngineMove::kCastle) {
+        undo.captured = kEmptySquare;
+        undo.capturedUnmoved = false;
+    } else {
+        int capturedSquare = getCapturedSquare(move);
+        undo.captured = state.squares[capturedSquare];
+        undo.capturedUnmoved = undo.captured != kEmptySquare && state.isUnmoved(capturedSquare);
+    }
+    std::memcpy(undo.cooldowns, state.cooldowns, rules.portalCount);
+    makeMove(state, move);
+}
+
+void MoveGenerator::makeMove(GameState& state, const EngineMove& move) const {
+    // The turn passes for every portal and the en-passant chance expires...
+    for (int portal = 0; portal < rules.portalCount; ++portal) {
+        if (state.cooldowns[portal] > 0) {
+            setCooldown(state, portal, state.cooldowns[portal] - 1);
+        }
+    }
+    if (state.epSquare != kNoSquare) {
+        state.hash ^= rules.epKeys[state.epSquare];
+        state.epSquare = kNoSquare;
+    }
+
+    // ...then the piece moves
+    std::uint8_t code = removePiece(state, move.from);
+    if (move.special() == EngineMove::kCastle) {
+        int direction = move.to > move.from ? 1 : -1;
+        std::uint8_t partner = removePiece(state, move.to);
+        placePiece(state, move.from + 2 * direction, code);
+        placePiece(state, move.from + direction, partner);
+    } else {
+        int capturedSquare = getCapturedSquare(move);
+        if (state.squares[capturedSquare] != kEmptySquare) {
+            removePiece(state, capturedSquare);
+        }
+        if (move.isPromotion()) {
+            code = makePieceCode(move.promotionKind(), pieceColor(code));
+        }
+        placePiece(state, move.to, code);
+        if (move.special() == EngineMove::kDoubleStep) {
+            state.epSquare = static_cast<std::uint8_t>(move.to > move.from ? move.to - rules.boardSize
+                                                                            : move.to + rules.boardSize);
+            state.hash ^= rules.epKeys[state.epSquare];
+        }
+    }
+
+    // ...and a portal it travelled through starts cooling down
+    if (move.portal != kNoPortal) {
+        setCooldown(state, move.portal, rules.portals[move.portal].cooldown);
+    }
+
+    state.sideToMove = (state.sideToMove == Color::WHITE) ? Color::BLACK : Color::WHITE;
+    state.hash ^= rules.sideKey;
+    state.ply++;
+}
+
+void MoveGenerator::unmakeMove(GameState& state, const EngineMove& move, const UndoInfo& undo) const {
+    if (move.special() == EngineMove::kCastle) {
+        int direction = move.to > move.from ? 1 : -1;
+        std::uint8_t partner = state.squares[move.from + direction];
+        state.squares[move.from + 2 * direction] = kEmptySquare;
+        state.squares[move.from + direction] = kEmptySquare;
+        state.squares[move.to] = partner;
+        state.setUnmoved(move.to);
+    } else {
+        int capturedSquare = getCapturedSquare(move);
+        state.squares[move.to] = kEmptySquare;
+        state.squares[capturedSquare] = undo.captured;
+        if (undo.capturedUnmoved) {
+            state.setUnmoved(capturedSquare);
+        }
+    }
+    state.squares[move.from] = undo.piece;
+    if (undo.fromUnmoved) {
+        state.setUnmoved(move.from);
+    }
+    std::memcpy(state.cooldowns, undo.cooldowns, rules.portalCount);
+
+    state.sideToMove = (state.sideToMove == Color::WHITE) ? Color::BLACK : Color::WHITE;
+    state.epSquare = undo.epSquare;
+    state.hash = undo.hash;
+    state.ply--;
+}
+
+std::uint64_t MoveGenerator::perft(GameState& state, int depth) const {
+    if (depth == 0) {
+        return 1;
+    }
+
+    MoveList moves;
+    generate(state, moves);
+    if (depth == 1) {
+        return static_cast<std::uint64_t>(moves.count);
+    }
+
+    std::uint64_t nodes = 0;
+    UndoInfo undo;
+    for (const EngineMove& move : moves) {
+        makeMove(state, move, undo);
+        nodes += perft(state, depth - 1);
+        unmakeMove(state, move, undo);
+    }
+    return nodes;
+}
+
+std::uint64_t MoveGenerator::perftCopy(const GameState& state, int depth) const {
+    if (depth == 0) {
+        return 1;
+    }
+
+    MoveList moves;
+    generate(state, moves);
+    if (depth == 1) {
+        return static_cast<std::uint64_t>(moves.count);
+    }
+
+    std::uint64_t nodes = 0;
+    GameState child;
+    for (const EngineMove& move : moves) {
+        child = state;
+        makeMove(child, move);
+        nodes += perftCopy(child, depth - 1);
+    }
+    return nodes;
+}
+
+bool MoveGenerator::isLegal(GameState& state, AttackMap& attacks, const EngineMove& move) const {
+    Color mover = state.sideToMove;
+    if (attacks.getRoyalSquares(mover).empty()) {
+        return true;
+    }
+
+    // Castling may not start in check or cross an attacked square
+    if (move.special() == EngineMove::kCastle) {
+        Color enemy = (mover == Color::WHITE) ? Color::BLACK : Color::WHITE;
+        int crossed = move.to > move.from ? move.from + 1 : move.from - 1;
+        if (attacks.isAttacked(move.from, enemy) || attacks.isAttacked(crossed, enemy)) {
+            return false;
+        }
+    }
+
+    int changed[4];
+    int changedCount = getChangedSquares(move, changed);
+    UndoInfo undo;
+    makeMove(state, move, undo);
+    attacks.update(state, changed, changedCount);
+    bool legal = !attacks.isInCheck(mover);
+    unmakeMove(state, move, undo);
+    attacks.update(state, changed, changedCount);
+    return legal;
+}
+
+void MoveGenerator::generateLegal(GameState& state, AttackMap& attacks, MoveList& moves) const {
+    generate(state, moves);
+    int kept = 0;
+    for (int i = 0; i < moves.count; ++i) {
+        if (isLegal(state, attacks, moves.moves[i])) {
+            moves.moves[kept++] = moves.moves[i];
+        }
+    }
+    moves.count = kept;
+}
+
+bool MoveGenerator::hasLegalMove(GameState& state, AttackMap& attacks) const {
+    MoveList moves;
+    generate(state, moves);
+    for (const EngineMove& move : moves) {
+        if (isLegal(state, attacks, move)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool MoveGenerator::isCheckmate(GameState& state, AttackMap& attacks) const {
+    return attacks.isInCheck(state.sideToMove) && !hasLegalMove(state, attacks);
+}
+
+bool MoveGenerator::isStalemate(GameState& state, AttackMap& attacks) const {
+    return !attacks.isInCheck(state.sideToMove) && !hasLegalMove(state, attacks);
+}
+
+std::uint64_t MoveGenerator::perftLegal(GameState& state, AttackMap& attacks, int depth) const {
+    if (depth == 0) {
+        return 1;
+    }
+
+    MoveList moves;
+    generateLegal(state, attacks, moves);
+    if (depth == 1) {
+        return static_cast<std::uint64_t>(moves.count);
+    }
+
+    std::uint64_t nodes = 0;
+    UndoInfo undo;
+    int changed[4];
+    for (const EngineMove& move : moves) {
+        int changedCount = getChangedSquares(move, changed);
+        makeMove(state, move, undo);
+        attacks.update(state, changed, changedCount);
+        nodes += perftLegal(state, attacks, depth - 1);
+        unmakeMove(state, move, undo);
+        attacks.update(state, changed, changedCount);
+    }
+    return nodes;
+}
@@ -0,0 +1,245 @@
+#include "../include/MoveValidator.hpp"
+#include <algorithm>
+#include <iostream>
+
+namespace {
+    // Queen directions followed by the L-shaped jumps
+    constexpr int kRayDirections[8][2] = {
+        {0, 1}, {0, -1}, {1, 0}, {-1, 0}, {1, 1}, {1, -1}, {-1, 1}, {-1, -1}
+    };
+    constexpr int kJumps[8][2] = {
+        {1, 2}, {2, 1}, {2, -1}, {1, -2}, {-1, -2}, {-2, -1}, {-2, 1}, {-1, 2}
+    };
+}
+
+// MoveGraph implementation
+void MoveGraph::allocate(const std::vector<int>& capacities) {
+    offsets.assign(capacities.size() + 1, 0);
+    for (std::size_t i = 0; i < capacities.size(); ++i) {
+        offsets[i + 1] = offsets[i] + capacities[i];
+    }
+    degree.assign(capacities.size(), 0);
+    edges.assign(offsets.back(), 0);
+}
+
+void MoveGraph::addEdge(int from, int to, bool isPortal) {
+    // Slot ranges are sized for the worst case, so this never overflows
+    edges[offsets[from] + degree[from]] = static_cast<std::uint16_t>(to) | (isPortal ? kPortalBit : 0);
+    degree[from]++;
+}
+
+bool MoveGraph::isPortalEdge(int from, int to) const {
+    for (std::uint16_t edge : getNeighbors(from)) {
+        if ((edge & kPortalBit) && (edge & kSquareMask) == to) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void MoveGraph::clear() {
+    std::fill(degree.begin(), degree.end(), 0);
+}
+
+// MoveValidator implementation
+MoveValidator::MoveValidator(const ChessBoard& board, const PortalSystem& portalSystem)
+    : board(board), portalSystem(portalSystem), size(board.getSize()) {
+    static_assert(kMaxGraphBoardSize * kMaxGraphBoardSize - 1 <= MoveGraph::kSquareMask);
+    if (size > kMaxGraphBoardSize) {
+        std::cerr << "Board size " << size << " is too large for the move validator's graph (maximum "
+                  << kMaxGraphBoardSize << ")" << std::endl;
+        return;
+    }
+    ready = true;
+    buildGeometry();
+    buildGraph();
+}
+
+bool MoveValidator::isValidMove(const Position& from, const Position& to) const {
+    return !findPath(from, to).empty();
+}
+
+std::vector<Position> MoveValidator::findPath(const Position& from, const Position& to) const {
+    if (!ready || !board.isWithinBounds(from) || !board.isWithinBounds(to) || from == to) {
+        return {};
+    }
+    return bfs(from, to);
+}
+
+bool MoveValidator::canUsePortal(const Position& pos, const ChessPiece* piece) const {
+    return portalSystem.canUsePortal(portalSystem.getPortalByEntry(pos), piece);
+}
+
+void MoveValidator::rebuildGraph() {
+    if (ready) {
+        buildGraph();
+    }
+}
+
+void MoveValidator::onPieceMoved(const Position& from, const Position& to) {
+    if (!ready) {
+        return;
+    }
+    // Only the two squares themselves and the squares that can see them
+    // (along a ray or by a jump) can gain or lose edges
+    std::uint32_t stamp = nextStamp();
+    for (int square : {toSquare(from), toSquare(to)}) {
+        if (visitStamp[square] != stamp) {
+            visitStamp[square] = stamp;
+            updateSquare(square);
+        }
+        for (std::uint32_t i = candidateOffsets[square]; i < candidateOffsets[square + 1]; ++i) {
+            int watcher = candidates[i];
+            if (visitStamp[watcher] != stamp) {
+                visitStamp[watcher] = stamp;
+                updateSquare(watcher);
+            }
+        }
+    }
+}
+
+void MoveValidator::onPortalCooldownChanged(const std::string& portalId) {
+    const Portal* portal = portalSystem.getPortalById(portalId);
+    if (ready && portal) {
+        updateSquare(toSquare(portal->getEntry()));
+    }
+}
+
+void MoveValidator::buildGeometry() {
+    int squareCount = size * size;
+    candidateOffsets.assign(squareCount + 1, 0);
+    candidates.clear();
+
+    std::vector<int> capacities(squareCount, 0);
+    for (int square = 0; square < squareCount; ++square) {
+        Position from = toPosition(square);
+
+        for (const auto& dir : kRayDirections) {
+            Position current(from.x + dir[0], from.y + dir[1]);
+            while (board.isWithinBounds(current)) {
+                candidates.push_back(static_cast<std::uint16_t>(toSquare(current)));
+                current.x += dir[0];
+                current.y += dir[1];
+            }
+        }
+        for (const auto& jump : kJumps) {
+            Position target(from.x + jump[0], from.y + jump[1]);
+            if (board.isWithinBounds(target)) {
+                candidates.push_back(static_cast<std::uint16_t>(toSquare(target)));
+            }
+        }
+
+        candidateOffsets[square + 1] = static_cast<std::uint32_t>(candidates.size());
+        capacities[square] = static_cast<int>(candidateOffsets[square + 1] - candidateOffsets[square]);
+
+        // One extra slot for the portal leaving this square, if any
+        if (portalSystem.isEntryPoint(from)) {
+            capacities[square]++;
+        }
+    }
+
+    graph.allocate(capacities);
+    visitStamp.assign(squareCount, 0);
+    parent.assign(squareCount, -1);
+    searchQueue.reserve(squareCount);
+}
+
+void MoveValidator::buildGraph() {
+    graph.clear();
+    for (int square = 0; square < size * size; ++square) {
+        updateSquare(square);
+    }
+}
+
+void MoveValidator::updateSquare(int square) {
+    graph.clearNode(square);
+    addStandardMoveEdges(square);
+    addPortalEdges(square);
+}
+
+void MoveValidator::addStandardMoveEdges(int square) {
+    Position from = toPosition(square);
+    if (board.isPositionEmpty(from)) {
+        return;
+    }
+
+    for (std::uint32_t i = candidateOffsets[square]; i < candidateOffsets[square + 1]; ++i) {
+        if (board.isMoveValid(from, toPosition(candidates[i]))) {
+            graph.addEdge(square, candidates[i]);
+        }
+    }
+}
+
+void MoveValidator::addPortalEdges(int square) {
+    int index = portalSystem.getPortalIndexByEntry(toPosition(square));
+    if (index >= 0 && !portalSystem.isInCooldown(index)) {
+        graph.addEdge(square, toSquare(portalSystem.getPortal(index)->getExit()), true);
+    }
+}
+
+std::uint32_t MoveValidator::nextStamp() const {
+    if (++currentStamp == 0) {
+        // Wrapped around: old stamps could collide, start over
+        std::fill(visitStamp.begin(), visitStamp.end(), 0);
+        currentStamp = 1;
+    }
+    return currentStamp;
+}
+
+std::vector<Position> MoveValidator::bfs(const Position& start, const Position& goal) const {
+    const ChessPiece* piece = board.getPieceAt(start);
+    if (!piece) {
+        return {};
+    }
+
+    // The first hop uses the piece's own move edges; after that the piece can
+    // only travel on through portals, entering each one on an empty square
+    int startSquare = toSquare(start);
+    int goalSquare = toSquare(goal);
+    std::uint32_t stamp = nextStamp();
+
+    searchQueue.clear();
+    searchQueue.push_back(static_cast<std::uint16_t>(startSquare));
+    visitStamp[startSquare] = stamp;
+    parent[startSquare] = -1;
+
+    for (std::size_t head = 0; head < searchQueue.size(); ++head) {
+        int square = searchQueue[head];
+        bool atStart = square == startSquare;
+
+        if (!atStart && !board.isPositionEmpty(toPosition(square))) {
+            continue;
+        }
+
+        for (std::uint16_t edge : graph.getNeighbors(square)) {
+            bool isPortal = (edge & MoveGraph::kPortalBit) != 0;
+            int next = edge & MoveGraph::kSquareMask;
+
+            if (atStart == isPortal || visitStamp[next] == stamp) {
+                continue;
+            }
+            if (isPortal && !canUsePortal(toPosition(square), piece)) {
+                continue;
+            }
+            // Portal exits may not land on a friendly piece
+            const ChessPiece* target = board.getPieceAt(toPosition(next));
+            if (target && target->getColor() == piece->getColor()) {
+                continue;
+            }
+
+            visitStamp[next] = stamp;
+            parent[next] = square;
+            if (next == goalSquare) {
+                std::vector<Position> path;
+                for (int node = goalSquare; node != -1; node = parent[node]) {
+                    path.push_back(toPosition(node));
+                }
+                std::reverse(path.begin(), path.end());
+                return path;
+            }
+            searchQueue.push_back(static_cast<std::uint16_t>(next));
+        }
+    }
+
+    return {};
+}
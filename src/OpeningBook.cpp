@@ -0,0 +1,224 @@
+#include "../include/OpeningBook.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <iostream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+    constexpr std::uint32_t kByteOrderMark = 0x01020304;
+
+    struct BookHeader {
+        char magic[8];
+        std::uint32_t version;
+        std::uint32_t byteOrder;
+        std::uint64_t rulesKey;
+        std::uint64_t entryCount;
+    };
+
+    bool entryOrder(const BookEntry& a, const BookEntry& b) {
+        if (a.hash != b.hash) return a.hash < b.hash;
+        if (a.weight != b.weight) return a.weight > b.weight;
+        return a.move < b.move;
+    }
+
+    // Points for the side that moved in a game with this outcome
+    std::uint32_t score(SelfPlayOutcome outcome, Color mover) {
+        switch (outcome) {
+        case SelfPlayOutcome::WhiteWin:
+            return mover == Color::WHITE ? 2 : 0;
+        case SelfPlayOutcome::BlackWin:
+            return mover == Color::BLACK ? 2 : 0;
+        default:
+            return 1;
+        }
+    }
+}
+
+OpeningBook::~OpeningBook() {
+    if (data) {
+        munmap(const_cast<std::uint8_t*>(data), size);
+    }
+}
+
+bool OpeningBook::write(const std::string& path, const RuleSet& rules, std::vector<BookEntry> entries) {
+    std::sort(entries.begin(), entries.end(), entryOrder);
+    BookHeader header{};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kVersion;
+    header.byteOrder = kByteOrderMark;
+    header.rulesKey = rules.movementKey();
+    header.entryCount = entries.size();
+
+    std::string tempPath = path + ".tmp";
+    {
+        std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            std::cerr << "Failed to create opening book: " << tempPath << std::endl;
+            return false;
+        }
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(entries.data()),
+                   static_cast<std::streamsize>(entries.size() * sizeof(BookEntry)));
+        if (!file.flush()) {
+            std::cerr << "Failed to write opening book: " << tempPath << std::endl;
+            file.close();
+            std::remove(tempPath.c_str());
+            return false;
+        }
+    }
+    if (std::rename(tempPath.c_str(), path.c_str()) != 0) {
+        std::cerr << "Failed to move opening book into place: " << path << std::endl;
+        std::remove(tempPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+std::shared_ptr<const OpeningBook> OpeningBook::open(const std::string& path, const RuleSet& rules) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        std::cerr << "Failed to open opening book: " << path << std::endl;
+        return nullptr;
+    }
+    struct stat info {};
+    if (fstat(fd, &info) != 0 || static_cast<std::size_t>(info.st_size) < sizeof(BookHeader)) {
+        std::cerr << "Opening book is truncated: " << path << std::endl;
+        ::close(fd);
+        return nullptr;
+    }
+    std::size_t size = static_cast<std::size_t>(info.st_size);
+    void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        std::cerr << "Failed to map opening book: " << path << std::endl;
+        return nullptr;
+    }
+
+    // Owns the mapping from here on, so every early return unmaps it
+    const auto* bytes = static_cast<const std::uint8_t*>(mapping);
+    std::unique_ptr<OpeningBook> book(new OpeningBook(bytes, size));
+    const auto& header = *reinterpret_cast<const BookHeader*>(bytes);
+    if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0) {
+        std::cerr << "Not an opening book: " << path << std::endl;
+        return nullptr;
+    }
+    if (header.version != kVersion || header.byteOrder != kByteOrderMark) {
+        std::cerr << "Opening book was built by another version, build it again: " << path << std::endl;
+        return nullptr;
+    }
+    if (header.rulesKey != rules.movementKey()) {
+        std::cerr << "Opening book was built for other rules: " << path << std::endl;
+        return nullptr;
+    }
+    if (header.entryCount != (size - sizeof(BookHeader)) / sizeof(BookEntry) ||
+        (size - sizeof(BookHeader)) % sizeof(BookEntry) != 0) {
+        std::cerr << "Opening book is truncated or corrupt: " << path << std::endl;
+        return nullptr;
+    }
+    book->entries = reinterpret_cast<const BookEntry*>(bytes + sizeof(BookHeader));
+    book->entryCount = static_cast<std::size_t>(header.entryCount);
+    return book;
+}
+
+const BookEntry* OpeningBook::find(std::uint64_t hash, std::size_t& count) const {
+    const BookEntry* end = entries + entryCount;
+    auto before = [](const BookEntry& entry, std::uint64_t key) { return entry.hash < key; };
+    const BookEntry* first = std::lower_bound(entries, end, hash, before);
+    const BookEntry* last = first;
+    while (last != end && last->hash == hash) {
+        ++last;
+    }
+    count = static_cast<std::size_t>(last - first);
+    return first;
+}
+
+bool OpeningBook::probe(GameState& state, AttackMap& attacks, const MoveGenerator& generator, EngineMove& move,
+                        std::uint64_t random) const {
+    std::size_t count = 0;
+    const BookEntry* found = find(state.hash, count);
+    if (count == 0) {
+        return false;
+    }
+
+    // Only moves the generator would produce in this position are played
+    MoveList legal;
+    generator.generateLegal(state, attacks, legal);
+    auto isLegal = [&legal](std::uint32_t packed) {
+        for (const EngineMove& candidate : legal) {
+            if (candidate.pack() == packed) return true;
+        }
+        return false;
+    };
+    std::uint64_t total = 0;
+    for (std::size_t i = 0; i < count; ++i) {
+        if (isLegal(found[i].move)) total += found[i].weight;
+    }
+    if (total == 0) {
+        return false;
+    }
+    std::uint64_t point = random % total;
+    for (std::size_t i = 0; i < count; ++i) {
+        if (!isLegal(found[i].move)) continue;
+        if (point < found[i].weight) {
+            move = EngineMove::unpack(found[i].move);
+            return true;
+        }
+        point -= found[i].weight;
+    }
+    return false;
+}
+
+OpeningBookBuilder::OpeningBookBuilder(const RuleSet& rules, int maxPlies)
+    : rules(rules), maxPlies(maxPlies), generator(rules), attacks(rules), moves(std::make_unique<MoveList>()) {}
+
+bool OpeningBookBuilder::addGame(const SelfPlayGame& game) {
+    state.reset(rules);
+    attacks.build(state);
+    pending.clear();
+    std::size_t plies = std::min(game.moves.size(), static_cast<std::size_t>(std::max(maxPlies, 0)));
+    for (std::size_t ply = 0; ply < plies; ++ply) {
+        EngineMove move = EngineMove::unpack(game.moves[ply]);
+        generator.generateLegal(state, attacks, *moves);
+        if (std::find(moves->begin(), moves->end(), move) == moves->end()) {
+            std::cerr << "Game " << game.index << " has an illegal move at ply " << ply + 1
+                      << "; it was played under other rules" << std::endl;
+            return false;
+        }
+        pending.push_back(BookEntry{state.hash, game.moves[ply], score(game.outcome, state.sideToMove)});
+        int changed[4];
+        int changedCount = generator.getChangedSquares(move, changed);
+        generator.makeMove(state, move);
+        attacks.update(state, changed, changedCount);
+    }
+
+    for (const BookEntry& entry : pending) {
+        auto& candidates = positions[entry.hash];
+        auto found = std::find_if(candidates.begin(), candidates.end(),
+                                  [&entry](const Candidate& candidate) { return candidate.move == entry.move; });
+        if (found == candidates.end()) {
+            candidates.push_back(Candidate{entry.move, entry.weight, 1});
+        } else {
+            found->weight += entry.weight;
+            found->games++;
+        }
+    }
+    games++;
+    return true;
+}
+
+bool OpeningBookBuilder::write(const std::string& path, int minGames) const {
+    std::vector<BookEntry> entries;
+    for (const auto& [hash, candidates] : positions) {
+        for (const Candidate& candidate : candidates) {
+            if (candidate.weight > 0 && candidate.games >= static_cast<std::uint32_t>(minGames)) {
+                entries.push_back(BookEntry{hash, candidate.move, candidate.weight});
+            }
+        }
+    }
+    return OpeningBook::write(path, rules, std::move(entries));
+}
@@ -3,7 +3,7 @@
 Portal::Portal(std::string id, Position entry, Position exit, 
                bool preserveDirection, int cooldown)
     : id(id), entry(entry), exit(exit), 
-      preserveDirection(preserveDirection), cooldown(cooldown), remainingCooldown(0) {
+      preserveDirection(preserveDirection), cooldown(cooldown) {
     
     // By default, allow both colors to use the portal
     allowedColors.insert(Color::WHITE);
@@ -1,40 +1,70 @@
 #include "../include/PortalSystem.hpp"
+#include <algorithm>
+
+PortalSystem::PortalSystem(int boardSize)
+    : boardSize(boardSize),
+      entryIndex(static_cast<std::size_t>(boardSize) * boardSize, -1),
+      exitIndex(static_cast<std::size_t>(boardSize) * boardSize, -1),
+      wheelHead(1, -1) {}
+
+int PortalSystem::squareOf(const Position& position) const {
+    if (position.x < 0 || position.x >= boardSize || position.y < 0 || position.y >= boardSize) {
+        return -1;
+    }
+    return position.y * boardSize + position.x;
+}
 
 void PortalSystem::addPortal(std::unique_ptr<Portal> portal) {
-    // Store the portal ID for quick cooldown lookup
-    portalCooldownStatus[portal->getId()] = false;
+    auto index = static_cast<std::int32_t>(portals.size());
+    
+    // Index the portal by ID and by its entry/exit squares
+    indexById.emplace(portal->getId(), index);
+    int entry = squareOf(portal->getEntry());
+    if (entry >= 0 && entryIndex[entry] < 0) {
+        entryIndex[entry] = index;
+    }
+    int exit = squareOf(portal->getExit());
+    if (exit >= 0 && exitIndex[exit] < 0) {
+        exitIndex[exit] = index;
+    }
+    
+    // Cooldown state, kept out of the wheel until the portal is used
+    cooldownExpiry.push_back(0);
+    wheelNext.push_back(-1);
+    wheelPrev.push_back(-1);
+    int cooldown = portal->getCooldown();
     portals.push_back(std::move(portal));
+    expiredLastTurn.reserve(portals.size());
+    resizeWheel(cooldown);
+}
+
+int PortalSystem::getPortalIndexById(const std::string& id) const {
+    auto it = indexById.find(id);
+    return (it != indexById.end()) ? it->second : -1;
+}
+
+int PortalSystem::getPortalIndexByEntry(const Position& position) const {
+    int square = squareOf(position);
+    return square >= 0 ? entryIndex[square] : -1;
 }
 
 const Portal* PortalSystem::getPortalById(const std::string& id) const {
-    for (const auto& portal : portals) {
-        if (portal->getId() == id) {
-            return portal.get();
-        }
-    }
-    return nullptr;
+    int index = getPortalIndexById(id);
+    return index >= 0 ? portals[index].get() : nullptr;
 }
 
 const Portal* PortalSystem::getPortalByEntry(const Position& position) const {
-    for (const auto& portal : portals) {
-        if (portal->getEntry() == position) {
-            return portal.get();
-        }
-    }
-    return nullptr;
+    int index = getPortalIndexByEntry(position);
+    return index >= 0 ? portals[index].get() : nullptr;
 }
 
 bool PortalSystem::isEntryPoint(const Position& position) const {
-    return getPortalByEntry(position) != nullptr;
+    return getPortalIndexByEntry(position) >= 0;
 }
 
 bool PortalSystem::isExitPoint(const Position& position) const {
-    for (const auto& portal : portals) {
-        if (portal->getExit() == position) {
-            return true;
-        }
-    }
-    return false;
+    int square = squareOf(position);
+    return square >= 0 && exitIndex[square] >= 0;
 }
 
 bool PortalSystem::canUsePortal(const Portal* portal, const ChessPiece* piece) const {
@@ -42,8 +72,22 @@ bool PortalSystem::canUsePortal(const Portal* portal, const ChessPiece* piece) c
         return false;
     }
     
+    return canUsePortal(getPortalIndexById(portal->getId()), piece);
+}
+
+bool PortalSystem::canUsePortal(int index, const ChessPiece* piece) const {
+    if (index < 0 || !piece) {
+        return false;
+    }
+    const Portal* portal = portals[index].get();
+    
+    // Check if the piece has the portal_master ability (can use portals without restrictions)
+    if (piece->hasSpecialAbility("portal_master")) {
+        return true;
+    }
+    
     // Check if the portal is in cooldown
-    if (portal->isInCooldown()) {
+    if (isInCooldown(index)) {
         return false;
     }
     
@@ -52,11 +96,6 @@ bool PortalSystem::canUsePortal(const Portal* portal, const ChessPiece* piece) c
         return false;
     }
     
-    // Check if the piece has the portal_master ability (can use portals without restrictions)
-    if (piece->hasSpecialAbility("portal_master")) {
-        return true;
-    }
-    
     return true;
 }
 
@@ -67,69 +106,145 @@ Position PortalSystem::getExitPosition(const Position& entryPos) const {
 
 void PortalSystem::usePortal(const std::string& portalId) {
     // Find the portal by ID
-    Portal* portal = nullptr;
-    for (auto& p : portals) {
-        if (p->getId() == portalId) {
-            portal = p.get();
-            break;
-        }
+    int index = getPortalIndexById(portalId);
+    if (index >= 0) {
+        usePortal(index);
     }
+}
+
+PortalCooldownUndo PortalSystem::usePortal(int index) {
+    PortalCooldownUndo undo{static_cast<std::int32_t>(index), cooldownExpiry[index]};
     
-    if (!portal) {
-        return;
+    // Activate the cooldown (re-arming moves the portal to a new bucket)
+    if (isInCooldown(index)) {
+        unlinkCooldown(index);
+    }
+    cooldownExpiry[index] = std::int64_t{currentTurn} + portals[index]->getCooldown();
+    if (isInCooldown(index)) {
+        linkCooldown(index);
     }
     
-    // Activate the cooldown
-    portal->activateCooldown();
-    
-    // Add to cooldown queue if cooldown is greater than 0
-    if (portal->getCooldown() > 0) {
-        portalCooldownStatus[portalId] = true;
-        cooldownQueue.emplace(portalId, portal->getCooldown());
+    return undo;
+}
+
+void PortalSystem::undoUsePortal(const PortalCooldownUndo& undo) {
+    if (isInCooldown(undo.portalIndex)) {
+        unlinkCooldown(undo.portalIndex);
+    }
+    cooldownExpiry[undo.portalIndex] = undo.previousExpiry;
+    if (isInCooldown(undo.portalIndex)) {
+        linkCooldown(undo.portalIndex);
     }
 }
 
-void PortalSystem::processCooldowns() {
-    // Create a temporary queue to handle requeuing
-    std::queue<PortalCooldown> tempQueue;
+void PortalSystem::processCooldowns(std::vector<PortalExpiry>* undo) {
+    currentTurn++;
     
-    // Process each item in the cooldown queue
-    while (!cooldownQueue.empty()) {
-        PortalCooldown current = cooldownQueue.front();
-        cooldownQueue.pop();
-        
-        // Decrease the cooldown
-        current.turnsRemaining--;
-        
-        // If cooldown is still active, requeue it
-        if (current.turnsRemaining > 0) {
-            tempQueue.push(current);
-        } else {
-            // Reset cooldown status
-            portalCooldownStatus[current.portalId] = false;
-            
-            // Find the portal and reset its cooldown
-            for (auto& portal : portals) {
-                if (portal->getId() == current.portalId) {
-                    portal->decrementCooldown();
-                    break;
-                }
-            }
+    // The portals of this bucket expire now, unless they are due on a later
+    // round of the wheel
+    expiredLastTurn.clear();
+    std::int32_t next = wheelHead[currentTurn & wheelMask];
+    while (next >= 0) {
+        std::int32_t index = next;
+        next = wheelNext[index];
+        if (cooldownExpiry[index] != currentTurn) {
+            continue;
         }
+        unlinkCooldown(index);
+        expiredLastTurn.push_back(index);
+        if (undo) {
+            undo->push_back(PortalExpiry{currentTurn, index});
+        }
+    }
+}
+
+void PortalSystem::undoProcessCooldowns(std::vector<PortalExpiry>& undo) {
+    if (currentTurn == 0) {
+        return;
     }
     
-    // Restore the queue with updated cooldowns
-    cooldownQueue = std::move(tempQueue);
+    // Put the portals that expired on this turn back into cooldown
+    while (!undo.empty() && undo.back().turn == currentTurn) {
+        linkCooldown(undo.back().portalIndex);
+        undo.pop_back();
+    }
+    expiredLastTurn.clear();
+    currentTurn--;
+}
+
+int PortalSystem::getRemainingCooldown(int index) const {
+    return isInCooldown(index) ? static_cast<int>(cooldownExpiry[index] - currentTurn) : 0;
+}
+
+std::span<const std::int32_t> PortalSystem::getExpiredLastTurn() const {
+    return expiredLastTurn;
 }
 
 std::vector<std::string> PortalSystem::getPortalsInCooldown() const {
     std::vector<std::string> result;
     
-    for (const auto& [id, inCooldown] : portalCooldownStatus) {
-        if (inCooldown) {
-            result.push_back(id);
+    for (std::int32_t head : wheelHead) {
+        for (std::int32_t index = head; index >= 0; index = wheelNext[index]) {
+            result.push_back(portals[index]->getId());
         }
     }
     
     return result;
-}
\ No newline at end of file
+}
+
+void PortalSystem::resetCooldowns() {
+    currentTurn = 0;
+    std::fill(cooldownExpiry.begin(), cooldownExpiry.end(), 0);
+    std::fill(wheelHead.begin(), wheelHead.end(), -1);
+    expiredLastTurn.clear();
+}
+
+void PortalSystem::setRemainingCooldown(int index, int turns) {
+    if (isInCooldown(index)) {
+        unlinkCooldown(index);
+    }
+    cooldownExpiry[index] = std::int64_t{currentTurn} + std::clamp(turns, 0, portals[index]->getCooldown());
+    if (isInCooldown(index)) {
+        linkCooldown(index);
+    }
+}
+
+void PortalSystem::linkCooldown(int index) {
+    std::int32_t& head = wheelHead[cooldownExpiry[index] & wheelMask];
+    wheelPrev[index] = -1;
+    wheelNext[index] = head;
+    if (head >= 0) {
+        wheelPrev[head] = static_cast<std::int32_t>(index);
+    }
+    head = static_cast<std::int32_t>(index);
+}
+
+void PortalSystem::unlinkCooldown(int index) {
+    if (wheelPrev[index] >= 0) {
+        wheelNext[wheelPrev[index]] = wheelNext[index];
+    } else {
+        wheelHead[cooldownExpiry[index] & wheelMask] = wheelNext[index];
+    }
+    if (wheelNext[index] >= 0) {
+        wheelPrev[wheelNext[index]] = wheelPrev[index];
+    }
+}
+
+void PortalSystem::resizeWheel(int maxCooldown) {
+    // Smallest power of two larger than the longest cooldown, within the cap
+    std::size_t buckets = 1;
+    while (buckets <= static_cast<std::size_t>(std::max(maxCooldown, 0)) && buckets < kMaxWheelBuckets) {
+        buckets <<= 1;
+    }
+    if (buckets <= wheelHead.size()) {
+        return;
+    }
+    
+    wheelHead.assign(buckets, -1);
+    wheelMask = static_cast<int>(buckets) - 1;
+    for (int index = 0; index < static_cast<int>(portals.size()); ++index) {
+        if (isInCooldown(index)) {
+            linkCooldown(index);
+        }
+    }
+}
@@ -0,0 +1,341 @@
+#include "../include/RuleSet.hpp"
+#include "../include/ContentHash.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+namespace {
+    constexpr std::int8_t kKnightJumps[8][2] = {
+        {1, 2}, {2, 1}, {2, -1}, {1, -2}, {-1, -2}, {-2, -1}, {-2, 1}, {-1, 2}
+    };
+
+    // Deterministic key generator, so the same config always hashes the same
+    std::uint64_t splitMix64(std::uint64_t& state) {
+        std::uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+
+    int directionIndex(int dx, int dy) {
+        for (int i = 0; i < 8; ++i) {
+            if (kDirections[i][0] == dx && kDirections[i][1] == dy) {
+                return i;
+            }
+        }
+        return -1;
+    }
+
+    void copyName(char (&target)[kMaxNameLength], const std::string& name) {
+        std::memset(target, 0, kMaxNameLength);
+        std::memcpy(target, name.data(), std::min<std::size_t>(name.size(), kMaxNameLength - 1));
+    }
+
+    class RayBuilder {
+    public:
+        RayBuilder(PieceRules& kind, int boardSize) : kind(kind), maxRange(boardSize - 1) {}
+
+        void add(int dx, int dy, int range, std::uint8_t flags, int firstRange = 0) {
+            if (range <= 0 && firstRange <= 0) {
+                return;
+            }
+            if (kind.rayCount >= kMaxRaysPerKind) {
+                return;
+            }
+            bool unit = std::abs(dx) <= 1 && std::abs(dy) <= 1;
+            MoveRay& ray = kind.rays[kind.rayCount++];
+            ray.dx = static_cast<std::int8_t>(dx);
+            ray.dy = static_cast<std::int8_t>(dy);
+            ray.range = static_cast<std::uint8_t>(unit ? std::min(range, maxRange) : std::min(range, 1));
+            ray.firstRange = static_cast<std::uint8_t>(unit ? std::min(std::max(range, firstRange), maxRange)
+                                                            : ray.range);
+            ray.flags = flags;
+            ray.direction[0] = static_cast<std::int8_t>(unit ? directionIndex(dx, dy) : -1);
+            ray.direction[1] = static_cast<std::int8_t>(unit ? directionIndex(dx, -dy) : -1);
+        }
+
+        void addOrthogonal(int range, std::uint8_t flags) {
+            add(0, 1, range, flags);
+            add(0, -1, range, flags);
+            add(1, 0, range, flags);
+            add(-1, 0, range, flags);
+        }
+
+        void addDiagonal(int range, std::uint8_t flags) {
+            add(1, 1, range, flags);
+            add(1, -1, range, flags);
+            add(-1, 1, range, flags);
+            add(-1, -1, range, flags);
+        }
+
+        void addKnight(std::uint8_t flags) {
+            for (const auto& jump : kKnightJumps) {
+                add(jump[0], jump[1], 1, flags);
+            }
+        }
+
+    private:
+        PieceRules& kind;
+        int maxRange;
+    };
+
+    constexpr std::uint8_t kMoveOrCapture = MoveRay::kMove | MoveRay::kCapture;
+
+    // Standard pieces move as in chess regardless of the movement numbers in
+    // the config (which only describe them approximately)
+    bool compileStandardRays(const std::string& type, RayBuilder& rays, int boardSize) {
+        int full = boardSize - 1;
+        if (type == "King") {
+            rays.addOrthogonal(1, kMoveOrCapture);
+            rays.addDiagonal(1, kMoveOrCapture);
+        } else if (type == "Queen") {
+            rays.addOrthogonal(full, kMoveOrCapture);
+            rays.addDiagonal(full, kMoveOrCapture);
+        } else if (type == "Rook") {
+            rays.addOrthogonal(full, kMoveOrCapture);
+        } else if (type == "Bishop") {
+            rays.addDiagonal(full, kMoveOrCapture);
+        } else if (type == "Knight") {
+            rays.addKnight(kMoveOrCapture);
+        } else if (type == "Pawn") {
+            rays.add(0, 1, 1, MoveRay::kMove, 2);
+            rays.add(1, 1, 1, MoveRay::kCapture);
+            rays.add(-1, 1, 1, MoveRay::kCapture);
+        } else {
+            return false;
+        }
+        return true;
+    }
+
+    // Custom pieces follow CustomPiece: forward moves only go forward, and a
+    // piece with diagonal_capture moves like a pawn (no capturing forward)
+    void compileCustomRays(const Movement& movement, bool jumpOver, RayBuilder& rays) {
+        std::uint8_t slide = kMoveOrCapture | (jumpOver ? MoveRay::kJump : 0);
+        bool pawnLike = movement.diagonal_capture > 0;
+
+        rays.add(0, 1, movement.forward, pawnLike ? MoveRay::kMove : slide, movement.first_move_forward);
+        rays.add(1, 0, movement.sideways, slide);
+        rays.add(-1, 0, movement.sideways, slide);
+        rays.addDiagonal(movement.diagonal, slide);
+        if (movement.diagonal_capture > movement.diagonal) {
+            rays.add(1, 1, movement.diagonal_capture, MoveRay::kCapture);
+            rays.add(-1, 1, movement.diagonal_capture, MoveRay::kCapture);
+        }
+        if (movement.l_shape) {
+            rays.addKnight(kMoveOrCapture);
+        }
+    }
+
+    std::uint8_t compileAbilities(const std::string& type, const SpecialAbilities& abilities) {
+        std::uint8_t flags = 0;
+        if (abilities.royal || type == "King") flags |= PieceRules::kRoyal;
+        if (abilities.castling || type == "King" || type == "Rook") flags |= PieceRules::kCastling;
+        if (abilities.promotion || type == "Pawn") flags |= PieceRules::kPromotion;
+        if (abilities.en_passant || type == "Pawn") flags |= PieceRules::kEnPassant;
+        if (abilities.jump_over || type == "Knight") flags |= PieceRules::kJumpOver;
+        auto it = abilities.custom_abilities.find("portal_master");
+        if (it != abilities.custom_abilities.end() && it->second) flags |= PieceRules::kPortalMaster;
+        return flags;
+    }
+
+    char standardLetter(const std::string& type) {
+        if (type == "King") return 'K';
+        if (type == "Queen") return 'Q';
+        if (type == "Rook") return 'R';
+        if (type == "Bishop") return 'B';
+        if (type == "Knight") return 'N';
+        if (type == "Pawn") return 'P';
+        return 0;
+    }
+}
+
+std::unique_ptr<RuleSet> RuleSet::compile(const GameConfig& config) {
+    int boardSize = config.game_settings.board_size;
+    if (boardSize <= 0 || boardSize > kMaxBoardSize) {
+        std::cerr << "Board size " << boardSize << " is not supported by the move generator (max "
+                  << kMaxBoardSize << ")" << std::endl;
+        return nullptr;
+    }
+    if (config.portals.size() > static_cast<std::size_t>(kMaxPortals)) {
+        std::cerr << "Too many portals for the move generator (max " << kMaxPortals << ")" << std::endl;
+        return nullptr;
+    }
+
+    auto rules = std::make_unique<RuleSet>();
+    std::memset(rules.get(), 0, sizeof(RuleSet));
+    rules->boardSize = boardSize;
+    rules->squareCount = boardSize * boardSize;
+    rules->turnLimit = config.game_settings.turn_limit;
+    std::memset(rules->portalAt, kNoPortal, sizeof(rules->portalAt));
+
+    // Piece kinds, in config order (standard pieces first). The standard
+    // letters are reserved so custom pieces never shadow them.
+    bool usedLetters[26] = {};
+    for (char c : {'K', 'Q', 'R', 'B', 'N', 'P'}) {
+        usedLetters[c - 'A'] = true;
+    }
+    auto addKind = [&](const PieceConfig& piece) -> int {
+        int existing = rules->findKind(piece.type);
+        if (existing >= 0) {
+            return existing;
+        }
+        if (piece.type.size() >= static_cast<std::size_t>(kMaxNameLength)) {
+            std::cerr << "Piece type name " << piece.type << " is too long for the move generator" << std::endl;
+            return -1;
+        }
+        if (rules->kindCount >= kMaxPieceKinds) {
+            std::cerr << "Too many piece types for the move generator (max " << kMaxPieceKinds << ")"
+                      << std::endl;
+            return -1;
+        }
+
+        int index = rules->kindCount++;
+        PieceRules& kind = rules->kinds[index];
+        copyName(kind.name, piece.type);
+        kind.abilities = compileAbilities(piece.type, piece.special_abilities);
+
+        RayBuilder rays(kind, boardSize);
+        if (!compileStandardRays(piece.type, rays, boardSize)) {
+            compileCustomRays(piece.movement, kind.has(PieceRules::kJumpOver), rays);
+        }
+
+        // Letter: the standard one, else the first free letter of the name,
+        // else any free letter
+        char letter = standardLetter(piece.type);
+        for (char c : piece.type) {
+            if (letter) break;
+            if (std::isalpha(static_cast<unsigned char>(c))) {
+                char upper = static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+                if (!usedLetters[upper - 'A']) letter = upper;
+            }
+        }
+        for (int i = 0; i < 26 && !letter; ++i) {
+            if (!usedLetters[i]) letter = static_cast<char>('A' + i);
+        }
+        kind.letter = letter;
+        if (letter) usedLetters[letter - 'A'] = true;
+        return index;
+    };
+
+    // Starting position (an occupied square keeps its first piece, as in
+    // ChessBoard::placePiece)
+    auto placePieces = [&](const PieceConfig& piece) -> bool {
+        int kind = addKind(piece);
+        if (kind < 0) {
+            return false;
+        }
+        for (Color color : {Color::WHITE, Color::BLACK}) {
+            auto it = piece.positions.find(color == Color::WHITE ? "white" : "black");
+            if (it == piece.positions.end()) continue;
+            for (const auto& pos : it->second) {
+                if (pos.x < 0 || pos.x >= boardSize || pos.y < 0 || pos.y >= boardSize) continue;
+                std::uint8_t& square = rules->initialSquares[rules->squareOf(pos.x, pos.y)];
+                if (square == kEmptySquare) {
+                    square = makePieceCode(kind, color);
+                }
+            }
+        }
+        return true;
+    };
+
+    for (const auto& piece : config.pieces) {
+        if (!placePieces(piece)) return nullptr;
+    }
+    for (const auto& piece : config.custom_pieces) {
+        if (!placePieces(piece)) return nullptr;
+    }
+
+    for (int kind = 0; kind < rules->kindCount; ++kind) {
+        if (!rules->kinds[kind].has(PieceRules::kRoyal) && !rules->kinds[kind].has(PieceRules::kPromotion)) {
+            rules->promotionKinds[rules->promotionCount++] = static_cast<std::uint8_t>(kind);
+        }
+    }
+
+    // Portals
+    for (const auto& portalConfig : config.portals) {
+        const Position& entry = portalConfig.positions.entry;
+        const Position& exit = portalConfig.positions.exit;
+        if (entry.x < 0 || entry.x >= boardSize || entry.y < 0 || entry.y >= boardSize ||
+            exit.x < 0 || exit.x >= boardSize || exit.y < 0 || exit.y >= boardSize) {
+            std::cerr << "Portal " << portalConfig.id << " is outside the board" << std::endl;
+            return nullptr;
+        }
+        if (portalConfig.properties.cooldown < 0 || portalConfig.properties.cooldown > kMaxCooldown) {
+            std::cerr << "Portal " << portalConfig.id << " cooldown exceeds " << kMaxCooldown << std::endl;
+            return nullptr;
+        }
+
+        int index = rules->portalCount++;
+        PortalRules& portal = rules->portals[index];
+        copyName(portal.id, portalConfig.id);
+        portal.entry = static_cast<std::uint8_t>(rules->squareOf(entry.x, entry.y));
+        portal.exit = static_cast<std::uint8_t>(rules->squareOf(exit.x, exit.y));
+        portal.cooldown = static_cast<std::uint8_t>(portalConfig.properties.cooldown);
+        portal.preserveDirection = portalConfig.properties.preserve_direction;
+        for (const auto& color : portalConfig.properties.allowed_colors) {
+            if (color == "white") portal.colorMask |= 1;
+            if (color == "black") portal.colorMask |= 2;
+        }
+        if (portalConfig.properties.allowed_colors.empty()) {
+            portal.colorMask = 3;
+        }
+
+        // Squares beyond the exit in each direction
+        for (int dir = 0; dir < 8; ++dir) {
+            int x = exit.x + kDirections[dir][0];
+            int y = exit.y + kDirections[dir][1];
+            int length = 0;
+            while (x >= 0 && x < boardSize && y >= 0 && y < boardSize) {
+                portal.exitRay[dir][length++] = static_cast<std::uint8_t>(rules->squareOf(x, y));
+                x += kDirections[dir][0];
+                y += kDirections[dir][1];
+            }
+            portal.exitRayLength[dir] = static_cast<std::uint8_t>(length);
+        }
+
+        if (rules->portalAt[portal.entry] == kNoPortal) {
+            rules->portalAt[portal.entry] = static_cast<std::uint8_t>(index);
+        }
+    }
+
+    // Zobrist keys (empty squares and idle portals hash to zero)
+    std::uint64_t seed = 0x5EEDC0FFEE123457ULL;
+    for (int square = 0; square < kMaxSquares; ++square) {
+        for (int code = 1; code < kMaxPieceCodes; ++code) {
+            rules->pieceKeys[square][code] = splitMix64(seed);
+        }
+        rules->unmovedKeys[square] = splitMix64(seed);
+    }
+    for (int portal = 0; portal < kMaxPortals; ++portal) {
+        for (int cooldown = 1; cooldown <= kMaxCooldown; ++cooldown) {
+            rules->cooldownKeys[portal][cooldown] = splitMix64(seed);
+        }
+    }
+    rules->sideKey = splitMix64(seed);
+    for (int square = 0; square < kMaxSquares; ++square) {
+        rules->epKeys[square] = splitMix64(seed);
+    }
+
+    return rules;
+}
+
+std::uint64_t RuleSet::movementKey() const {
+    std::uint64_t key = hashBytes(kinds, sizeof(PieceRules) * static_cast<std::size_t>(kindCount));
+    auto mix = [&key](std::uint64_t value) { key = (key ^ value) * 0x9E3779B97F4A7C15ULL; };
+    mix(static_cast<std::uint64_t>(boardSize));
+    mix(static_cast<std::uint64_t>(kindCount));
+    mix(hashBytes(portals, sizeof(PortalRules) * static_cast<std::size_t>(portalCount)));
+    mix(hashBytes(promotionKinds, static_cast<std::size_t>(promotionCount)));
+    return key;
+}
+
+int RuleSet::findKind(std::string_view type) const {
+    for (int i = 0; i < kindCount; ++i) {
+        if (type == kinds[i].name) {
+            return i;
+        }
+    }
+    return -1;
+}
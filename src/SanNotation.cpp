@@ -0,0 +1,261 @@
+#include "../include/SanNotation.hpp"
+#include <cctype>
+
+namespace {
+    // What a move text says about the move
+    struct SanMove {
+        bool castle = false;
+        bool highSide = false;  // Castling towards the higher files
+        int kind = -1;          // -1: no letter
+        int fromFile = -1;
+        int fromRank = -1;
+        int entry = -1;         // Portal entry square, -1 for a direct move
+        int to = -1;
+        int promotion = -1;
+    };
+
+    bool isFile(char c) { return c >= 'a' && c <= 'z'; }
+    bool isDigit(char c) { return c >= '0' && c <= '9'; }
+
+    // Strip check and annotation marks from the end
+    std::string_view stripMarks(std::string_view text) {
+        while (!text.empty() && (text.back() == '+' || text.back() == '#' || text.back() == '!' ||
+                                 text.back() == '?')) {
+            text.remove_suffix(1);
+        }
+        return text;
+    }
+
+    void putSquare(const RuleSet& rules, int square, char*& out) {
+        *out++ = static_cast<char>('a' + rules.fileOf(square));
+        int rank = rules.rankOf(square) + 1;
+        if (rank >= 10) {
+            *out++ = '1';
+        }
+        *out++ = static_cast<char>('0' + rank % 10);
+    }
+}
+
+SanNotation::SanNotation(const RuleSet& rules)
+    : rules(rules), generator(rules), moves(std::make_unique<MoveList>()) {
+    int promotable = 0;
+    for (int& kind : letterKinds) {
+        kind = -1;
+    }
+    for (int kind = 0; kind < rules.kindCount; ++kind) {
+        char letter = rules.kinds[kind].letter;
+        if (letter >= 'A' && letter <= 'Z') {
+            letterKinds[letter - 'A'] = kind;
+        }
+        if (rules.kinds[kind].has(PieceRules::kPromotion)) {
+            promotable++;
+        }
+    }
+    implicitKind = promotable == 1;
+}
+
+int SanNotation::readKind(char letter) const {
+    letter = static_cast<char>(std::toupper(static_cast<unsigned char>(letter)));
+    return letter >= 'A' && letter <= 'Z' ? letterKinds[letter - 'A'] : -1;
+}
+
+bool SanNotation::readSquare(std::string_view& text, int& square) const {
+    // Rank digits, then the file letter, read from the end
+    std::size_t digits = 0;
+    while (digits < 2 && digits < text.size() && isDigit(text[text.size() - 1 - digits])) {
+        digits++;
+    }
+    if (digits == 0 || digits == text.size() || !isFile(text[text.size() - 1 - digits])) {
+        return false;
+    }
+    int rank = 0;
+    for (std::size_t i = text.size() - digits; i < text.size(); ++i) {
+        rank = rank * 10 + (text[i] - '0');
+    }
+    int file = text[text.size() - 1 - digits] - 'a';
+    if (rank < 1 || rank > rules.boardSize || file >= rules.boardSize) {
+        return false;
+    }
+    square = rules.squareOf(file, rank - 1);
+    text.remove_suffix(digits + 1);
+    return true;
+}
+
+SanStatus SanNotation::parse(GameState& state, AttackMap& attacks, std::string_view text, EngineMove& move,
+                             int& index) {
+    SanMove san;
+    text = stripMarks(text);
+    if (text == "O-O" || text == "0-0") {
+        san.castle = true;
+        san.highSide = true;
+    } else if (text == "O-O-O" || text == "0-0-0") {
+        san.castle = true;
+    } else {
+        // Read from the end: promotion, destination, portal entry, capture
+        // mark, then from the front: kind letter and origin
+        std::size_t equals = text.rfind('=');
+        if (equals != std::string_view::npos) {
+            if (equals + 2 != text.size() || (san.promotion = readKind(text[equals + 1])) < 0) {
+                return SanStatus::Malformed;
+            }
+            text = text.substr(0, equals);
+        } else if (!text.empty() && std::isupper(static_cast<unsigned char>(text.back())) && text.size() > 1 &&
+                   isDigit(text[text.size() - 2])) {
+            if ((san.promotion = readKind(text.back())) < 0) {
+                return SanStatus::Malformed;
+            }
+            text.remove_suffix(1);
+        }
+        if (!readSquare(text, san.to)) {
+            return SanStatus::Malformed;
+        }
+        if (!text.empty() && text.back() == '>') {
+            text.remove_suffix(1);
+            if (!readSquare(text, san.entry) || rules.portalAt[san.entry] == kNoPortal) {
+                return SanStatus::Malformed;
+            }
+        }
+        if (!text.empty() && (text.back() == 'x' || text.back() == ':')) {
+            text.remove_suffix(1);
+        }
+        if (!text.empty() && std::isupper(static_cast<unsigned char>(text.front()))) {
+            if ((san.kind = readKind(text.front())) < 0) {
+                return SanStatus::Malformed;
+            }
+            text.remove_prefix(1);
+        }
+        if (!text.empty() && isFile(text.front())) {
+            san.fromFile = text.front() - 'a';
+            text.remove_prefix(1);
+        }
+        if (!text.empty()) {
+            san.fromRank = 0;
+            for (char c : text) {
+                if (!isDigit(c)) {
+                    return SanStatus::Malformed;
+                }
+                san.fromRank = san.fromRank * 10 + (c - '0');
+            }
+            san.fromRank--;
+        }
+    }
+
+    generator.generate(state, *moves);
+    int found = -1;
+    for (int i = 0; i < moves->count; ++i) {
+        const EngineMove& candidate = moves->moves[i];
+        if (san.castle) {
+            if (candidate.special() != EngineMove::kCastle || (candidate.to > candidate.from) != san.highSide) {
+                continue;
+            }
+        } else {
+            if (candidate.to != san.to || candidate.special() == EngineMove::kCastle) {
+                continue;
+            }
+            if (san.entry < 0 ? candidate.portal != kNoPortal
+                              : candidate.portal == kNoPortal || rules.portals[candidate.portal].entry != san.entry) {
+                continue;
+            }
+            int kind = pieceKind(state.squares[candidate.from]);
+            if (san.kind < 0 ? !rules.kinds[kind].has(PieceRules::kPromotion) : kind != san.kind) {
+                continue;
+            }
+            if ((san.fromFile >= 0 && rules.fileOf(candidate.from) != san.fromFile) ||
+                (san.fromRank >= 0 && rules.rankOf(candidate.from) != san.fromRank)) {
+                continue;
+            }
+            if (san.promotion < 0 ? candidate.isPromotion()
+                                  : !candidate.isPromotion() || candidate.promotionKind() != san.promotion) {
+                continue;
+            }
+        }
+        if (!generator.isLegal(state, attacks, candidate)) {
+            continue;
+        }
+        if (found >= 0) {
+            return SanStatus::Ambiguous;
+        }
+        found = i;
+    }
+    if (found < 0) {
+        return SanStatus::NoMove;
+    }
+    move = moves->moves[found];
+    index = found;
+    return SanStatus::Ok;
+}
+
+std::size_t SanNotation::write(GameState& state, AttackMap& attacks, const EngineMove& move, char* out) {
+    char* start = out;
+    if (move.special() == EngineMove::kCastle) {
+        for (char c : std::string_view(move.to > move.from ? "O-O" : "O-O-O")) {
+            *out++ = c;
+        }
+    } else {
+        int kind = pieceKind(state.squares[move.from]);
+        bool implicit = implicitKind && rules.kinds[kind].has(PieceRules::kPromotion);
+        if (!implicit) {
+            if (!rules.kinds[kind].letter) {
+                return 0;
+            }
+            *out++ = rules.kinds[kind].letter;
+        }
+
+        // Other legal moves of the same kind to the same square, the same way
+        bool ambiguous = false;
+        bool sameFile = false;
+        bool sameRank = false;
+        generator.generate(state, *moves);
+        for (const EngineMove& other : *moves) {
+            if (other.to != move.to || other.from == move.from || other.portal != move.portal ||
+                other.flags != move.flags || pieceKind(state.squares[other.from]) != kind ||
+                !generator.isLegal(state, attacks, other)) {
+                continue;
+            }
+            ambiguous = true;
+            sameFile |= rules.fileOf(other.from) == rules.fileOf(move.from);
+            sameRank |= rules.rankOf(other.from) == rules.rankOf(move.from);
+        }
+        bool capture = move.special() == EngineMove::kEnPassant || state.squares[move.to] != kEmptySquare;
+        if ((ambiguous && (!sameFile || sameRank)) || (implicit && capture)) {
+            *out++ = static_cast<char>('a' + rules.fileOf(move.from));
+        }
+        if (ambiguous && sameFile) {
+            int rank = rules.rankOf(move.from) + 1;
+            if (rank >= 10) {
+                *out++ = '1';
+            }
+            *out++ = static_cast<char>('0' + rank % 10);
+        }
+        if (capture) {
+            *out++ = 'x';
+        }
+        if (move.portal != kNoPortal) {
+            putSquare(rules, rules.portals[move.portal].entry, out);
+            *out++ = '>';
+        }
+        putSquare(rules, move.to, out);
+        if (move.isPromotion()) {
+            if (!rules.kinds[move.promotionKind()].letter) {
+                return 0;
+            }
+            *out++ = '=';
+            *out++ = rules.kinds[move.promotionKind()].letter;
+        }
+    }
+
+    // Check or mate for the opponent
+    Color mover = state.sideToMove;
+    Color opponent = mover == Color::WHITE ? Color::BLACK : Color::WHITE;
+    int changed[4];
+    int changedCount = generator.getChangedSquares(move, changed);
+    UndoInfo undo;
+    generator.makeMove(state, move, undo);
+    attacks.update(state, changed, changedCount);
+    if (attacks.isInCheck(opponent)) {
+        *out++ = generator.hasLegalMove(state, attacks) ? '+' : '#';
+    }
+    generator.unmakeMove(state, move, undo);
+    attacks.update(state, changed, changedCount);
+    return static_cast<std::size_t>(out - start);
+}
@@ -0,0 +1,310 @@
+#include "../include/Search.hpp"
+#include <algorithm>
+#include <cstdlib>
+
+namespace {
+    // Classic values for the standard pieces, by their reserved letters
+    int standardValue(char letter) {
+        switch (letter) {
+        case 'Q': return 900;
+        case 'R': return 500;
+        case 'B': return 330;
+        case 'N': return 320;
+        case 'P': return 100;
+        default: return 0;
+        }
+    }
+
+    // Squares a kind reaches from the middle of an empty board (portals and
+    // first-move ranges aside)
+    int reachFromCenter(const RuleSet& rules, const PieceRules& kind) {
+        int size = rules.boardSize;
+        bool reached[kMaxSquares] = {};
+        int count = 0;
+        for (int r = 0; r < kind.rayCount; ++r) {
+            const MoveRay& ray = kind.rays[r];
+            int x = size / 2;
+            int y = size / 2;
+            for (int step = 1; step <= ray.range; ++step) {
+                x += ray.dx;
+                y += ray.dy;
+                if (x < 0 || x >= size || y < 0 || y >= size) break;
+                int square = rules.squareOf(x, y);
+                if (!reached[square]) {
+                    reached[square] = true;
+                    ++count;
+                }
+            }
+        }
+        return count;
+    }
+
+    // Same for a queen, the scale custom pieces are valued on
+    int queenReach(int size) {
+        int count = 0;
+        for (const auto& direction : kDirections) {
+            int x = size / 2 + direction[0];
+            int y = size / 2 + direction[1];
+            for (; x >= 0 && x < size && y >= 0 && y < size; x += direction[0], y += direction[1]) {
+                ++count;
+            }
+        }
+        return count;
+    }
+}
+
+Search::Search(const RuleSet& rules)
+    : rules(rules), generator(rules), squareValues(std::make_unique<int[]>(kMaxPieceCodes * kMaxSquares)),
+      plies(std::make_unique<Ply[]>(kMaxPly)) {
+    int size = rules.boardSize;
+    int queen = std::max(1, queenReach(size));
+    for (int kind = 0; kind < kMaxPieceKinds; ++kind) {
+        pieceValues[kind] = 0;
+        if (kind >= rules.kindCount || rules.kinds[kind].has(PieceRules::kRoyal)) {
+            continue;
+        }
+        int value = standardValue(rules.kinds[kind].letter);
+        if (value == 0) {
+            value = std::max(50, 900 * reachFromCenter(rules, rules.kinds[kind]) / queen);
+        }
+        pieceValues[kind] = value;
+    }
+
+    // Material plus placement: promotable pieces gain for every rank they
+    // advance, other non-royal pieces for being near the centre
+    for (int kind = 0; kind < rules.kindCount; ++kind) {
+        const PieceRules& rulesOfKind = rules.kinds[kind];
+        for (Color color : {Color::WHITE, Color::BLACK}) {
+            int* values = &squareValues[makePieceCode(kind, color) * kMaxSquares];
+            int sign = color == Color::WHITE ? 1 : -1;
+            for (int square = 0; square < rules.squareCount; ++square) {
+                int x = rules.fileOf(square);
+                int y = rules.rankOf(square);
+                int bonus = 0;
+                if (rulesOfKind.has(PieceRules::kPromotion)) {
+                    bonus = 6 * (color == Color::WHITE ? y : size - 1 - y);
+                } else if (!rulesOfKind.has(PieceRules::kRoyal)) {
+                    int distance = std::max(std::abs(2 * x - (size - 1)), std::abs(2 * y - (size - 1))) / 2;
+                    bonus = 4 * (size / 2 - distance);
+                }
+                values[square] = sign * (pieceValues[kind] + bonus);
+            }
+        }
+    }
+}
+
+int Search::evaluate(const GameState& state) const {
+    int score = 0;
+    for (int square = 0; square < rules.squareCount; ++square) {
+        std::uint8_t code = state.squares[square];
+        if (code != kEmptySquare) {
+            score += squareValues[code * kMaxSquares + square];
+        }
+    }
+    return state.sideToMove == Color::WHITE ? score : -score;
+}
+
+SearchResult Search::think(GameState& state, AttackMap& attacks, const SearchLimits& limits) {
+    nodes = 0;
+    tablebaseHits = 0;
+    nodeLimit = std::max<std::uint64_t>(1, limits.nodes);
+    stopped = false;
+
+    SearchResult result;
+    EngineMove best{};
+    int maxDepth = std::clamp(limits.depth, 1, kMaxPly - 1);
+    for (int depth = 1; depth <= maxDepth; ++depth) {
+        // The previous iteration's best move is searched first
+        EngineMove iterationBest = best;
+        int score = negamax(state, attacks, depth, 0, -kMateScore - 1, kMateScore + 1, iterationBest);
+        if (stopped) {
+            // An unfinished first iteration still beats no move at all
+            if (result.depth == 0) {
+                result.move = iterationBest;
+            }
+            break;
+        }
+        best = iterationBest;
+        result.move = best;
+        result.score = score;
+        result.depth = depth;
+        if (std::abs(score) >= kMateScore - kMaxPly) {
+            break;
+        }
+    }
+
+    // Budget too small to search a single move
+    if (result.move.pack() == 0) {
+        MoveList& moves = plies[0].moves;
+        generator.generateLegal(state, attacks, moves);
+        if (moves.count > 0) {
+            result.move = moves.moves[0];
+        }
+    }
+    result.nodes = nodes;
+    result.tablebaseHits = tablebaseHits;
+    return result;
+}
+
+int Search::negamax(GameState& state, AttackMap& attacks, int depth, int ply, int alpha, int beta,
+                    EngineMove& best) {
+    if (depth <= 0) {
+        return quiesce(state, attacks, ply, alpha, beta);
+    }
+    if (++nodes >= nodeLimit) {
+        stopped = true;
+        return 0;
+    }
+    if (ply >= kMaxPly - 1) {
+        return evaluate(state);
+    }
+    TablebaseProbe probe;
+    if (tablebases && ply > 0 && tablebases->probe(state, probe)) {
+        tablebaseHits++;
+        if (probe.wdl == Wdl::Draw) {
+            return 0;
+        }
+        int mate = kMateScore - ply - probe.dtm;
+        return probe.wdl == Wdl::Win ? mate : -mate;
+    }
+
+    Ply& data = plies[ply];
+    generator.generate(state, data.moves);
+    scoreMoves(state, data, best);
+
+    Color mover = state.sideToMove;
+    int bestScore = -kMateScore - 1;
+    int legal = 0;
+    UndoInfo undo;
+    for (int i = 0; i < data.moves.count; ++i) {
+        EngineMove move = pickNext(data, i);
+        if (!tryMove(state, attacks, move, undo)) {
+            continue;
+        }
+        ++legal;
+        EngineMove childBest{};
+        int score = -negamax(state, attacks, depth - 1, ply + 1, -beta, -alpha, childBest);
+        undoMove(state, attacks, move, undo);
+        if (stopped) {
+            return 0;
+        }
+        if (score > bestScore) {
+            bestScore = score;
+            if (score > alpha) {
+                alpha = score;
+                best = move;
+                if (alpha >= beta) {
+                    break;
+                }
+            }
+        }
+    }
+
+    if (legal == 0) {
+        return attacks.isInCheck(mover) ? -kMateScore + ply : 0;
+    }
+    return bestScore;
+}
+
+int Search::quiesce(GameState& state, AttackMap& attacks, int ply, int alpha, int beta) {
+    if (++nodes >= nodeLimit) {
+        stopped = true;
+        return 0;
+    }
+    int standPat = evaluate(state);
+    if (ply >= kMaxPly - 1 || standPat >= beta) {
+        return standPat;
+    }
+    alpha = std::max(alpha, standPat);
+
+    Ply& data = plies[ply];
+    generator.generate(state, data.moves);
+    scoreMoves(state, data, EngineMove{});
+
+    UndoInfo undo;
+    for (int i = 0; i < data.moves.count; ++i) {
+        EngineMove move = pickNext(data, i);
+        if (!isCapture(state, move)) {
+            break; // Captures are ordered first
+        }
+        if (!tryMove(state, attacks, move, undo)) {
+            continue;
+        }
+        int score = -quiesce(state, attacks, ply + 1, -beta, -alpha);
+        undoMove(state, attacks, move, undo);
+        if (stopped) {
+            return 0;
+        }
+        if (score > alpha) {
+            alpha = score;
+            if (alpha >= beta) {
+                break;
+            }
+        }
+    }
+    return alpha;
+}
+
+bool Search::isCapture(const GameState& state, const EngineMove& move) const {
+    if (move.special() == EngineMove::kEnPassant) {
+        return true;
+    }
+    return move.special() != EngineMove::kCastle && state.squares[move.to] != kEmptySquare;
+}
+
+// `first` goes first, then captures by most valuable victim and least
+// valuable attacker, then promotions, then quiet moves
+void Search::scoreMoves(const GameState& state, Ply& data, const EngineMove& first) const {
+    for (int i = 0; i < data.moves.count; ++i) {
+        const EngineMove& move = data.moves.moves[i];
+        int score = 0;
+        if (move == first) {
+            score = 1 << 30;
+        } else if (isCapture(state, move)) {
+            std::uint8_t victim = state.squares[move.special() == EngineMove::kEnPassant
+                                                    ? generator.getCapturedSquare(move) : move.to];
+            int attacker = pieceValues[pieceKind(state.squares[move.from])];
+            score = (1 << 24) + pieceValues[pieceKind(victim)] * 64 - attacker;
+        } else if (move.isPromotion()) {
+            score = (1 << 20) + pieceValues[move.promotionKind()];
+        }
+        data.scores[i] = score;
+    }
+}
+
+const EngineMove& Search::pickNext(Ply& data, int index) {
+    int bestIndex = index;
+    for (int i = index + 1; i < data.moves.count; ++i) {
+        if (data.scores[i] > data.scores[bestIndex]) {
+            bestIndex = i;
+        }
+    }
+    std::swap(data.moves.moves[index], data.moves.moves[bestIndex]);
+    std::swap(data.scores[index], data.scores[bestIndex]);
+    return data.moves.moves[index];
+}
+
+bool Search::tryMove(GameState& state, AttackMap& attacks, const EngineMove& move, UndoInfo& undo) {
+    // Castling has conditions before the move too
+    if (move.special() == EngineMove::kCastle && !generator.isLegal(state, attacks, move)) {
+        return false;
+    }
+    Color mover = state.sideToMove;
+    int changed[4];
+    int changedCount = generator.getChangedSquares(move, changed);
+    generator.makeMove(state, move, undo);
+    attacks.update(state, changed, changedCount);
+    if (attacks.isInCheck(mover)) {
+        generator.unmakeMove(state, move, undo);
+        attacks.update(state, changed, changedCount);
+        return false;
+    }
+    return true;
+}
+
+void Search::undoMove(GameState& state, AttackMap& attacks, const EngineMove& move, const UndoInfo& undo) {
+    int changed[4];
+    int changedCount = generator.getChangedSquares(move, changed);
+    generator.unmakeMove(state, move, undo);
+    attacks.update(state, changed, changedCount);
+}
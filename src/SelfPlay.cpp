@@ -0,0 +1,227 @@
+#include "../include/SelfPlay.hpp"
+#include "../include/GameRecord.hpp"
+#include "../include/OpeningBook.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <random>
+
+namespace {
+    constexpr char kMagic[4] = {'S', 'P', 'L', 'G'};
+    constexpr long kCountOffset = 16;
+    constexpr std::size_t kMctsNodes = 1 << 18;
+
+    GameResult toGameResult(SelfPlayOutcome outcome) {
+        switch (outcome) {
+        case SelfPlayOutcome::WhiteWin:
+            return GameResult::WhiteWin;
+        case SelfPlayOutcome::BlackWin:
+            return GameResult::BlackWin;
+        default:
+            return GameResult::Draw;
+        }
+    }
+
+    template <typename T>
+    bool writeValue(std::FILE* file, const T& value) {
+        return std::fwrite(&value, sizeof(T), 1, file) == 1;
+    }
+
+    template <typename T>
+    bool readValue(std::FILE* file, T& value) {
+        return std::fread(&value, sizeof(T), 1, file) == 1;
+    }
+}
+
+SelfPlayLog::~SelfPlayLog() {
+    close();
+}
+
+bool SelfPlayLog::create(const std::string& path, std::uint64_t configHash) {
+    close();
+    file = std::fopen(path.c_str(), "wb");
+    if (!file) {
+        std::cerr << "Failed to create self-play log: " << path << std::endl;
+        return false;
+    }
+    count = 0;
+    failed = !(std::fwrite(kMagic, 1, 4, file) == 4 && writeValue(file, kVersion) &&
+               writeValue(file, configHash) && writeValue(file, count));
+    return !failed;
+}
+
+bool SelfPlayLog::write(const SelfPlayGame& game) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!file) {
+        return false;
+    }
+    auto plies = static_cast<std::uint16_t>(std::min<std::size_t>(game.moves.size(), UINT16_MAX));
+    bool ok = writeValue(file, game.index) && writeValue(file, plies) && writeValue(file, game.outcome) &&
+              std::fwrite(game.moves.data(), sizeof(std::uint32_t), plies, file) == plies;
+    failed = failed || !ok;
+    count++;
+    return ok;
+}
+
+bool SelfPlayLog::close() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!file) {
+        return !failed;
+    }
+    bool ok = !failed && std::fseek(file, kCountOffset, SEEK_SET) == 0 && writeValue(file, count);
+    ok = std::fclose(file) == 0 && ok;
+    file = nullptr;
+    failed = !ok;
+    return ok;
+}
+
+bool SelfPlayLog::read(const std::string& path, std::uint64_t& configHash, std::vector<SelfPlayGame>& games) {
+    std::unique_ptr<std::FILE, int (*)(std::FILE*)> file(std::fopen(path.c_str(), "rb"), std::fclose);
+    if (!file) {
+        std::cerr << "Failed to open self-play log: " << path << std::endl;
+        return false;
+    }
+    char magic[4];
+    std::uint32_t version = 0;
+    std::uint32_t count = 0;
+    if (std::fread(magic, 1, 4, file.get()) != 4 || std::memcmp(magic, kMagic, 4) != 0 ||
+        !readValue(file.get(), version) || !readValue(file.get(), configHash) || !readValue(file.get(), count)) {
+        std::cerr << "Not a self-play log: " << path << std::endl;
+        return false;
+    }
+    if (version != kVersion) {
+        std::cerr << "Unsupported self-play log version " << version << ": " << path << std::endl;
+        return false;
+    }
+
+    games.clear();
+    games.resize(count);
+    for (auto& game : games) {
+        std::uint16_t plies = 0;
+        if (!readValue(file.get(), game.index) || !readValue(file.get(), plies) ||
+            !readValue(file.get(), game.outcome) || game.outcome > SelfPlayOutcome::TurnLimit) {
+            std::cerr << "Truncated self-play log: " << path << std::endl;
+            return false;
+        }
+        game.moves.resize(plies);
+        if (std::fread(game.moves.data(), sizeof(std::uint32_t), plies, file.get()) != plies) {
+            std::cerr << "Truncated self-play log: " << path << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+SelfPlayRunner::SelfPlayRunner(std::shared_ptr<const CompiledConfig> variant, unsigned threads)
+    : variant(std::move(variant)), pool(threads) {
+    for (unsigned i = 0; i < pool.getThreadCount(); ++i) {
+        workers.push_back(std::make_unique<Worker>(*this->variant->rules));
+    }
+}
+
+SelfPlayReport SelfPlayRunner::run(const SelfPlayOptions& options, SelfPlayLog* log, GameRecordWriter* archive) {
+    SelfPlayReport report;
+    for (auto& worker : workers) {
+        worker->stats = SelfPlayWorkerStats{};
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    pool.parallelFor(static_cast<std::size_t>(std::max(options.games, 0)), [&](unsigned workerIndex, std::size_t index) {
+        Worker& worker = *workers[workerIndex];
+        auto gameStart = std::chrono::steady_clock::now();
+        playGame(worker, options, static_cast<std::uint32_t>(index));
+        worker.stats.seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - gameStart).count();
+        if (log) {
+            log->write(worker.game);
+        }
+        if (archive) {
+            archive->write(toGameResult(worker.game.outcome), worker.game.moves);
+        }
+    });
+    report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    for (const auto& worker : workers) {
+        report.workers.push_back(worker->stats);
+        report.games += worker->stats.games;
+        report.plies += worker->stats.plies;
+        report.nodes += worker->stats.nodes;
+        report.bookMoves += worker->stats.bookMoves;
+        for (int outcome = 0; outcome < 4; ++outcome) {
+            report.outcomes[outcome] += worker->stats.outcomes[outcome];
+        }
+    }
+    return report;
+}
+
+void SelfPlayRunner::playGame(Worker& worker, const SelfPlayOptions& options, std::uint32_t index) {
+    const RuleSet& rules = *variant->rules;
+    int maxPlies = options.maxPlies > 0 ? options.maxPlies : (rules.turnLimit > 0 ? rules.turnLimit : 500);
+    maxPlies = std::min(maxPlies, static_cast<int>(UINT16_MAX));
+    std::mt19937_64 rng(options.seed + index);
+    if (options.engine == SelfPlayEngine::Mcts) {
+        if (!worker.mcts) {
+            worker.mcts = std::make_unique<Mcts>(rules, 1, kMctsNodes);
+        }
+        worker.mcts->seed(options.seed + index);
+    }
+    worker.search.setTablebases(options.tablebases);
+
+    SelfPlayGame& game = worker.game;
+    game.index = index;
+    game.moves.clear();
+    GameState& state = worker.state;
+    state.reset(rules);
+    worker.attacks.build(state);
+
+    game.outcome = SelfPlayOutcome::TurnLimit;
+    bool inBook = options.book != nullptr;
+    while (static_cast<int>(game.moves.size()) < maxPlies) {
+        EngineMove move{};
+        bool randomPly = static_cast<int>(game.moves.size()) < options.randomPlies;
+        // The book is followed from the end of the random plies until it
+        // has no move for the position
+        if (inBook && !randomPly) {
+            inBook = options.book->probe(state, worker.attacks, worker.generator, move, rng());
+        }
+        if (randomPly) {
+            worker.generator.generateLegal(state, worker.attacks, worker.moves);
+            if (worker.moves.count > 0) {
+                move = worker.moves.moves[rng() % worker.moves.count];
+            }
+        } else if (inBook) {
+            worker.stats.bookMoves++;
+        } else if (options.engine == SelfPlayEngine::Mcts) {
+            MctsResult result = worker.mcts->think(state, options.mcts);
+            worker.stats.nodes += result.playouts;
+            move = result.move;
+        } else {
+            SearchResult result = worker.search.think(state, worker.attacks, options.limits);
+            worker.stats.nodes += result.nodes;
+            move = result.move;
+        }
+
+        if (move.pack() == 0) {
+            break; // No legal move
+        }
+
+        int changed[4];
+        int changedCount = worker.generator.getChangedSquares(move, changed);
+        worker.generator.makeMove(state, move);
+        worker.attacks.update(state, changed, changedCount);
+        game.moves.push_back(move.pack());
+    }
+
+    // Like GameManager, a mate on the last move counts over the turn limit
+    if (!worker.generator.hasLegalMove(state, worker.attacks)) {
+        if (!worker.attacks.isInCheck(state.sideToMove)) {
+            game.outcome = SelfPlayOutcome::Stalemate;
+        } else {
+            game.outcome = state.sideToMove == Color::WHITE ? SelfPlayOutcome::BlackWin : SelfPlayOutcome::WhiteWin;
+        }
+    }
+
+    worker.stats.games++;
+    worker.stats.outcomes[static_cast<int>(game.outcome)]++;
+    worker.stats.plies += game.moves.size();
+}
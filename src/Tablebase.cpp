@@ -0,0 +1,564 @@
+#include "../include/Tablebase.hpp"
+#include "../include/BlockCodec.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+    constexpr std::uint32_t kByteOrderMark = 0x01020304;
+
+    // Compressed tables reuse the header: wdlOffset is the block index and
+    // dtmOffset the first block
+    struct TablebaseHeader {
+        char magic[8];
+        std::uint32_t version;
+        std::uint32_t byteOrder;
+        std::uint64_t rulesKey;
+        std::uint64_t positionCount;
+        std::uint64_t wdlOffset;
+        std::uint64_t dtmOffset;
+        std::uint64_t fileSize;
+        std::uint32_t pieceCount;
+        std::uint32_t maxDtm;
+        std::uint8_t codes[kMaxTablebasePieces];
+        std::uint8_t reserved[3];
+    };
+
+    TablebaseHeader makeHeader(const char (&magic)[8], const RuleSet& rules, const TablebaseMaterial& material,
+                               std::uint64_t positionCount, int maxDtm) {
+        TablebaseHeader header{};
+        std::memcpy(header.magic, magic, sizeof(header.magic));
+        header.version = Tablebase::kVersion;
+        header.byteOrder = kByteOrderMark;
+        header.rulesKey = rules.movementKey();
+        header.positionCount = positionCount;
+        header.pieceCount = static_cast<std::uint32_t>(material.count);
+        header.maxDtm = static_cast<std::uint32_t>(maxDtm);
+        std::memcpy(header.codes, material.codes, sizeof(header.codes));
+        return header;
+    }
+
+    TablebaseProbe decodeValue(std::uint8_t value) {
+        TablebaseProbe probe;
+        if (value == Tablebase::kInvalidValue) {
+            probe.wdl = Wdl::Invalid;
+        } else if (value != Tablebase::kDrawValue) {
+            probe.dtm = value - 1;
+            probe.wdl = probe.dtm % 2 == 1 ? Wdl::Win : Wdl::Loss;
+        }
+        return probe;
+    }
+
+    // Decompressed blocks of compressed tables, per thread. Entries are
+    // tagged with the table's id rather than its address, so a table freed
+    // and another mapped in its place never sees stale blocks.
+    struct BlockCache {
+        static constexpr int kEntries = 32;
+
+        struct Entry {
+            std::uint64_t table = 0;
+            std::uint64_t block = 0;
+            std::uint64_t lastUse = 0;
+            std::unique_ptr<std::uint8_t[]> values;
+        };
+
+        Entry entries[kEntries];
+        std::uint64_t clock = 0;
+        TablebaseCacheStats stats;
+    };
+
+    BlockCache& blockCache() {
+        thread_local BlockCache cache;
+        return cache;
+    }
+
+    std::atomic<std::uint64_t> nextTableId{1};
+
+    std::uint64_t wdlBytes(std::uint64_t positionCount) {
+        return (positionCount + 3) / 4;
+    }
+
+    std::uint64_t alignUp(std::uint64_t value, std::uint64_t alignment) {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+
+    // Sort up to kMaxTablebasePieces (code, square) pairs by code, keeping
+    // identical pieces in square order
+    void sortPieces(std::uint8_t* codes, std::uint8_t* squares, int count) {
+        for (int i = 1; i < count; ++i) {
+            for (int j = i; j > 0 && codes[j - 1] > codes[j]; --j) {
+                std::swap(codes[j - 1], codes[j]);
+                std::swap(squares[j - 1], squares[j]);
+            }
+        }
+    }
+}
+
+bool TablebaseMaterial::parse(const RuleSet& rules, std::string_view text) {
+    count = 0;
+    Color color = Color::WHITE;
+    bool sawSeparator = false;
+    for (char letter : text) {
+        if (letter == 'v' && !sawSeparator) {
+            sawSeparator = true;
+            color = Color::BLACK;
+            continue;
+        }
+        int kind = 0;
+        while (kind < rules.kindCount && rules.kinds[kind].letter != letter) {
+            ++kind;
+        }
+        if (kind == rules.kindCount) {
+            std::cerr << "Unknown piece letter '" << letter << "' in " << text << std::endl;
+            return false;
+        }
+        if (count == kMaxTablebasePieces) {
+            std::cerr << "Too many pieces in " << text << " (at most " << kMaxTablebasePieces << ")" << std::endl;
+            return false;
+        }
+        codes[count++] = makePieceCode(kind, color);
+    }
+    if (!sawSeparator || count == 0) {
+        std::cerr << "Material must look like KRvK: " << text << std::endl;
+        return false;
+    }
+    std::sort(codes, codes + count);
+    return true;
+}
+
+std::string TablebaseMaterial::toString(const RuleSet& rules) const {
+    std::string text;
+    for (Color color : {Color::WHITE, Color::BLACK}) {
+        if (color == Color::BLACK) {
+            text += 'v';
+        }
+        for (int i = 0; i < count; ++i) {
+            if (pieceColor(codes[i]) == color) {
+                text += rules.kinds[pieceKind(codes[i])].letter;
+            }
+        }
+    }
+    return text;
+}
+
+bool TablebaseMaterial::read(const RuleSet& rules, const GameState& state) {
+    count = 0;
+    for (int square = 0; square < rules.squareCount; ++square) {
+        if (state.squares[square] != kEmptySquare) {
+            if (count == kMaxTablebasePieces) {
+                return false;
+            }
+            codes[count++] = state.squares[square];
+        }
+    }
+    std::sort(codes, codes + count);
+    return true;
+}
+
+std::uint64_t TablebaseMaterial::key() const {
+    std::uint64_t result = static_cast<std::uint64_t>(count);
+    for (int i = 0; i < count; ++i) {
+        result = (result << 7) | codes[i];
+    }
+    return result;
+}
+
+TablebaseIndexer::TablebaseIndexer(const RuleSet& rules, const TablebaseMaterial& material)
+    : rules(rules), material(material) {
+    // Eleven portals with long cooldowns already overflow 64 bits; such a
+    // count saturates, so that it is refused as too large
+    bool overflow = false;
+    for (int portal = 0; portal < rules.portalCount; ++portal) {
+        if (rules.portals[portal].cooldown > 0) {
+            cooldownPortals[cooldownPortalCount++] = portal;
+            overflow |= __builtin_mul_overflow(cooldownStates, rules.portals[portal].cooldown + 1u, &cooldownStates);
+        }
+    }
+    overflow |= __builtin_mul_overflow(cooldownStates, 2u, &positionCount);
+    for (int i = 0; i < material.count; ++i) {
+        overflow |= __builtin_mul_overflow(positionCount, static_cast<std::uint64_t>(rules.squareCount),
+                                           &positionCount);
+    }
+    if (overflow) {
+        positionCount = UINT64_MAX;
+    }
+}
+
+std::uint64_t TablebaseIndexer::index(const GameState& state) const {
+    std::uint8_t codes[kMaxTablebasePieces];
+    std::uint8_t squares[kMaxTablebasePieces];
+    int count = 0;
+    for (int square = 0; square < rules.squareCount && count < material.count; ++square) {
+        if (state.squares[square] != kEmptySquare) {
+            codes[count] = state.squares[square];
+            squares[count++] = static_cast<std::uint8_t>(square);
+        }
+    }
+    sortPieces(codes, squares, count);
+
+    std::uint64_t result = 0;
+    for (int i = 0; i < count; ++i) {
+        result = result * static_cast<std::uint64_t>(rules.squareCount) + squares[i];
+    }
+    std::uint64_t cooldown = 0;
+    for (int i = 0; i < cooldownPortalCount; ++i) {
+        int portal = cooldownPortals[i];
+        cooldown = cooldown * (rules.portals[portal].cooldown + 1u) + state.cooldowns[portal];
+    }
+    return (result * cooldownStates + cooldown) * 2 + (state.sideToMove == Color::BLACK ? 1 : 0);
+}
+
+bool TablebaseIndexer::decode(std::uint64_t index, GameState& state) const {
+    std::memset(state.squares, kEmptySquare, sizeof(state.squares));
+    std::memset(state.unmoved, 0, sizeof(state.unmoved));
+    std::memset(state.cooldowns, 0, sizeof(state.cooldowns));
+    state.hash = 0;
+    state.ply = 0;
+    state.epSquare = kNoSquare;
+    state.sideToMove = (index & 1) ? Color::BLACK : Color::WHITE;
+    index >>= 1;
+
+    std::uint64_t cooldown = index % cooldownStates;
+    index /= cooldownStates;
+    for (int i = cooldownPortalCount - 1; i >= 0; --i) {
+        int portal = cooldownPortals[i];
+        std::uint64_t radix = rules.portals[portal].cooldown + 1u;
+        state.cooldowns[portal] = static_cast<std::uint8_t>(cooldown % radix);
+        cooldown /= radix;
+    }
+
+    int previousSquare = -1;
+    for (int i = material.count - 1; i >= 0; --i) {
+        int square = static_cast<int>(index % static_cast<std::uint64_t>(rules.squareCount));
+        index /= static_cast<std::uint64_t>(rules.squareCount);
+        std::uint8_t code = material.codes[i];
+        if (state.squares[square] != kEmptySquare) {
+            return false;
+        }
+        // Identical pieces ascend; walking backwards each must be below the next
+        if (i + 1 < material.count && material.codes[i + 1] == code && square >= previousSquare) {
+            return false;
+        }
+        const PieceRules& kind = rules.kinds[pieceKind(code)];
+        if (kind.has(PieceRules::kPromotion) && rules.rankOf(square) == rules.promotionRank(pieceColor(code))) {
+            return false;
+        }
+        state.squares[square] = code;
+        previousSquare = square;
+    }
+    return true;
+}
+
+bool TablebaseIndexer::hasHiddenState(const RuleSet& rules, const GameState& state) {
+    if (state.epSquare != kNoSquare) {
+        return true;
+    }
+    for (int square = 0; square < rules.squareCount; ++square) {
+        if (state.squares[square] == kEmptySquare || !state.isUnmoved(square)) {
+            continue;
+        }
+        const PieceRules& kind = rules.kinds[pieceKind(state.squares[square])];
+        if (kind.has(PieceRules::kCastling)) {
+            return true;
+        }
+        for (int r = 0; r < kind.rayCount; ++r) {
+            if (kind.rays[r].firstRange != kind.rays[r].range) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+Tablebase::Tablebase(const RuleSet& rules, const TablebaseMaterial& material, const std::uint8_t* data,
+                     std::size_t size)
+    : indexer(rules, material), data(data), size(size), id(nextTableId.fetch_add(1, std::memory_order_relaxed)) {}
+
+Tablebase::~Tablebase() {
+    if (data) {
+        munmap(const_cast<std::uint8_t*>(data), size);
+    }
+}
+
+bool Tablebase::write(const std::string& path, const RuleSet& rules, const TablebaseMaterial& material,
+                      std::uint64_t positionCount, const std::uint8_t* values, int maxDtm, TablebaseFormat format) {
+    std::string tempPath = path + ".tmp";
+    {
+        std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            std::cerr << "Failed to create tablebase: " << tempPath << std::endl;
+            return false;
+        }
+        bool written = format == TablebaseFormat::Compressed
+                           ? writeCompressed(file, rules, material, positionCount, values, maxDtm)
+                           : writePlain(file, rules, material, positionCount, values, maxDtm);
+        if (!written || !file.flush()) {
+            std::cerr << "Failed to write tablebase: " << tempPath << std::endl;
+            file.close();
+            std::remove(tempPath.c_str());
+            return false;
+        }
+    }
+    if (std::rename(tempPath.c_str(), path.c_str()) != 0) {
+        std::cerr << "Failed to move tablebase into place: " << path << std::endl;
+        std::remove(tempPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool Tablebase::writePlain(std::ofstream& file, const RuleSet& rules, const TablebaseMaterial& material,
+                           std::uint64_t positionCount, const std::uint8_t* values, int maxDtm) {
+    TablebaseHeader header = makeHeader(kMagic, rules, material, positionCount, maxDtm);
+    header.wdlOffset = sizeof(TablebaseHeader);
+    header.dtmOffset = alignUp(header.wdlOffset + wdlBytes(positionCount), 8);
+    header.fileSize = header.dtmOffset + positionCount;
+
+    std::vector<std::uint8_t> wdl(wdlBytes(positionCount), 0);
+    std::vector<std::uint8_t> dtm(positionCount, 0);
+    for (std::uint64_t index = 0; index < positionCount; ++index) {
+        TablebaseProbe probe = decodeValue(values[index]);
+        wdl[index >> 2] |= static_cast<std::uint8_t>(static_cast<int>(probe.wdl) << ((index & 3) * 2));
+        dtm[index] = static_cast<std::uint8_t>(probe.dtm);
+    }
+
+    static const char padding[8] = {};
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(wdl.data()), static_cast<std::streamsize>(wdl.size()));
+    file.write(padding, static_cast<std::streamsize>(header.dtmOffset - header.wdlOffset - wdl.size()));
+    file.write(reinterpret_cast<const char*>(dtm.data()), static_cast<std::streamsize>(dtm.size()));
+    return file.good();
+}
+
+bool Tablebase::writeCompressed(std::ofstream& file, const RuleSet& rules, const TablebaseMaterial& material,
+                                std::uint64_t positionCount, const std::uint8_t* values, int maxDtm) {
+    std::uint64_t blockCount = (positionCount + kBlockPositions - 1) / kBlockPositions;
+    TablebaseHeader header = makeHeader(kCompressedMagic, rules, material, positionCount, maxDtm);
+    header.wdlOffset = sizeof(TablebaseHeader);                              // Block index
+    header.dtmOffset = header.wdlOffset + (blockCount + 1) * sizeof(std::uint64_t);   // First block
+
+    // Blocks are compressed one at a time and streamed after the index,
+    // which is filled in once their sizes are known
+    std::vector<std::uint64_t> blockIndex(blockCount + 1);
+    std::vector<std::uint8_t> compressed;
+    file.seekp(static_cast<std::streamoff>(header.dtmOffset));
+    std::uint64_t offset = header.dtmOffset;
+    for (std::uint64_t block = 0; block < blockCount; ++block) {
+        std::uint64_t first = block * kBlockPositions;
+        std::uint64_t count = std::min<std::uint64_t>(kBlockPositions, positionCount - first);
+        compressed.clear();
+        BlockCodec::compress(values + first, static_cast<std::size_t>(count), compressed);
+        file.write(reinterpret_cast<const char*>(compressed.data()), static_cast<std::streamsize>(compressed.size()));
+        blockIndex[block] = offset;
+        offset += compressed.size();
+    }
+    blockIndex[blockCount] = offset;
+    header.fileSize = offset;
+
+    file.seekp(0);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(blockIndex.data()),
+               static_cast<std::streamsize>(blockIndex.size() * sizeof(std::uint64_t)));
+    return file.good();
+}
+
+const char* Tablebase::extension(TablebaseFormat format) {
+    return format == TablebaseFormat::Compressed ? kCompressedExtension : kExtension;
+}
+
+std::shared_ptr<const Tablebase> Tablebase::open(const std::string& path, const RuleSet& rules) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        std::cerr << "Failed to open tablebase: " << path << std::endl;
+        return nullptr;
+    }
+    struct stat info {};
+    if (fstat(fd, &info) != 0 || static_cast<std::size_t>(info.st_size) < sizeof(TablebaseHeader)) {
+        std::cerr << "Tablebase is truncated: " << path << std::endl;
+        ::close(fd);
+        return nullptr;
+    }
+    std::size_t size = static_cast<std::size_t>(info.st_size);
+    void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        std::cerr << "Failed to map tablebase: " << path << std::endl;
+        return nullptr;
+    }
+
+    const auto* bytes = static_cast<const std::uint8_t*>(mapping);
+    const auto& header = *reinterpret_cast<const TablebaseHeader*>(bytes);
+    TablebaseMaterial material;
+    material.count = static_cast<int>(std::min<std::uint32_t>(header.pieceCount, kMaxTablebasePieces));
+    std::memcpy(material.codes, header.codes, sizeof(material.codes));
+
+    // Owns the mapping from here on, so every early return unmaps it
+    std::unique_ptr<Tablebase> table(new Tablebase(rules, material, bytes, size));
+    bool compressed = std::memcmp(header.magic, kCompressedMagic, sizeof(kCompressedMagic)) == 0;
+    if (!compressed && std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0) {
+        std::cerr << "Not a tablebase: " << path << std::endl;
+        return nullptr;
+    }
+    if (header.version != kVersion || header.byteOrder != kByteOrderMark) {
+        std::cerr << "Tablebase was built by another version, generate it again: " << path << std::endl;
+        return nullptr;
+    }
+    if (header.rulesKey != rules.movementKey()) {
+        std::cerr << "Tablebase was built for other rules: " << path << std::endl;
+        return nullptr;
+    }
+    if (table->indexer.size() > kMaxTablebasePositions) {
+        std::cerr << "Tablebase material has too many positions under these rules: " << path << std::endl;
+        return nullptr;
+    }
+    if (header.fileSize != size || header.pieceCount != static_cast<std::uint32_t>(material.count) ||
+        header.positionCount != table->indexer.size()) {
+        std::cerr << "Tablebase is truncated or corrupt: " << path << std::endl;
+        return nullptr;
+    }
+    table->maxDtm = static_cast<int>(header.maxDtm);
+    return compressed ? openCompressed(std::move(table), path, rules) : openPlain(std::move(table), path, rules);
+}
+
+std::shared_ptr<const Tablebase> Tablebase::openPlain(std::unique_ptr<Tablebase> table, const std::string& path,
+                                                      const RuleSet&) {
+    const auto& header = *reinterpret_cast<const TablebaseHeader*>(table->data);
+    if (header.wdlOffset < sizeof(TablebaseHeader) ||
+        header.wdlOffset + wdlBytes(header.positionCount) > header.dtmOffset ||
+        header.dtmOffset + header.positionCount > table->size) {
+        std::cerr << "Tablebase is truncated or corrupt: " << path << std::endl;
+        return nullptr;
+    }
+    table->wdl = table->data + header.wdlOffset;
+    table->dtm = table->data + header.dtmOffset;
+    return table;
+}
+
+std::shared_ptr<const Tablebase> Tablebase::openCompressed(std::unique_ptr<Tablebase> table,
+                                                           const std::string& path, const RuleSet&) {
+    const auto& header = *reinterpret_cast<const TablebaseHeader*>(table->data);
+    std::uint64_t blockCount = (header.positionCount + kBlockPositions - 1) / kBlockPositions;
+    bool valid = header.wdlOffset == sizeof(TablebaseHeader) &&
+                 header.dtmOffset == header.wdlOffset + (blockCount + 1) * sizeof(std::uint64_t) &&
+                 header.dtmOffset <= table->size;
+    // Only the index is checked here; blocks are checked as they decompress
+    const auto* blockIndex = reinterpret_cast<const std::uint64_t*>(table->data + header.wdlOffset);
+    for (std::uint64_t block = 0; valid && block < blockCount; ++block) {
+        valid = blockIndex[block] >= header.dtmOffset && blockIndex[block] <= blockIndex[block + 1];
+    }
+    if (!valid || blockIndex[blockCount] != table->size) {
+        std::cerr << "Tablebase is truncated or corrupt: " << path << std::endl;
+        return nullptr;
+    }
+    table->blockIndex = blockIndex;
+    table->blockCount = blockCount;
+    return table;
+}
+
+TablebaseProbe Tablebase::probe(const GameState& state) const {
+    std::uint64_t index = indexer.index(state);
+    if (blockIndex) {
+        const std::uint8_t* values = loadBlock(index / kBlockPositions);
+        if (!values) {
+            TablebaseProbe result;
+            result.wdl = Wdl::Invalid;
+            return result;
+        }
+        return decodeValue(values[index % kBlockPositions]);
+    }
+    TablebaseProbe result;
+    result.wdl = static_cast<Wdl>((wdl[index >> 2] >> ((index & 3) * 2)) & 3);
+    result.dtm = dtm[index];
+    return result;
+}
+
+const std::uint8_t* Tablebase::loadBlock(std::uint64_t block) const {
+    BlockCache& cache = blockCache();
+    cache.clock++;
+    BlockCache::Entry* oldest = &cache.entries[0];
+    for (auto& entry : cache.entries) {
+        if (entry.table == id && entry.block == block) {
+            entry.lastUse = cache.clock;
+            cache.stats.hits++;
+            return entry.values.get();
+        }
+        if (entry.lastUse < oldest->lastUse) {
+            oldest = &entry;
+        }
+    }
+
+    cache.stats.misses++;
+    if (!oldest->values) {
+        oldest->values = std::make_unique<std::uint8_t[]>(kBlockPositions);
+    }
+    std::uint64_t first = block * kBlockPositions;
+    std::size_t count = static_cast<std::size_t>(std::min<std::uint64_t>(kBlockPositions, indexer.size() - first));
+    std::uint64_t begin = blockIndex[block];
+    std::uint64_t end = blockIndex[block + 1];
+    if (end > size || !BlockCodec::decompress(data + begin, static_cast<std::size_t>(end - begin),
+                                              oldest->values.get(), count)) {
+        oldest->table = 0;
+        oldest->lastUse = 0;
+        return nullptr;
+    }
+    oldest->table = id;
+    oldest->block = block;
+    oldest->lastUse = cache.clock;
+    return oldest->values.get();
+}
+
+TablebaseCacheStats Tablebase::getCacheStats() {
+    return blockCache().stats;
+}
+
+int TablebaseSet::loadDirectory(const std::string& directory) {
+    std::vector<std::string> paths;
+    std::error_code error;
+    for (const auto& entry : std::filesystem::directory_iterator(directory, error)) {
+        auto extension = entry.path().extension();
+        if (entry.is_regular_file() &&
+            (extension == Tablebase::kExtension || extension == Tablebase::kCompressedExtension)) {
+            paths.push_back(entry.path().string());
+        }
+    }
+    if (error) {
+        std::cerr << "Failed to read directory " << directory << ": " << error.message() << std::endl;
+    }
+    std::sort(paths.begin(), paths.end());
+
+    int loaded = 0;
+    for (const auto& path : paths) {
+        if (auto table = Tablebase::open(path, rules)) {
+            add(std::move(table));
+            ++loaded;
+        }
+    }
+    return loaded;
+}
+
+void TablebaseSet::add(std::shared_ptr<const Tablebase> table) {
+    maxPieces = std::max(maxPieces, table->getMaterial().count);
+    tables[table->getMaterial().key()] = std::move(table);
+}
+
+bool TablebaseSet::probe(const GameState& state, TablebaseProbe& result) const {
+    TablebaseMaterial material;
+    if (tables.empty() || !material.read(rules, state) || TablebaseIndexer::hasHiddenState(rules, state)) {
+        return false;
+    }
+    auto found = tables.find(material.key());
+    if (found == tables.end()) {
+        return false;
+    }
+    result = found->second->probe(state);
+    return result.wdl != Wdl::Invalid;
+}
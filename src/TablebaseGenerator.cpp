@@ -0,0 +1,291 @@
+#include "../include/TablebaseGenerator.hpp"
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+
+namespace {
+    // Working values, one byte per position: dtm + 1 once decided (odd dtm
+    // wins for the side to move, even dtm loses), else one of these
+    constexpr std::uint8_t kUnknown = 0;
+    constexpr std::uint8_t kDraw = 254;
+    constexpr std::uint8_t kInvalid = 255;
+    constexpr int kMaxDtm = 252;
+    constexpr int kIllegal = -2;
+    constexpr std::uint64_t kChunkSize = 1 << 14;
+
+    struct SubTable {
+        std::uint64_t key;
+        const Tablebase* table;
+    };
+}
+
+TablebaseGenerator::TablebaseGenerator(const RuleSet& rules, unsigned threads, TablebaseFormat format)
+    : rules(rules), format(format), generator(rules), pool(threads) {
+    for (unsigned i = 0; i < pool.getThreadCount(); ++i) {
+        workers.push_back(std::make_unique<Worker>(rules));
+    }
+}
+
+bool TablebaseGenerator::generate(const TablebaseMaterial& material, const std::string& directory) {
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+    if (error) {
+        std::cerr << "Failed to create directory " << directory << ": " << error.message() << std::endl;
+        return false;
+    }
+    return solve(material, directory);
+}
+
+std::vector<TablebaseMaterial> TablebaseGenerator::successors(const TablebaseMaterial& material) const {
+    std::vector<TablebaseMaterial> result;
+    auto add = [&](TablebaseMaterial next) {
+        std::sort(next.codes, next.codes + next.count);
+        for (const auto& existing : result) {
+            if (existing.key() == next.key()) return;
+        }
+        result.push_back(next);
+    };
+    auto without = [](const TablebaseMaterial& from, int index) {
+        TablebaseMaterial next = from;
+        std::copy(next.codes + index + 1, next.codes + next.count, next.codes + index);
+        next.count--;
+        return next;
+    };
+    // Royal pieces are only captured when their side has another one
+    auto capturable = [&](int index) {
+        if (!rules.kinds[pieceKind(material.codes[index])].has(PieceRules::kRoyal)) {
+            return true;
+        }
+        int royals = 0;
+        for (int i = 0; i < material.count; ++i) {
+            if (pieceColor(material.codes[i]) == pieceColor(material.codes[index]) &&
+                rules.kinds[pieceKind(material.codes[i])].has(PieceRules::kRoyal)) {
+                ++royals;
+            }
+        }
+        return royals > 1;
+    };
+
+    for (int i = 0; i < material.count; ++i) {
+        if (capturable(i)) {
+            add(without(material, i));
+        }
+    }
+    for (int j = 0; j < material.count; ++j) {
+        if (!rules.kinds[pieceKind(material.codes[j])].has(PieceRules::kPromotion)) {
+            continue;
+        }
+        Color color = pieceColor(material.codes[j]);
+        for (int p = 0; p < rules.promotionCount; ++p) {
+            TablebaseMaterial promoted = material;
+            promoted.codes[j] = makePieceCode(rules.promotionKinds[p], color);
+            add(promoted);
+            // Promoting with a capture
+            for (int i = 0; i < material.count; ++i) {
+                if (pieceColor(material.codes[i]) != color && capturable(i)) {
+                    add(without(promoted, i));
+                }
+            }
+        }
+    }
+    return result;
+}
+
+bool TablebaseGenerator::solve(const TablebaseMaterial& material, const std::string& directory) {
+    if (solved.count(material.key())) {
+        return true;
+    }
+    std::vector<TablebaseMaterial> next = successors(material);
+    for (const auto& smaller : next) {
+        if (!solve(smaller, directory)) {
+            return false;
+        }
+    }
+
+    TablebaseStats tableStats;
+    tableStats.material = material.toString(rules);
+    // A table already solved in either format is reused
+    std::filesystem::path base = std::filesystem::path(directory) / tableStats.material;
+    for (TablebaseFormat existing : {format, format == TablebaseFormat::Plain ? TablebaseFormat::Compressed
+                                                                               : TablebaseFormat::Plain}) {
+        std::string existingPath = base.string() + Tablebase::extension(existing);
+        if (!std::filesystem::exists(existingPath)) {
+            continue;
+        }
+        if (auto table = Tablebase::open(existingPath, rules)) {
+            tableStats.maxDtm = table->getMaxDtm();
+            tableStats.reused = true;
+            solved[material.key()] = Solved{table, table->getMaxDtm()};
+            stats.push_back(tableStats);
+            return true;
+        }
+    }
+    std::string path = base.string() + Tablebase::extension(format);
+
+    TablebaseIndexer indexer(rules, material);
+    std::uint64_t size = indexer.size();
+    if (size > kMaxPositions) {
+        std::cerr << "Tablebase " << tableStats.material << " has "
+                  << (size == UINT64_MAX ? std::string("over 2^64") : std::to_string(size))
+                  << " positions, more than the " << kMaxPositions << " the generator handles" << std::endl;
+        return false;
+    }
+    auto start = std::chrono::steady_clock::now();
+    auto values = std::make_unique<std::atomic<std::uint8_t>[]>(size);
+
+    std::vector<SubTable> subTables;
+    int maxSubDtm = 0;
+    for (const auto& smaller : next) {
+        const Solved& entry = solved[smaller.key()];
+        subTables.push_back(SubTable{smaller.key(), entry.table.get()});
+        maxSubDtm = std::max(maxSubDtm, entry.maxDtm);
+    }
+    std::uint64_t ownKey = material.key();
+
+    // Dtm of the position after a move, for its side to move; -1 if it is a
+    // draw or still open, kIllegal if the move left the mover in check
+    auto successorDtm = [&](Worker& worker, bool sameMaterial) -> int {
+        if (sameMaterial) {
+            std::uint8_t value = values[indexer.index(worker.next)].load(std::memory_order_relaxed);
+            if (value == kInvalid) {
+                return kIllegal;
+            }
+            return value == kUnknown || value == kDraw ? -1 : value - 1;
+        }
+        TablebaseMaterial reached;
+        reached.read(rules, worker.next);
+        std::uint64_t key = reached.key();
+        for (const auto& sub : subTables) {
+            if (sub.key == key) {
+                TablebaseProbe probe = sub.table->probe(worker.next);
+                if (probe.wdl == Wdl::Invalid) {
+                    return kIllegal;
+                }
+                return probe.wdl == Wdl::Draw ? -1 : probe.dtm;
+            }
+        }
+        return -1;
+    };
+
+    auto isCapture = [&](const GameState& state, const EngineMove& move) {
+        return move.special() == EngineMove::kEnPassant ||
+               (move.special() != EngineMove::kCastle && state.squares[move.to] != kEmptySquare);
+    };
+
+    std::uint64_t chunks = (size + kChunkSize - 1) / kChunkSize;
+    auto sweep = [&](int iteration) {
+        for (auto& worker : workers) {
+            worker->changed = 0;
+        }
+        pool.parallelFor(static_cast<std::size_t>(chunks), [&](unsigned workerIndex, std::size_t chunk) {
+            Worker& worker = *workers[workerIndex];
+            std::uint64_t end = std::min<std::uint64_t>(size, (chunk + 1) * kChunkSize);
+            for (std::uint64_t index = chunk * kChunkSize; index < end; ++index) {
+                if (iteration > 0 && values[index].load(std::memory_order_relaxed) != kUnknown) {
+                    continue;
+                }
+                GameState& state = worker.state;
+                if (!indexer.decode(index, state)) {
+                    values[index].store(kInvalid, std::memory_order_relaxed);
+                    continue;
+                }
+                if (iteration == 0) {
+                    // The side that just moved may not be in check
+                    Color mover = state.sideToMove;
+                    worker.attacks.build(state);
+                    if (worker.attacks.isInCheck(mover == Color::WHITE ? Color::BLACK : Color::WHITE)) {
+                        values[index].store(kInvalid, std::memory_order_relaxed);
+                    } else if (!generator.hasLegalMove(state, worker.attacks)) {
+                        values[index].store(worker.attacks.isInCheck(mover) ? 1 : kDraw, std::memory_order_relaxed);
+                    }
+                    continue;
+                }
+
+                // Pseudo-legal moves suffice from here on: a move that leaves
+                // the mover in check reaches a position marked invalid
+                generator.generate(state, worker.moves);
+                int bestLoss = -1;      // Quickest loss the mover can force on the opponent
+                int longestWin = -1;    // Slowest win left to the opponent
+                bool allWins = true;
+                for (const EngineMove& move : worker.moves) {
+                    bool sameMaterial = !isCapture(state, move) && !move.isPromotion();
+                    worker.next = state;
+                    generator.makeMove(worker.next, move);
+                    int dtm = successorDtm(worker, sameMaterial);
+                    if (dtm == kIllegal) {
+                        continue;
+                    }
+                    if (dtm >= 0 && dtm % 2 == 0) {
+                        bestLoss = bestLoss < 0 ? dtm : std::min(bestLoss, dtm);
+                        allWins = false;
+                    } else if (dtm >= 0) {
+                        longestWin = std::max(longestWin, dtm);
+                    } else {
+                        allWins = false;
+                    }
+                }
+
+                // Only values settled before this sweep (dtm < iteration) count
+                if (bestLoss >= 0 && bestLoss + 1 <= iteration) {
+                    values[index].store(static_cast<std::uint8_t>(bestLoss + 2), std::memory_order_relaxed);
+                    worker.changed++;
+                } else if (allWins && longestWin + 1 <= iteration) {
+                    values[index].store(static_cast<std::uint8_t>(longestWin + 2), std::memory_order_relaxed);
+                    worker.changed++;
+                }
+            }
+        });
+        std::uint64_t changed = 0;
+        for (const auto& worker : workers) {
+            changed += worker->changed;
+        }
+        return changed;
+    };
+
+    sweep(0);
+    int iteration = 1;
+    for (; iteration <= kMaxDtm; ++iteration) {
+        if (sweep(iteration) == 0 && iteration > maxSubDtm + 1) {
+            break;
+        }
+    }
+    if (iteration > kMaxDtm) {
+        std::cerr << "Tablebase " << tableStats.material << " has mates longer than " << kMaxDtm
+                  << " plies; those positions are stored as draws" << std::endl;
+    }
+    tableStats.sweeps = iteration;
+
+    // Settle open positions as draws and count the results
+    std::vector<std::uint8_t> result(size);
+    for (std::uint64_t index = 0; index < size; ++index) {
+        std::uint8_t value = values[index].load(std::memory_order_relaxed);
+        if (value == kInvalid) {
+            result[index] = Tablebase::kInvalidValue;
+            continue;
+        }
+        tableStats.positions++;
+        if (value == kUnknown || value == kDraw) {
+            result[index] = Tablebase::kDrawValue;
+            tableStats.draws++;
+            continue;
+        }
+        int plies = value - 1;
+        result[index] = value;
+        (plies % 2 == 1 ? tableStats.wins : tableStats.losses)++;
+        tableStats.maxDtm = std::max(tableStats.maxDtm, plies);
+    }
+    values.reset();
+
+    if (!Tablebase::write(path, rules, material, size, result.data(), tableStats.maxDtm, format)) {
+        return false;
+    }
+    auto table = Tablebase::open(path, rules);
+    if (!table) {
+        return false;
+    }
+    tableStats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    solved[ownKey] = Solved{table, tableStats.maxDtm};
+    stats.push_back(tableStats);
+    return true;
+}
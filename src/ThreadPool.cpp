@@ -0,0 +1,66 @@
+#include "../include/ThreadPool.hpp"
+#include <algorithm>
+
+ThreadPool::ThreadPool(unsigned threads) {
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    workers.reserve(threads);
+    for (unsigned i = 0; i < threads; ++i) {
+        workers.emplace_back(&ThreadPool::workerLoop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+void ThreadPool::parallelFor(std::size_t itemCount, const Task& batchTask) {
+    if (itemCount == 0) {
+        return;
+    }
+    std::unique_lock<std::mutex> lock(mutex);
+    task = &batchTask;
+    count = itemCount;
+    next.store(0, std::memory_order_relaxed);
+    busy = static_cast<unsigned>(workers.size());
+    ++generation;
+    wake.notify_all();
+    finished.wait(lock, [this] { return busy == 0; });
+    task = nullptr;
+}
+
+void ThreadPool::workerLoop(unsigned worker) {
+    std::size_t seen = 0;
+    for (;;) {
+        const Task* current;
+        std::size_t total;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [&] { return stopping || generation != seen; });
+            if (stopping) {
+                return;
+            }
+            seen = generation;
+            current = task;
+            total = count;
+        }
+
+        for (std::size_t index = next.fetch_add(1, std::memory_order_relaxed); index < total;
+             index = next.fetch_add(1, std::memory_order_relaxed)) {
+            (*current)(worker, index);
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (--busy == 0) {
+            finished.notify_one();
+        }
+    }
+}
@@ -1,3 +1,4 @@
+#include "../include/ConfigImage.hpp"
 #include "../include/ConfigReader.hpp"
 #include "../include/GameManager.hpp"
 #include <iostream>
@@ -78,8 +79,11 @@ int main(int argc, char *argv[]) {
 
   ConfigReader configReader;
 
-  // Load the configuration
-  if (!configReader.loadFromFile(configPath)) {
+  // Load the configuration (JSON or a precompiled image)
+  bool loaded = ConfigImage::isImageFile(configPath)
+                    ? configReader.loadFromImage(configPath)
+                    : configReader.loadFromFile(configPath);
+  if (!loaded) {
     std::cerr << "Failed to load configuration. Exiting." << std::endl;
     return 1;
   }
@@ -130,7 +134,7 @@ int main(int argc, char *argv[]) {
   }
 
   // Create and Initialize GameManager
-  GameManager gameManager(config);
+  GameManager gameManager(config, configReader.getRuleSet());
   gameManager.initializeGame();
 
   // Display the initial board state via GameManager
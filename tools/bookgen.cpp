@@ -0,0 +1,81 @@
+// Builds an opening book for a variant from self-play logs.
+//
+// Usage: bookgen [-p plies] [-g min-games] [-o book] <config.json> <selfplay.log>...
+//   -p  plies of each game to record (default 20)
+//   -g  leave out moves played in fewer games (default 2)
+//   -o  output file (default book.bin)
+// Each move is weighted by how it scored for the side that played it: two
+// points per win, one per draw. The logs must come from the same config.
+#include "../include/ConfigCache.hpp"
+#include "../include/OpeningBook.hpp"
+#include "../include/SelfPlay.hpp"
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <vector>
+
+int main(int argc, char* argv[]) {
+    int plies = 20;
+    int minGames = 2;
+    std::string outputPath = "book.bin";
+    std::vector<std::string> inputs;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "-p" && hasValue) {
+            plies = std::stoi(argv[++i]);
+        } else if (arg == "-g" && hasValue) {
+            minGames = std::stoi(argv[++i]);
+        } else if (arg == "-o" && hasValue) {
+            outputPath = argv[++i];
+        } else {
+            inputs.push_back(arg);
+        }
+    }
+    if (inputs.size() < 2) {
+        std::cerr << "Usage: " << argv[0] << " [-p plies] [-g min-games] [-o book] <config.json> <selfplay.log>..."
+                  << std::endl;
+        return 2;
+    }
+
+    auto variant = ConfigCache::instance().getFile(inputs[0]);
+    if (!variant) {
+        std::cerr << "Failed to load configuration. Exiting." << std::endl;
+        return 1;
+    }
+    if (!variant->rules) {
+        std::cerr << "Configuration exceeds the move generator's limits: " << inputs[0] << std::endl;
+        return 1;
+    }
+
+    OpeningBookBuilder builder(*variant->rules, plies);
+    std::vector<SelfPlayGame> games;
+    std::size_t skipped = 0;
+    for (std::size_t i = 1; i < inputs.size(); ++i) {
+        std::uint64_t configHash = 0;
+        if (!SelfPlayLog::read(inputs[i], configHash, games)) {
+            return 1;
+        }
+        if (configHash != variant->contentHash) {
+            std::cerr << "Log was played with another config: " << inputs[i] << std::endl;
+            return 1;
+        }
+        for (const auto& game : games) {
+            if (!builder.addGame(game)) {
+                ++skipped;
+            }
+        }
+    }
+    if (!builder.write(outputPath, minGames)) {
+        return 1;
+    }
+
+    auto book = OpeningBook::open(outputPath, *variant->rules);
+    if (!book) {
+        return 1;
+    }
+    std::printf("%zu games (%zu skipped), %zu positions seen, %zu book moves written to %s\n",
+                builder.getGameCount(), skipped, builder.getPositionCount(), book->getEntryCount(),
+                outputPath.c_str());
+    return 0;
+}
@@ -0,0 +1,42 @@
+// Compiles a JSON config into a binary config image that ConfigReader and
+// chess_game can load without parsing JSON or building rule tables.
+//
+// Usage: compile_config <config.json> <output.img>
+#include "../include/ConfigImage.hpp"
+#include "../include/ConfigReader.hpp"
+#include "../include/RuleSet.hpp"
+#include <iostream>
+#include <string>
+
+int main(int argc, char* argv[]) {
+    if (argc != 3) {
+        std::cerr << "Usage: " << argv[0] << " <config.json> <output.img>" << std::endl;
+        return 2;
+    }
+    std::string inputPath = argv[1];
+    std::string outputPath = argv[2];
+
+    ConfigReader configReader;
+    if (!configReader.loadFromFile(inputPath)) {
+        std::cerr << "Invalid configuration: " << inputPath << std::endl;
+        return 1;
+    }
+    const GameConfig& config = configReader.getConfig();
+    auto rules = RuleSet::compile(config);
+    if (!rules) {
+        std::cerr << "Configuration exceeds the rule table limits: " << inputPath << std::endl;
+        return 1;
+    }
+    if (!ConfigImage::write(outputPath, config, *rules)) {
+        return 1;
+    }
+
+    // Read the image back so a bad write is caught here, not in a worker
+    auto image = ConfigImage::open(outputPath);
+    if (!image) {
+        return 1;
+    }
+    std::cout << "Wrote " << outputPath << " (" << image->getSize() << " bytes, format version "
+              << ConfigImage::kVersion << ")" << std::endl;
+    return 0;
+}
@@ -0,0 +1,72 @@
+// Hosts games of one variant for clients speaking the GameServer line
+// protocol, until interrupted.
+//
+// Usage: game_server [-j shards] [-s socket-path] [-p port] [config.json]
+//   -j  number of shard threads (default: one per hardware thread)
+//   -s  Unix socket to listen on (default: /tmp/chess_server.sock)
+//   -p  also listen on this TCP port of the loopback interface
+#include "../include/ConfigCache.hpp"
+#include "../include/GameServer.hpp"
+#include <csignal>
+#include <iostream>
+#include <string>
+
+namespace {
+    GameServer* g_server = nullptr;
+
+    void handleSignal(int) {
+        if (g_server) {
+            g_server->stop();
+        }
+    }
+}
+
+int main(int argc, char* argv[]) {
+    unsigned shards = 0;
+    std::string socketPath = "/tmp/chess_server.sock";
+    int port = 0;
+    std::string configPath = "data/chess_pieces.json";
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "-j" && i + 1 < argc) {
+            shards = static_cast<unsigned>(std::stoul(argv[++i]));
+        } else if (arg == "-s" && i + 1 < argc) {
+            socketPath = argv[++i];
+        } else if (arg == "-p" && i + 1 < argc) {
+            port = std::stoi(argv[++i]);
+        } else if (!arg.empty() && arg[0] == '-') {
+            std::cerr << "Usage: " << argv[0] << " [-j shards] [-s socket-path] [-p port] [config.json]" << std::endl;
+            return 2;
+        } else {
+            configPath = arg;
+        }
+    }
+
+    auto variant = ConfigCache::instance().getFile(configPath);
+    if (!variant) {
+        std::cerr << "Failed to load configuration. Exiting." << std::endl;
+        return 1;
+    }
+    if (!variant->rules) {
+        std::cerr << "Configuration exceeds the move generator's limits: " << configPath << std::endl;
+        return 1;
+    }
+
+    GameServer server(variant, shards);
+    if (!server.listenUnix(socketPath) || (port > 0 && !server.listenTcp(port))) {
+        return 1;
+    }
+    g_server = &server;
+    std::signal(SIGINT, handleSignal);
+    std::signal(SIGTERM, handleSignal);
+
+    std::cout << "Serving " << variant->config.game_settings.name << " on " << socketPath;
+    if (port > 0) {
+        std::cout << " and 127.0.0.1:" << port;
+    }
+    std::cout << " with " << server.getShardCount() << " shards" << std::endl;
+    server.run();
+    g_server = nullptr;
+    std::cout << "Stopped with " << server.getGameCount() << " games open" << std::endl;
+    return 0;
+}
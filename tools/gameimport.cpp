@@ -0,0 +1,78 @@
+// Imports PGN-style text game files into a compact game archive.
+//
+// Usage: gameimport [-j threads] [-c chunk-kb] [-o archive] <config.json> <games.pgn>...
+//   -j  number of parsing threads (default: one per hardware thread)
+//   -c  size of the chunks the files are read and parsed in (default 1024 kB);
+//       memory use is about two chunks per thread
+//   -o  archive to create or append to (default games.bin)
+// Moves are standard algebraic notation with portal moves written through
+// the portal's entry square ("Bc4>f7"), see SanNotation.hpp.
+#include "../include/ConfigCache.hpp"
+#include "../include/GameImport.hpp"
+#include "../include/GameRecord.hpp"
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <vector>
+
+int main(int argc, char* argv[]) {
+    unsigned threads = 0;
+    std::size_t chunkSize = GameImporter::kDefaultChunkSize;
+    std::string outputPath = "games.bin";
+    std::vector<std::string> inputs;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "-j" && hasValue) {
+            threads = static_cast<unsigned>(std::stoul(argv[++i]));
+        } else if (arg == "-c" && hasValue) {
+            chunkSize = std::stoul(argv[++i]) * 1024;
+        } else if (arg == "-o" && hasValue) {
+            outputPath = argv[++i];
+        } else {
+            inputs.push_back(arg);
+        }
+    }
+    if (inputs.size() < 2) {
+        std::cerr << "Usage: " << argv[0] << " [-j threads] [-c chunk-kb] [-o archive] <config.json> <games.pgn>..."
+                  << std::endl;
+        return 2;
+    }
+
+    auto variant = ConfigCache::instance().getFile(inputs[0]);
+    if (!variant) {
+        std::cerr << "Failed to load configuration. Exiting." << std::endl;
+        return 1;
+    }
+    if (!variant->rules) {
+        std::cerr << "Configuration exceeds the move generator's limits: " << inputs[0] << std::endl;
+        return 1;
+    }
+
+    GameRecordWriter archive(*variant->rules);
+    if (!archive.open(outputPath, variant->contentHash)) {
+        return 1;
+    }
+    GameImporter importer(*variant->rules, threads, chunkSize);
+    GameImportStats stats;
+    for (std::size_t i = 1; i < inputs.size(); ++i) {
+        if (!importer.import(inputs[i], archive, stats)) {
+            archive.close();
+            return 1;
+        }
+    }
+    if (!archive.close()) {
+        std::cerr << "Failed to write game archive: " << outputPath << std::endl;
+        return 1;
+    }
+
+    double megabytes = static_cast<double>(stats.bytes) / (1 << 20);
+    std::printf("%llu games (%llu skipped), %llu moves from %.1f MB in %.2f s on %u threads: %.1f MB/s, "
+                "%.0f moves/s\n",
+                static_cast<unsigned long long>(stats.games), static_cast<unsigned long long>(stats.skipped),
+                static_cast<unsigned long long>(stats.moves), megabytes, stats.seconds, importer.getThreadCount(),
+                megabytes / stats.seconds, static_cast<double>(stats.moves) / stats.seconds);
+    std::printf("Archive %s now holds %llu games\n", outputPath.c_str(),
+                static_cast<unsigned long long>(archive.getGameCount()));
+    return 0;
+}
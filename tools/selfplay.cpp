@@ -0,0 +1,153 @@
+// Plays engine-vs-engine games in parallel and reports throughput: games per
+// hour overall and search nodes per second for every worker.
+//
+// Usage: selfplay [-j threads] [-n games] [-e ab|mcts] [-N nodes] [-d depth] [-P playouts]
+//                 [-r random-plies] [-m max-plies] [-S seed] [-o log] [-g archive] [-t tablebases]
+//                 [-b book] [config.json]
+//   -j  number of worker threads (default: one per hardware thread)
+//   -n  number of games (default 100)
+//   -e  engine: alpha-beta search (default) or Monte Carlo tree search
+//   -N  alpha-beta search nodes per move (default 20000)
+//   -d  maximum alpha-beta search depth per move (default 32)
+//   -P  MCTS playouts per move (default 10000)
+//   -r  random opening plies per game (default 4)
+//   -m  plies after which a game is drawn (default: the config's turn limit, or 500)
+//   -S  seed; game i always plays the same with the same seed
+//   -o  write every game (moves, outcome, length) to this binary log
+//   -g  append every game to this compact game archive (see GameRecord.hpp)
+//   -t  probe the tablebases in this directory during alpha-beta search
+//   -b  play moves from this opening book (see bookgen) after the random plies
+#include "../include/ConfigCache.hpp"
+#include "../include/GameRecord.hpp"
+#include "../include/OpeningBook.hpp"
+#include "../include/SelfPlay.hpp"
+#include <cstdio>
+#include <iostream>
+#include <string>
+
+int main(int argc, char* argv[]) {
+    unsigned threads = 0;
+    SelfPlayOptions options;
+    std::string logPath;
+    std::string tablebasePath;
+    std::string bookPath;
+    std::string archivePath;
+    std::string configPath = "data/chess_pieces.json";
+    const std::string engineAb = "ab";
+    const std::string engineMcts = "mcts";
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "-j" && hasValue) {
+            threads = static_cast<unsigned>(std::stoul(argv[++i]));
+        } else if (arg == "-n" && hasValue) {
+            options.games = std::stoi(argv[++i]);
+        } else if (arg == "-e" && hasValue && (argv[i + 1] == engineAb || argv[i + 1] == engineMcts)) {
+            options.engine = argv[++i] == engineMcts ? SelfPlayEngine::Mcts : SelfPlayEngine::AlphaBeta;
+        } else if (arg == "-P" && hasValue) {
+            options.mcts.playouts = std::stoull(argv[++i]);
+        } else if (arg == "-N" && hasValue) {
+            options.limits.nodes = std::stoull(argv[++i]);
+        } else if (arg == "-d" && hasValue) {
+            options.limits.depth = std::stoi(argv[++i]);
+        } else if (arg == "-r" && hasValue) {
+            options.randomPlies = std::stoi(argv[++i]);
+        } else if (arg == "-m" && hasValue) {
+            options.maxPlies = std::stoi(argv[++i]);
+        } else if (arg == "-S" && hasValue) {
+            options.seed = std::stoull(argv[++i]);
+        } else if (arg == "-o" && hasValue) {
+            logPath = argv[++i];
+        } else if (arg == "-t" && hasValue) {
+            tablebasePath = argv[++i];
+        } else if (arg == "-g" && hasValue) {
+            archivePath = argv[++i];
+        } else if (arg == "-b" && hasValue) {
+            bookPath = argv[++i];
+        } else if (!arg.empty() && arg[0] == '-') {
+            std::cerr << "Usage: " << argv[0]
+                      << " [-j threads] [-n games] [-e ab|mcts] [-N nodes] [-d depth] [-P playouts]"
+                         " [-r random-plies] [-m max-plies] [-S seed] [-o log] [-g archive] [-t tablebases]"
+                         " [-b book] [config.json]"
+                      << std::endl;
+            return 2;
+        } else {
+            configPath = arg;
+        }
+    }
+
+    auto variant = ConfigCache::instance().getFile(configPath);
+    if (!variant) {
+        std::cerr << "Failed to load configuration. Exiting." << std::endl;
+        return 1;
+    }
+    if (!variant->rules) {
+        std::cerr << "Configuration exceeds the move generator's limits: " << configPath << std::endl;
+        return 1;
+    }
+
+    TablebaseSet tablebases(*variant->rules);
+    if (!tablebasePath.empty()) {
+        std::printf("%d tablebases loaded from %s\n", tablebases.loadDirectory(tablebasePath),
+                    tablebasePath.c_str());
+        options.tablebases = &tablebases;
+    }
+
+    std::shared_ptr<const OpeningBook> book;
+    if (!bookPath.empty()) {
+        book = OpeningBook::open(bookPath, *variant->rules);
+        if (!book) {
+            return 1;
+        }
+        options.book = book.get();
+    }
+
+    SelfPlayLog log;
+    if (!logPath.empty() && !log.create(logPath, variant->contentHash)) {
+        return 1;
+    }
+
+    GameRecordWriter archive(*variant->rules);
+    if (!archivePath.empty() && !archive.open(archivePath, variant->contentHash)) {
+        return 1;
+    }
+
+    SelfPlayRunner runner(variant, threads);
+    SelfPlayReport report = runner.run(options, logPath.empty() ? nullptr : &log,
+                                       archivePath.empty() ? nullptr : &archive);
+    if (!logPath.empty() && !log.close()) {
+        std::cerr << "Failed to write self-play log: " << logPath << std::endl;
+        return 1;
+    }
+    if (!archivePath.empty() && !archive.close()) {
+        std::cerr << "Failed to write game archive: " << archivePath << std::endl;
+        return 1;
+    }
+
+    std::printf("%zu games on %u threads in %.2f s: %.0f games/hour\n", report.games, runner.getThreadCount(),
+                report.seconds, report.gamesPerHour());
+    std::printf("White %zu  Black %zu  Stalemate %zu  Turn limit %zu  Average length %.1f plies\n",
+                report.outcomes[static_cast<int>(SelfPlayOutcome::WhiteWin)],
+                report.outcomes[static_cast<int>(SelfPlayOutcome::BlackWin)],
+                report.outcomes[static_cast<int>(SelfPlayOutcome::Stalemate)],
+                report.outcomes[static_cast<int>(SelfPlayOutcome::TurnLimit)], report.averagePlies());
+    const char* unit = options.engine == SelfPlayEngine::Mcts ? "playouts" : "nodes";
+    for (std::size_t i = 0; i < report.workers.size(); ++i) {
+        const auto& worker = report.workers[i];
+        std::printf("  worker %2zu: %4zu games %7llu plies %10.0f %s/s\n", i, worker.games,
+                    static_cast<unsigned long long>(worker.plies), worker.nodesPerSecond(), unit);
+    }
+    std::printf("Total %.0f %s/s\n", report.seconds > 0 ? report.nodes / report.seconds : 0.0, unit);
+    if (book) {
+        std::printf("%llu book moves (%.1f per game)\n", static_cast<unsigned long long>(report.bookMoves),
+                    report.games > 0 ? static_cast<double>(report.bookMoves) / report.games : 0.0);
+    }
+    if (!logPath.empty()) {
+        std::printf("Log written to %s\n", logPath.c_str());
+    }
+    if (!archivePath.empty()) {
+        std::printf("Archive %s now holds %llu games\n", archivePath.c_str(),
+                    static_cast<unsigned long long>(archive.getGameCount()));
+    }
+    return 0;
+}
@@ -0,0 +1,73 @@
+// Generates endgame tablebases for a variant: every material given and every
+// smaller material it can turn into, one file each.
+//
+// Usage: tbgen [-j threads] [-o directory] [-z] <config.json> <material>...
+//   -j  number of worker threads (default: one per hardware thread)
+//   -o  output directory (default: tablebases)
+//   -z  write compressed tables (.tbz) instead of plain ones (.tbw)
+// A material lists the white piece letters, 'v', then the black ones, with
+// the letters the variant assigns to its pieces: KQvK, KRvKN, KPvK.
+#include "../include/ConfigCache.hpp"
+#include "../include/TablebaseGenerator.hpp"
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <vector>
+
+int main(int argc, char* argv[]) {
+    unsigned threads = 0;
+    std::string directory = "tablebases";
+    TablebaseFormat format = TablebaseFormat::Plain;
+    std::vector<std::string> inputs;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "-j" && i + 1 < argc) {
+            threads = static_cast<unsigned>(std::stoul(argv[++i]));
+        } else if (arg == "-o" && i + 1 < argc) {
+            directory = argv[++i];
+        } else if (arg == "-z") {
+            format = TablebaseFormat::Compressed;
+        } else {
+            inputs.push_back(arg);
+        }
+    }
+    if (inputs.size() < 2) {
+        std::cerr << "Usage: " << argv[0] << " [-j threads] [-o directory] [-z] <config.json> <material>..."
+                  << std::endl;
+        return 2;
+    }
+
+    auto variant = ConfigCache::instance().getFile(inputs[0]);
+    if (!variant) {
+        std::cerr << "Failed to load configuration. Exiting." << std::endl;
+        return 1;
+    }
+    if (!variant->rules) {
+        std::cerr << "Configuration exceeds the move generator's limits: " << inputs[0] << std::endl;
+        return 1;
+    }
+    const RuleSet& rules = *variant->rules;
+
+    TablebaseGenerator generator(rules, threads, format);
+    for (std::size_t i = 1; i < inputs.size(); ++i) {
+        TablebaseMaterial material;
+        if (!material.parse(rules, inputs[i]) || !generator.generate(material, directory)) {
+            return 1;
+        }
+    }
+
+    std::printf("%-10s %12s %12s %12s %12s %7s %7s %9s\n", "material", "positions", "wins", "losses", "draws",
+                "max dtm", "sweeps", "seconds");
+    for (const auto& table : generator.getStats()) {
+        if (table.reused) {
+            std::printf("%-10s (already in %s, max dtm %d)\n", table.material.c_str(), directory.c_str(),
+                        table.maxDtm);
+            continue;
+        }
+        std::printf("%-10s %12llu %12llu %12llu %12llu %7d %7d %9.2f\n", table.material.c_str(),
+                    static_cast<unsigned long long>(table.positions), static_cast<unsigned long long>(table.wins),
+                    static_cast<unsigned long long>(table.losses), static_cast<unsigned long long>(table.draws),
+                    table.maxDtm, table.sweeps, table.seconds);
+    }
+    return 0;
+}
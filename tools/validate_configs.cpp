@@ -0,0 +1,74 @@
+// Loads and validates config files in parallel and reports every invalid file
+// with its errors, followed by throughput.
+//
+// Usage: validate_configs [-j threads] [-q] <directory|file.json>...
+//   -j  number of worker threads (default: one per hardware thread)
+//   -q  only print the summary
+#include "../include/ConfigBatchValidator.hpp"
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+
+int main(int argc, char* argv[]) {
+    unsigned threads = 0;
+    bool quiet = false;
+    std::vector<std::string> inputs;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "-j" && i + 1 < argc) {
+            threads = static_cast<unsigned>(std::stoul(argv[++i]));
+        } else if (arg == "-q") {
+            quiet = true;
+        } else {
+            inputs.push_back(arg);
+        }
+    }
+    if (inputs.empty()) {
+        std::cerr << "Usage: " << argv[0] << " [-j threads] [-q] <directory|file.json>..." << std::endl;
+        return 2;
+    }
+
+    ConfigBatchValidator validator(threads);
+    ConfigBatchReport total;
+    std::vector<std::string> files;
+    auto merge = [&](ConfigBatchReport report) {
+        for (auto& result : report.results) {
+            total.results.push_back(std::move(result));
+        }
+        total.validCount += report.validCount;
+        total.invalidCount += report.invalidCount;
+        total.totalBytes += report.totalBytes;
+        total.seconds += report.seconds;
+    };
+    for (const auto& input : inputs) {
+        if (std::filesystem::is_directory(input)) {
+            merge(validator.validateDirectory(input));
+        } else {
+            files.push_back(input);
+        }
+    }
+    merge(validator.validateFiles(files));
+
+    if (!quiet) {
+        for (const auto& result : total.results) {
+            if (!result.valid) {
+                std::cout << "INVALID " << result.path << "\n";
+                std::string::size_type start = 0;
+                while (start < result.errors.size()) {
+                    auto end = result.errors.find('\n', start);
+                    if (end == std::string::npos) end = result.errors.size();
+                    std::cout << "    " << result.errors.substr(start, end - start) << "\n";
+                    start = end + 1;
+                }
+            }
+        }
+    }
+
+    std::printf("%zu files: %zu valid, %zu invalid\n", total.results.size(), total.validCount,
+                total.invalidCount);
+    std::printf("%.1f ms on %u threads, %.0f files/s, %.1f MB/s\n", total.seconds * 1000,
+                validator.getThreadCount(), total.filesPerSecond(), total.megabytesPerSecond());
+    return total.invalidCount == 0 ? 0 : 1;
+}